@@ -0,0 +1,307 @@
+/**
+ * Copyright 2024 https://github.com/i80287
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "StringMap.hpp"
+
+#if !defined(__GNUC__) && !defined(__clang__) && !defined(_MSC_VER)
+#error "EnumStringMap.hpp needs __PRETTY_FUNCTION__ or __FUNCSIG__"
+#endif
+
+enum class EnumNameCase {
+    // Names as written in the enum
+    kAsIs,
+    // "TEXTONE" -> "textone", underscores are kept
+    kLower,
+    // "textOne" -> "TEXTONE", underscores are kept
+    kUpper,
+    // "TextOne", "TEXT_ONE", "textOne" -> "text_one"
+    kSnake,
+    // "TextOne", "text_one" -> "TEXT_ONE"
+    kUpperSnake,
+    // "TextOne", "TEXT_ONE" -> "text-one"
+    kKebab,
+};
+
+namespace enum_string_map_detail {
+
+template <auto Value>
+[[nodiscard]] consteval std::string_view FunctionSignature() noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+    return __PRETTY_FUNCTION__;
+#else
+    return __FUNCSIG__;
+#endif
+}
+
+/**
+ * Name of the enumerator Value without the qualification, empty if Value
+ *  is not a named enumerator (compilers print it as the cast, e.g. "(Color)5").
+ */
+template <auto Value>
+[[nodiscard]] consteval std::string_view EnumeratorName() noexcept {
+    const std::string_view signature = FunctionSignature<Value>();
+#if defined(__GNUC__) || defined(__clang__)
+    // "... [with auto Value = Color::kRed; ...]" (GCC), "... [Value = Color::kRed]" (Clang)
+    constexpr std::string_view kValueMarker = "Value = ";
+    const std::size_t begin = signature.find(kValueMarker) + kValueMarker.size();
+    const std::size_t end   = signature.find_first_of(";]", begin);
+#else
+    // "... FunctionSignature<Color::kRed>(void) noexcept"
+    const std::size_t begin = signature.find("FunctionSignature<") +
+                              std::string_view("FunctionSignature<").size();
+    const std::size_t end   = signature.rfind(">(");
+#endif
+    std::string_view name = signature.substr(begin, end - begin);
+    if (name.empty() || name.front() == '(' || ('0' <= name.front() && name.front() <= '9') ||
+        name.front() == '-') {
+        return {};
+    }
+    const std::size_t scope_end = name.rfind("::");
+    if (scope_end != std::string_view::npos) {
+        name.remove_prefix(scope_end + 2);
+    }
+    return name;
+}
+
+[[nodiscard]] consteval bool IsLower(char chr) noexcept {
+    return 'a' <= chr && chr <= 'z';
+}
+[[nodiscard]] consteval bool IsUpper(char chr) noexcept {
+    return 'A' <= chr && chr <= 'Z';
+}
+[[nodiscard]] consteval bool IsDigit(char chr) noexcept {
+    return '0' <= chr && chr <= '9';
+}
+[[nodiscard]] consteval char ToLower(char chr) noexcept {
+    return IsUpper(chr) ? static_cast<char>(chr - 'A' + 'a') : chr;
+}
+[[nodiscard]] consteval char ToUpper(char chr) noexcept {
+    return IsLower(chr) ? static_cast<char>(chr - 'a' + 'A') : chr;
+}
+
+/**
+ * Writes the name in the Case to the out (if it is not nullptr) and returns its length.
+ * Words are split at the underscores, before the upper case letter which follows the lower
+ *  case letter or the digit and before the last upper case letter of the run followed by the
+ *  lower case one ("HTTPServer" -> "http_server").
+ */
+[[nodiscard]] consteval std::size_t ConvertName(std::string_view name, EnumNameCase name_case,
+                                                char* out) noexcept {
+    std::size_t length = 0;
+    const auto put     = [&](char chr) constexpr noexcept {
+        if (out != nullptr) {
+            out[length] = chr;
+        }
+        length++;
+    };
+
+    switch (name_case) {
+        case EnumNameCase::kAsIs:
+        case EnumNameCase::kLower:
+        case EnumNameCase::kUpper:
+            for (const char chr : name) {
+                put(name_case == EnumNameCase::kLower   ? ToLower(chr)
+                    : name_case == EnumNameCase::kUpper ? ToUpper(chr)
+                                                        : chr);
+            }
+            return length;
+        case EnumNameCase::kSnake:
+        case EnumNameCase::kUpperSnake:
+        case EnumNameCase::kKebab:
+        default:
+            break;
+    }
+
+    const char separator = name_case == EnumNameCase::kKebab ? '-' : '_';
+    bool word_started    = false;
+    for (std::size_t i = 0; i < name.size(); i++) {
+        const char chr = name[i];
+        if (chr == '_') {
+            word_started = false;
+            continue;
+        }
+        const bool starts_word =
+            IsUpper(chr) && i > 0 &&
+            (IsLower(name[i - 1]) || IsDigit(name[i - 1]) ||
+             (IsUpper(name[i - 1]) && i + 1 < name.size() && IsLower(name[i + 1])));
+        if (length > 0 && (!word_started || starts_word)) {
+            put(separator);
+        }
+        put(name_case == EnumNameCase::kUpperSnake ? ToUpper(chr) : ToLower(chr));
+        word_started = true;
+    }
+    return length;
+}
+
+}  // namespace enum_string_map_detail
+
+/**
+ * Names of the enumerators of the Enum with the underlying values in [MinValue, MaxValue]
+ *  extracted at compile time from __PRETTY_FUNCTION__ (__FUNCSIG__), with the StripPrefix
+ *  removed and converted to the NameCase. parse() is the StringMatch over the names,
+ *  name() is the direct index (or binary search for the sparse enums).
+ *
+ * Enum should be a scoped enum or have the fixed underlying type: values in the range
+ *  which are not enumerators are cast to the Enum in the constant expressions.
+ * Enumerators with the same value get the name of the first one.
+ */
+template <class Enum, EnumNameCase NameCase = EnumNameCase::kAsIs,
+          string_map_detail::CompileTimeStringLiteral StripPrefix = "", auto MinValue = 0,
+          auto MaxValue = 127>
+    requires(std::is_enum_v<Enum> && MinValue <= MaxValue)
+class [[nodiscard]] EnumStringMap final {
+    using Underlying = std::underlying_type_t<Enum>;
+
+    static constexpr std::size_t kRangeSize = static_cast<std::size_t>(MaxValue - MinValue) + 1;
+
+    template <std::size_t... Indexes>
+    static consteval std::array<std::string_view, kRangeSize> RawNames(
+        std::index_sequence<Indexes...>) noexcept {
+        return {enum_string_map_detail::EnumeratorName<static_cast<Enum>(
+            static_cast<Underlying>(MinValue + static_cast<decltype(MinValue)>(Indexes)))>()...};
+    }
+    static constexpr std::array<std::string_view, kRangeSize> kRawNames =
+        RawNames(std::make_index_sequence<kRangeSize>{});
+
+    static consteval std::string_view Stripped(std::string_view name) noexcept {
+        const std::string_view prefix(StripPrefix.value.data(), StripPrefix.length);
+        if (name.size() > prefix.size() && name.starts_with(prefix)) {
+            name.remove_prefix(prefix.size());
+        }
+        return name;
+    }
+
+    static consteval std::size_t Count() noexcept {
+        std::size_t count = 0;
+        for (const std::string_view name : kRawNames) {
+            count += !name.empty();
+        }
+        return count;
+    }
+    static consteval std::size_t TotalLength() noexcept {
+        std::size_t length = 0;
+        for (const std::string_view name : kRawNames) {
+            length += enum_string_map_detail::ConvertName(Stripped(name), NameCase, nullptr);
+        }
+        return length;
+    }
+
+public:
+    static constexpr std::size_t kCount = Count();
+    static_assert(kCount > 0, "No enumerators in [MinValue, MaxValue]");
+
+private:
+    static constexpr std::size_t kTotalLength = TotalLength();
+
+    static consteval std::array<char, kTotalLength> NamesChars() noexcept {
+        std::array<char, kTotalLength> chars{};
+        std::size_t offset = 0;
+        for (const std::string_view name : kRawNames) {
+            offset += enum_string_map_detail::ConvertName(Stripped(name), NameCase,
+                                                          chars.data() + offset);
+        }
+        return chars;
+    }
+    static constexpr std::array<char, kTotalLength> kNamesChars = NamesChars();
+
+    struct Enumerators final {
+        std::array<Enum, kCount> values{};
+        std::array<std::string_view, kCount> names{};
+    };
+    static consteval Enumerators BuildEnumerators() noexcept {
+        Enumerators enumerators{};
+        std::size_t count  = 0;
+        std::size_t offset = 0;
+        for (std::size_t i = 0; i < kRangeSize; i++) {
+            if (kRawNames[i].empty()) {
+                continue;
+            }
+            const std::size_t length =
+                enum_string_map_detail::ConvertName(Stripped(kRawNames[i]), NameCase, nullptr);
+            enumerators.values[count] = static_cast<Enum>(
+                static_cast<Underlying>(MinValue + static_cast<decltype(MinValue)>(i)));
+            enumerators.names[count] = std::string_view(kNamesChars.data() + offset, length);
+            offset += length;
+            count++;
+        }
+        return enumerators;
+    }
+    static constexpr Enumerators kEnumerators = BuildEnumerators();
+
+public:
+    // Enumerators in the increasing order of the values and their names
+    static constexpr std::array<Enum, kCount> kValues = kEnumerators.values;
+    static constexpr std::array<std::string_view, kCount> kNames = kEnumerators.names;
+
+private:
+    template <std::size_t... Indexes>
+    static constexpr auto MakeNamesMatch(std::index_sequence<Indexes...>) noexcept {
+        return StringMatch<kNames[Indexes]...>();
+    }
+
+public:
+    using NamesMatch = decltype(MakeNamesMatch(std::make_index_sequence<kCount>{}));
+
+    // Values are dense, name() is one array access
+    static constexpr bool kIsContiguous =
+        static_cast<Underlying>(kValues.back()) - static_cast<Underlying>(kValues.front()) + 1 ==
+        static_cast<Underlying>(kCount);
+
+    [[nodiscard]] static constexpr std::optional<Enum> parse(std::string_view name) noexcept {
+        const std::size_t index = kNamesMatch(name);
+        if (index == kCount) {
+            return std::nullopt;
+        }
+        return kValues[index];
+    }
+
+    // Name of the enumerator, empty string if the value is not an enumerator
+    [[nodiscard]] static constexpr std::string_view name(Enum value) noexcept {
+        const auto underlying = static_cast<Underlying>(value);
+        if constexpr (kIsContiguous) {
+            const auto first = static_cast<Underlying>(kValues.front());
+            const auto last  = static_cast<Underlying>(kValues.back());
+            if (underlying < first || underlying > last) {
+                return {};
+            }
+            return kNames[static_cast<std::size_t>(underlying - first)];
+        } else {
+            std::size_t left  = 0;
+            std::size_t right = kCount;
+            while (left < right) {
+                const std::size_t middle = left + (right - left) / 2;
+                if (static_cast<Underlying>(kValues[middle]) < underlying) {
+                    left = middle + 1;
+                } else {
+                    right = middle;
+                }
+            }
+            return left < kCount && kValues[left] == value ? kNames[left] : std::string_view{};
+        }
+    }
+
+private:
+    static constexpr NamesMatch kNamesMatch{};
+};
@@ -0,0 +1,301 @@
+/**
+ * Copyright 2024 https://github.com/i80287
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "StringMap.hpp"
+
+/**
+ * Compile time StringMap / StringMatch with the runtime overlay of additional strings.
+ *
+ * Lookup first consults the StaticMap and, if the string is not there, the overlay.
+ * The overlay is an immutable sorted snapshot published through the atomic pointer:
+ *  readers never take locks (one acquire load + binary search), writers are serialized
+ *  by the mutex, copy the current snapshot, modify the copy and publish it atomically.
+ *
+ * Replaced snapshots are not freed immediately because some reader may still use them.
+ *  Readers announce themselves in the striped counters of the current epoch parity and
+ *  every update tries to advance the epoch, which succeeds when the readers of the other
+ *  parity have left. A snapshot is freed by the update which finds the epoch advanced
+ *  twice since the snapshot was replaced, so without long running readers at most
+ *  a few snapshots are alive at any moment.
+ * insert_or_assign_range() and erase_range() apply many changes with one copy of the overlay.
+ */
+template <class StaticMap>
+class [[nodiscard]] HybridStringMap final {
+public:
+    using MappedType = typename StaticMap::MappedType;
+
+    static constexpr MappedType kDefaultValue = StaticMap::kDefaultValue;
+
+    HybridStringMap() : snapshot_(new Snapshot{}) {}
+    HybridStringMap(const HybridStringMap&)            = delete;
+    HybridStringMap& operator=(const HybridStringMap&) = delete;
+    ~HybridStringMap() {
+        delete snapshot_.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] MappedType operator()(std::string_view str) const noexcept {
+        const MappedType static_value = kStaticMap(str);
+        if (static_value != kDefaultValue) [[likely]] {
+            return static_value;
+        }
+        const ReaderGuard guard(*this);
+        return snapshot_.load(std::memory_order_seq_cst)->find(str);
+    }
+    [[nodiscard]] MappedType operator()(const char* str) const noexcept {
+        if (str == nullptr) [[unlikely]] {
+            return kDefaultValue;
+        }
+        return operator()(std::string_view(str));
+    }
+
+    /**
+     * Adds or replaces the runtime string. Returns false (and does nothing)
+     *  if the string is present in the StaticMap because it always takes precedence.
+     * Strings mapped to the kDefaultValue are indistinguishable from the absent ones.
+     */
+    bool insert_or_assign(std::string_view str, MappedType value) {
+        if (kStaticMap(str) != kDefaultValue) {
+            return false;
+        }
+        const std::lock_guard lock(writer_mutex_);
+        auto new_snapshot = std::make_unique<Snapshot>(*snapshot_.load(std::memory_order_relaxed));
+        new_snapshot->insert_or_assign(str, std::move(value));
+        publish(std::move(new_snapshot));
+        return true;
+    }
+
+    /**
+     * insert_or_assign() of every (string, value) pair of the range, published at once.
+     * Returns number of the added or replaced strings.
+     */
+    template <std::ranges::input_range Range>
+    std::size_t insert_or_assign_range(Range&& entries) {
+        const std::lock_guard lock(writer_mutex_);
+        auto new_snapshot = std::make_unique<Snapshot>(*snapshot_.load(std::memory_order_relaxed));
+        std::size_t assigned_count = 0;
+        for (auto&& [str, value] : entries) {
+            const std::string_view key(str);
+            if (kStaticMap(key) == kDefaultValue) {
+                new_snapshot->insert_or_assign(key, static_cast<MappedType>(value));
+                assigned_count++;
+            }
+        }
+        if (assigned_count != 0) {
+            publish(std::move(new_snapshot));
+        }
+        return assigned_count;
+    }
+
+    /**
+     * Removes the runtime string. Returns false if it was not in the overlay.
+     */
+    bool erase(std::string_view str) {
+        const std::lock_guard lock(writer_mutex_);
+        const Snapshot& current_snapshot = *snapshot_.load(std::memory_order_relaxed);
+        if (current_snapshot.find(str) == kDefaultValue) {
+            return false;
+        }
+        auto new_snapshot = std::make_unique<Snapshot>(current_snapshot);
+        new_snapshot->erase(str);
+        publish(std::move(new_snapshot));
+        return true;
+    }
+
+    /**
+     * erase() of every string of the range, published at once.
+     * Returns number of the removed strings.
+     */
+    template <std::ranges::input_range Range>
+    std::size_t erase_range(Range&& strings) {
+        const std::lock_guard lock(writer_mutex_);
+        auto new_snapshot = std::make_unique<Snapshot>(*snapshot_.load(std::memory_order_relaxed));
+        const std::size_t old_size = new_snapshot->size();
+        for (auto&& str : strings) {
+            new_snapshot->erase(std::string_view(str));
+        }
+        const std::size_t erased_count = old_size - new_snapshot->size();
+        if (erased_count != 0) {
+            publish(std::move(new_snapshot));
+        }
+        return erased_count;
+    }
+
+    void clear() {
+        const std::lock_guard lock(writer_mutex_);
+        publish(std::make_unique<Snapshot>());
+    }
+
+    [[nodiscard]] std::size_t overlay_size() const noexcept {
+        return snapshot_.load(std::memory_order_acquire)->size();
+    }
+
+    /**
+     * Frees the replaced snapshots no reader can use anymore without waiting for the next
+     *  update, e.g. after the burst of updates. Never blocks on the readers.
+     * Returns number of freed snapshots.
+     */
+    std::size_t reclaim_retired_snapshots() {
+        const std::lock_guard lock(writer_mutex_);
+        // Replaced snapshots are freed after two epoch advances
+        TryAdvanceEpoch();
+        TryAdvanceEpoch();
+        return FreeRetiredSnapshots();
+    }
+
+    [[nodiscard]] std::size_t retired_snapshots_count() {
+        const std::lock_guard lock(writer_mutex_);
+        return retired_snapshots_.size();
+    }
+
+private:
+    class Snapshot final {
+    public:
+        [[nodiscard]] MappedType find(std::string_view str) const noexcept {
+            const auto iter = lower_bound(str);
+            return iter != entries_.end() && iter->first == str ? iter->second : kDefaultValue;
+        }
+        void insert_or_assign(std::string_view str, MappedType value) {
+            const auto iter = lower_bound(str);
+            if (iter != entries_.end() && iter->first == str) {
+                entries_[static_cast<std::size_t>(iter - entries_.begin())].second =
+                    std::move(value);
+            } else {
+                entries_.emplace(iter, std::string(str), std::move(value));
+            }
+        }
+        void erase(std::string_view str) {
+            const auto iter = lower_bound(str);
+            if (iter != entries_.end() && iter->first == str) {
+                entries_.erase(iter);
+            }
+        }
+        [[nodiscard]] std::size_t size() const noexcept {
+            return entries_.size();
+        }
+
+    private:
+        using Entry = std::pair<std::string, MappedType>;
+
+        [[nodiscard]] typename std::vector<Entry>::const_iterator lower_bound(
+            std::string_view str) const noexcept {
+            return std::lower_bound(entries_.begin(), entries_.end(), str,
+                                    [](const Entry& entry, std::string_view key) noexcept {
+                                        return std::string_view(entry.first) < key;
+                                    });
+        }
+
+        std::vector<Entry> entries_;
+    };
+
+    struct RetiredSnapshot final {
+        std::unique_ptr<const Snapshot> snapshot;
+        // Epoch at the moment the snapshot was replaced
+        std::size_t epoch;
+    };
+
+    // Number of the reader counters of every parity, readers of one thread use one of them
+    static constexpr std::size_t kReaderSlots = 16;
+
+    struct alignas(64) ReaderCounter final {
+        std::atomic<std::size_t> active{0};
+    };
+
+    class [[nodiscard]] ReaderGuard final {
+    public:
+        explicit ReaderGuard(const HybridStringMap& map) noexcept
+            : counter_(map.reader_counters_[map.epoch_.load(std::memory_order_relaxed) & 1]
+                                           [ThreadReaderSlot()]
+                                               .active) {
+            // Ordered before the load of the snapshot: the writer which does not see
+            //  the reader publishes the new snapshot before the reader loads it
+            counter_.fetch_add(1, std::memory_order_seq_cst);
+        }
+        ReaderGuard(const ReaderGuard&)            = delete;
+        ReaderGuard& operator=(const ReaderGuard&) = delete;
+        ~ReaderGuard() {
+            counter_.fetch_sub(1, std::memory_order_release);
+        }
+
+    private:
+        std::atomic<std::size_t>& counter_;
+    };
+
+    [[nodiscard]] static std::size_t ThreadReaderSlot() noexcept {
+        static constinit std::atomic<std::size_t> next_slot{0};
+        thread_local const std::size_t slot =
+            next_slot.fetch_add(1, std::memory_order_relaxed) % kReaderSlots;
+        return slot;
+    }
+
+    // Should be called with the writer_mutex_ locked
+    void publish(std::unique_ptr<Snapshot> new_snapshot) {
+        // Current snapshot is retired before the store, so nothing leaks if push_back throws
+        retired_snapshots_.push_back(RetiredSnapshot{
+            .snapshot = std::unique_ptr<const Snapshot>(snapshot_.load(std::memory_order_relaxed)),
+            .epoch    = epoch_.load(std::memory_order_relaxed),
+        });
+        snapshot_.store(new_snapshot.release(), std::memory_order_seq_cst);
+        TryAdvanceEpoch();
+        FreeRetiredSnapshots();
+    }
+
+    /**
+     * Advances the epoch if no reader announced in the parity the new epoch is going to
+     *  use. Such readers either read the epoch before the previous advance or loaded
+     *  the snapshot after this call, so after two advances every reader which could
+     *  load the replaced snapshot has left.
+     * Should be called with the writer_mutex_ locked.
+     */
+    void TryAdvanceEpoch() noexcept {
+        const std::size_t epoch = epoch_.load(std::memory_order_relaxed);
+        for (const ReaderCounter& counter : reader_counters_[(epoch + 1) & 1]) {
+            if (counter.active.load(std::memory_order_seq_cst) != 0) {
+                return;
+            }
+        }
+        epoch_.store(epoch + 1, std::memory_order_relaxed);
+    }
+
+    // Should be called with the writer_mutex_ locked
+    std::size_t FreeRetiredSnapshots() noexcept {
+        const std::size_t epoch = epoch_.load(std::memory_order_relaxed);
+        return std::erase_if(retired_snapshots_, [epoch](const RetiredSnapshot& retired) noexcept {
+            return epoch - retired.epoch >= 2;
+        });
+    }
+
+    static constexpr StaticMap kStaticMap{};
+
+    std::atomic<const Snapshot*> snapshot_;
+    std::atomic<std::size_t> epoch_{0};
+    mutable std::array<std::array<ReaderCounter, kReaderSlots>, 2> reader_counters_{};
+    std::mutex writer_mutex_;
+    std::vector<RetiredSnapshot> retired_snapshots_;
+};
@@ -0,0 +1,573 @@
+/**
+ * Copyright 2024 https://github.com/i80287
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "StringMap.hpp"
+
+/**
+ * Name of the field of the struct and pointer to it, e.g.
+ *  StructField<"user_id", &Event::user_id>.
+ */
+template <string_map_detail::CompileTimeStringLiteral Name, auto MemberPointer>
+    requires(std::is_member_object_pointer_v<decltype(MemberPointer)>)
+struct StructField final {
+    static constexpr auto kNameLiteral      = Name;
+    static constexpr auto kMemberPointer    = MemberPointer;
+    static constexpr std::string_view kName = {Name.value.data(), Name.length};
+};
+
+/**
+ * Field names of the Struct resolved to the field index with StringMatch<Names...>,
+ *  visit() then reaches the field with the switch over the index (like StringSwitch).
+ */
+template <class Struct, class... Fields>
+    requires(sizeof...(Fields) > 0)
+class [[nodiscard]] StructFieldMap final {
+public:
+    using StructType = Struct;
+    using NamesMatch = StringMatch<Fields::kNameLiteral...>;
+
+    static constexpr std::size_t kFieldsCount = sizeof...(Fields);
+    // Index returned by index_of for the unknown names
+    static constexpr std::size_t kNotFound = kFieldsCount;
+
+    static constexpr std::array<std::string_view, kFieldsCount> kNames = {Fields::kName...};
+
+    [[nodiscard]] static constexpr std::size_t index_of(std::string_view name) noexcept {
+        return kNamesMatch(name);
+    }
+
+    /**
+     * Calls visitor(object.*member) for the field with the name and returns
+     *  its result (converted to bool). Returns false if there is no such field.
+     */
+    template <class Visitor>
+    static constexpr bool visit(Struct& object, std::string_view name, Visitor&& visitor) {
+        const std::size_t index = index_of(name);
+        if (index == kNotFound) {
+            return false;
+        }
+        return visit_at(object, index, visitor);
+    }
+
+    // index should be less than kFieldsCount
+    template <class Visitor>
+    static constexpr bool visit_at(Struct& object, std::size_t index, Visitor& visitor) {
+        return VisitAt(object, index, visitor, std::index_sequence_for<Fields...>{});
+    }
+
+private:
+    template <class Field, class Visitor>
+    static constexpr bool InvokeVisitor(Struct& object, Visitor& visitor) {
+        if constexpr (std::is_void_v<decltype(visitor(object.*Field::kMemberPointer))>) {
+            visitor(object.*Field::kMemberPointer);
+            return true;
+        } else {
+            return static_cast<bool>(visitor(object.*Field::kMemberPointer));
+        }
+    }
+
+    // Fold over the field indexes compiles to the switch, so the visitor is inlined
+    template <class Visitor, std::size_t... I>
+    static constexpr bool VisitAt(Struct& object, std::size_t index, Visitor& visitor,
+                                  std::index_sequence<I...>) {
+        using FieldsTuple = std::tuple<Fields...>;
+        bool result       = false;
+        static_cast<void>(
+            ((index == I &&
+              (result = InvokeVisitor<std::tuple_element_t<I, FieldsTuple>>(object, visitor),
+               true)) ||
+             ...));
+        return result;
+    }
+
+    static constexpr NamesMatch kNamesMatch{};
+};
+
+enum class JsonDecodeError : std::uint8_t {
+    kOk,
+    kUnexpectedEnd,
+    kUnexpectedChar,
+    kInvalidString,
+    kInvalidNumber,
+    // Value of the known field has another type, e.g. string for the int field
+    kTypeMismatch,
+    kTooDeep,
+};
+
+struct JsonDecodeResult final {
+    JsonDecodeError error{};
+    // Offset of the error in the input or the size of the decoded object
+    std::size_t position{};
+
+    [[nodiscard]] constexpr bool ok() const noexcept {
+        return error == JsonDecodeError::kOk;
+    }
+};
+
+namespace json_decoder_detail {
+
+template <class T>
+struct IsOptional : std::false_type {};
+template <class T>
+struct IsOptional<std::optional<T>> : std::true_type {};
+
+/**
+ * Single pass decoder of one JSON object without building the DOM: every key is
+ *  dispatched through the StructFieldMap to the parser of the field value, values of
+ *  the unknown keys (including nested objects and arrays) are skipped.
+ */
+template <class FieldMap>
+class ObjectDecoder final {
+public:
+    using Struct = typename FieldMap::StructType;
+
+    // Depth of the skipped nested values
+    static constexpr std::size_t kMaxDepth = 64;
+
+    explicit ObjectDecoder(std::string_view json) noexcept : json_(json) {}
+
+    JsonDecodeResult Decode(Struct& object) {
+        SkipWhitespace();
+        if (!Consume('{')) {
+            return Fail(AtEnd() ? JsonDecodeError::kUnexpectedEnd
+                                : JsonDecodeError::kUnexpectedChar);
+        }
+        SkipWhitespace();
+        if (Consume('}')) {
+            return {JsonDecodeError::kOk, pos_};
+        }
+        auto value_parser = [this](auto& field) { return ParseValue(field); };
+        while (true) {
+            SkipWhitespace();
+            std::string_view key;
+            if (!ParseString(key_buffer_, key)) {
+                return Fail(error_);
+            }
+            SkipWhitespace();
+            if (!Consume(':')) {
+                return Fail(AtEnd() ? JsonDecodeError::kUnexpectedEnd
+                                    : JsonDecodeError::kUnexpectedChar);
+            }
+            SkipWhitespace();
+
+            const std::size_t field_index = FieldMap::index_of(key);
+            const bool parsed = field_index != FieldMap::kNotFound
+                                    ? FieldMap::visit_at(object, field_index, value_parser)
+                                    : SkipValue(0);
+            if (!parsed) {
+                return Fail(error_);
+            }
+
+            SkipWhitespace();
+            if (Consume('}')) {
+                return {JsonDecodeError::kOk, pos_};
+            }
+            if (!Consume(',')) {
+                return Fail(AtEnd() ? JsonDecodeError::kUnexpectedEnd
+                                    : JsonDecodeError::kUnexpectedChar);
+            }
+        }
+    }
+
+private:
+    [[nodiscard]] bool AtEnd() const noexcept {
+        return pos_ >= json_.size();
+    }
+
+    [[nodiscard]] JsonDecodeResult Fail(JsonDecodeError error) const noexcept {
+        return {error, pos_};
+    }
+
+    bool SetError(JsonDecodeError error) noexcept {
+        error_ = error;
+        return false;
+    }
+
+    bool Consume(char chr) noexcept {
+        if (!AtEnd() && json_[pos_] == chr) {
+            pos_++;
+            return true;
+        }
+        return false;
+    }
+
+    bool ConsumeLiteral(std::string_view literal) noexcept {
+        if (json_.substr(pos_, literal.size()) == literal) {
+            pos_ += literal.size();
+            return true;
+        }
+        return false;
+    }
+
+    void SkipWhitespace() noexcept {
+        while (!AtEnd() && (json_[pos_] == ' ' || json_[pos_] == '\t' || json_[pos_] == '\n' ||
+                            json_[pos_] == '\r')) {
+            pos_++;
+        }
+    }
+
+    [[nodiscard]] static int HexDigit(char chr) noexcept {
+        if ('0' <= chr && chr <= '9') {
+            return chr - '0';
+        }
+        if ('a' <= chr && chr <= 'f') {
+            return chr - 'a' + 10;
+        }
+        if ('A' <= chr && chr <= 'F') {
+            return chr - 'A' + 10;
+        }
+        return -1;
+    }
+
+    bool ParseHex4(std::uint32_t& code_point) noexcept {
+        if (json_.size() - pos_ < 4) {
+            return SetError(JsonDecodeError::kUnexpectedEnd);
+        }
+        code_point = 0;
+        for (std::size_t i = 0; i < 4; i++) {
+            const int digit = HexDigit(json_[pos_ + i]);
+            if (digit < 0) {
+                return SetError(JsonDecodeError::kInvalidString);
+            }
+            code_point = code_point * 16 + static_cast<std::uint32_t>(digit);
+        }
+        pos_ += 4;
+        return true;
+    }
+
+    static void AppendUtf8(std::string& buffer, std::uint32_t code_point) {
+        if (code_point < 0x80) {
+            buffer.push_back(static_cast<char>(code_point));
+        } else if (code_point < 0x800) {
+            buffer.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+            buffer.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+        } else if (code_point < 0x10000) {
+            buffer.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+            buffer.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+            buffer.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+        } else {
+            buffer.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+            buffer.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+            buffer.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+            buffer.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+        }
+    }
+
+    bool ParseEscape(std::string& buffer) {
+        if (AtEnd()) {
+            return SetError(JsonDecodeError::kUnexpectedEnd);
+        }
+        const char escaped = json_[pos_++];
+        switch (escaped) {
+            case '"':
+            case '\\':
+            case '/':
+                buffer.push_back(escaped);
+                return true;
+            case 'b':
+                buffer.push_back('\b');
+                return true;
+            case 'f':
+                buffer.push_back('\f');
+                return true;
+            case 'n':
+                buffer.push_back('\n');
+                return true;
+            case 'r':
+                buffer.push_back('\r');
+                return true;
+            case 't':
+                buffer.push_back('\t');
+                return true;
+            case 'u':
+                break;
+            default:
+                return SetError(JsonDecodeError::kInvalidString);
+        }
+
+        std::uint32_t code_point = 0;
+        if (!ParseHex4(code_point)) {
+            return false;
+        }
+        if (0xD800 <= code_point && code_point <= 0xDBFF) {
+            std::uint32_t low_surrogate = 0;
+            if (!ConsumeLiteral("\\u") || !ParseHex4(low_surrogate) || low_surrogate < 0xDC00 ||
+                low_surrogate > 0xDFFF) {
+                return SetError(JsonDecodeError::kInvalidString);
+            }
+            code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low_surrogate - 0xDC00);
+        } else if (0xDC00 <= code_point && code_point <= 0xDFFF) {
+            return SetError(JsonDecodeError::kInvalidString);
+        }
+        AppendUtf8(buffer, code_point);
+        return true;
+    }
+
+    /**
+     * Parses the string starting at the current position. value points into the
+     *  input if the string has no escapes, into the buffer otherwise.
+     */
+    bool ParseString(std::string& buffer, std::string_view& value) {
+        if (!Consume('"')) {
+            return SetError(AtEnd() ? JsonDecodeError::kUnexpectedEnd
+                                    : JsonDecodeError::kUnexpectedChar);
+        }
+        const std::size_t begin = pos_;
+        while (!AtEnd() && json_[pos_] != '"' && json_[pos_] != '\\') {
+            if (static_cast<unsigned char>(json_[pos_]) < 0x20) {
+                return SetError(JsonDecodeError::kInvalidString);
+            }
+            pos_++;
+        }
+        if (AtEnd()) {
+            return SetError(JsonDecodeError::kUnexpectedEnd);
+        }
+        if (json_[pos_] == '"') {
+            value = json_.substr(begin, pos_ - begin);
+            pos_++;
+            return true;
+        }
+
+        buffer.assign(json_.substr(begin, pos_ - begin));
+        while (!AtEnd() && json_[pos_] != '"') {
+            const char chr = json_[pos_++];
+            if (chr == '\\') {
+                if (!ParseEscape(buffer)) {
+                    return false;
+                }
+            } else if (static_cast<unsigned char>(chr) < 0x20) {
+                return SetError(JsonDecodeError::kInvalidString);
+            } else {
+                buffer.push_back(chr);
+            }
+        }
+        if (!Consume('"')) {
+            return SetError(JsonDecodeError::kUnexpectedEnd);
+        }
+        value = buffer;
+        return true;
+    }
+
+    // Bounds of the number token at the current position, validated by the JSON grammar
+    bool ScanNumber(std::string_view& number) noexcept {
+        const std::size_t begin = pos_;
+        Consume('-');
+        const std::size_t int_begin = pos_;
+        while (!AtEnd() && '0' <= json_[pos_] && json_[pos_] <= '9') {
+            pos_++;
+        }
+        const std::size_t int_digits = pos_ - int_begin;
+        if (int_digits == 0 || (int_digits > 1 && json_[int_begin] == '0')) {
+            return SetError(JsonDecodeError::kInvalidNumber);
+        }
+        if (Consume('.')) {
+            const std::size_t fraction_begin = pos_;
+            while (!AtEnd() && '0' <= json_[pos_] && json_[pos_] <= '9') {
+                pos_++;
+            }
+            if (pos_ == fraction_begin) {
+                return SetError(JsonDecodeError::kInvalidNumber);
+            }
+        }
+        if (Consume('e') || Consume('E')) {
+            if (!Consume('+')) {
+                Consume('-');
+            }
+            const std::size_t exponent_begin = pos_;
+            while (!AtEnd() && '0' <= json_[pos_] && json_[pos_] <= '9') {
+                pos_++;
+            }
+            if (pos_ == exponent_begin) {
+                return SetError(JsonDecodeError::kInvalidNumber);
+            }
+        }
+        number = json_.substr(begin, pos_ - begin);
+        return true;
+    }
+
+    template <class T>
+    bool ParseValue(T& field) {
+        if constexpr (IsOptional<T>::value) {
+            if (ConsumeLiteral("null")) {
+                field.reset();
+                return true;
+            }
+            typename T::value_type value{};
+            if (!ParseValue(value)) {
+                return false;
+            }
+            field = std::move(value);
+            return true;
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            std::string_view value;
+            if (AtEnd() || json_[pos_] != '"') {
+                return SetError(JsonDecodeError::kTypeMismatch);
+            }
+            // Escapes are unescaped into the buffer, so the field is not changed on errors
+            if (!ParseString(value_buffer_, value)) {
+                return false;
+            }
+            if (value.data() == value_buffer_.data()) {
+                // Old value of the field becomes the buffer for the next string
+                field.swap(value_buffer_);
+            } else {
+                field.assign(value);
+            }
+            return true;
+        } else if constexpr (std::is_same_v<T, bool>) {
+            if (ConsumeLiteral("true")) {
+                field = true;
+                return true;
+            }
+            if (ConsumeLiteral("false")) {
+                field = false;
+                return true;
+            }
+            return SetError(JsonDecodeError::kTypeMismatch);
+        } else if constexpr (std::is_arithmetic_v<T>) {
+            if (AtEnd() || (json_[pos_] != '-' && (json_[pos_] < '0' || json_[pos_] > '9'))) {
+                return SetError(JsonDecodeError::kTypeMismatch);
+            }
+            std::string_view number;
+            if (!ScanNumber(number)) {
+                return false;
+            }
+            // Parsed into the local, so the field is not changed on errors
+            T value{};
+            const char* const number_end = number.data() + number.size();
+            const auto [parse_end, errc] = std::from_chars(number.data(), number_end, value);
+            if (errc != std::errc{}) {
+                return SetError(errc == std::errc::result_out_of_range
+                                    ? JsonDecodeError::kInvalidNumber
+                                    : JsonDecodeError::kTypeMismatch);
+            }
+            if (parse_end != number_end) {
+                // E.g. 1.5 for the integer field
+                return SetError(JsonDecodeError::kTypeMismatch);
+            }
+            field = value;
+            return true;
+        } else {
+            static_assert(std::is_same_v<T, void>,
+                          "Field type is not supported by the JSON decoder: use std::string, "
+                          "bool, arithmetic types or std::optional of them");
+            return false;
+        }
+    }
+
+    bool SkipValue(std::size_t depth) {
+        if (depth >= kMaxDepth) {
+            return SetError(JsonDecodeError::kTooDeep);
+        }
+        if (AtEnd()) {
+            return SetError(JsonDecodeError::kUnexpectedEnd);
+        }
+        switch (json_[pos_]) {
+            case '"': {
+                std::string_view value;
+                return ParseString(skip_buffer_, value);
+            }
+            case '{':
+            case '[': {
+                const char close = json_[pos_] == '{' ? '}' : ']';
+                pos_++;
+                SkipWhitespace();
+                if (Consume(close)) {
+                    return true;
+                }
+                while (true) {
+                    SkipWhitespace();
+                    if (close == '}') {
+                        std::string_view key;
+                        if (!ParseString(skip_buffer_, key)) {
+                            return false;
+                        }
+                        SkipWhitespace();
+                        if (!Consume(':')) {
+                            return SetError(AtEnd() ? JsonDecodeError::kUnexpectedEnd
+                                                    : JsonDecodeError::kUnexpectedChar);
+                        }
+                        SkipWhitespace();
+                    }
+                    if (!SkipValue(depth + 1)) {
+                        return false;
+                    }
+                    SkipWhitespace();
+                    if (Consume(close)) {
+                        return true;
+                    }
+                    if (!Consume(',')) {
+                        return SetError(AtEnd() ? JsonDecodeError::kUnexpectedEnd
+                                                : JsonDecodeError::kUnexpectedChar);
+                    }
+                }
+            }
+            case 't':
+            case 'f':
+            case 'n':
+                if (ConsumeLiteral("true") || ConsumeLiteral("false") || ConsumeLiteral("null")) {
+                    return true;
+                }
+                return SetError(JsonDecodeError::kUnexpectedChar);
+            default: {
+                std::string_view number;
+                return ScanNumber(number);
+            }
+        }
+    }
+
+    std::string_view json_;
+    std::size_t pos_{};
+    JsonDecodeError error_{};
+    std::string key_buffer_;
+    std::string value_buffer_;
+    std::string skip_buffer_;
+};
+
+}  // namespace json_decoder_detail
+
+/**
+ * Decodes the JSON object from the start of the json into the object: every key
+ *  is looked up in the FieldMap (StructFieldMap) once and its value is parsed right
+ *  into the field. Keys which are not in the map are skipped with their values,
+ *  fields absent in the json are left untouched, the last of the duplicate keys wins.
+ *
+ * Supported field types: std::string, bool, arithmetic types and std::optional of them
+ *  (null resets the optional). On success position is the offset after the closing '}'.
+ *
+ * Whole object should be in the json, chunked input is not supported: the decoder keeps
+ *  no state between the calls and the keys without escapes point into the json.
+ *  On errors the fields parsed before the error keep their new values, the field
+ *  whose value fails is left untouched.
+ */
+template <class FieldMap>
+JsonDecodeResult DecodeJsonObject(std::string_view json, typename FieldMap::StructType& object) {
+    return json_decoder_detail::ObjectDecoder<FieldMap>(json).Decode(object);
+}
@@ -0,0 +1,266 @@
+/**
+ * Copyright 2024 https://github.com/i80287
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "StringMap.hpp"
+
+/**
+ * Arrow-style string column: value of the row i is data[offsets[i], offsets[i + 1]),
+ *  so offsets has one element more than the column has rows.
+ * padding is the number of readable bytes after the end of the data (e.g. Arrow buffers
+ *  are allocated in the multiples of 64 bytes), 0 if nothing is known about them.
+ */
+template <class Offset>
+    requires(std::is_integral_v<Offset>)
+struct StringColumnView final {
+    std::span<const Offset> offsets;
+    std::span<const char> data;
+    std::size_t padding = 0;
+
+    [[nodiscard]] constexpr std::size_t rows_count() const noexcept {
+        return offsets.empty() ? 0 : offsets.size() - 1;
+    }
+};
+
+namespace string_column_encoder_detail {
+
+// Enough for the padded lookup of every backend (kPacked with 2 words needs the most)
+inline constexpr std::size_t kLookupPadding = 15;
+
+template <class Map>
+concept HasPaddedLookup = requires(const Map& map, const char* str, std::size_t size) {
+    map(str, size, PaddedInput<kLookupPadding>{});
+};
+
+/**
+ * Codes of the rows [first_row, last_row). Every row except the last few ones is followed
+ *  by the values of the next rows, so it is looked up with the padded kernel of the map
+ *  (when the map has one) without any guarantees from the caller.
+ */
+template <class Map, class Offset, class Code>
+void EncodeRows(const Map& map, const StringColumnView<Offset>& column, Code* const codes,
+                const std::size_t first_row, const std::size_t last_row) noexcept {
+    const Offset* const offsets = column.offsets.data();
+    const char* const data      = column.data.data();
+    if constexpr (HasPaddedLookup<Map>) {
+        const std::size_t readable_size = column.data.size() + column.padding;
+        for (std::size_t i = first_row; i < last_row; i++) {
+            const auto begin = static_cast<std::size_t>(offsets[i]);
+            const auto end   = static_cast<std::size_t>(offsets[i + 1]);
+            codes[i] = static_cast<Code>(end + kLookupPadding <= readable_size
+                                             ? map(data + begin, end - begin,
+                                                   PaddedInput<kLookupPadding>{})
+                                             : map(data + begin, end - begin));
+        }
+    } else {
+        for (std::size_t i = first_row; i < last_row; i++) {
+            const auto begin = static_cast<std::size_t>(offsets[i]);
+            const auto end   = static_cast<std::size_t>(offsets[i + 1]);
+            codes[i]         = static_cast<Code>(map(data + begin, end - begin));
+        }
+    }
+}
+
+// Only the shape of the column is checked, offsets themselves are trusted like in Arrow
+template <class Offset, class Code>
+[[nodiscard]] bool IsValidColumn(const StringColumnView<Offset>& column,
+                                 std::span<Code> codes) noexcept {
+    if (column.offsets.empty()) {
+        // Arrow allows the empty offsets buffer for the empty column
+        return codes.empty();
+    }
+    if (column.offsets.size() != codes.size() + 1) {
+        return false;
+    }
+    if constexpr (std::is_signed_v<Offset>) {
+        if (column.offsets.front() < 0) {
+            return false;
+        }
+    }
+    return static_cast<std::size_t>(column.offsets.back()) <= column.data.size();
+}
+
+}  // namespace string_column_encoder_detail
+
+/**
+ * Writes map(value of the row i) to codes[i] for every row of the column in the
+ *  calling thread. Returns false (and writes nothing) if codes.size() is not equal to
+ *  the number of rows or the last offset points past the end of the data.
+ */
+template <class Map, class Offset, class Code>
+    requires(std::is_integral_v<Code>)
+bool DictionaryEncodeColumn(const Map& map, const StringColumnView<Offset>& column,
+                            std::span<Code> codes) noexcept {
+    if (!string_column_encoder_detail::IsValidColumn(column, codes)) [[unlikely]] {
+        return false;
+    }
+    string_column_encoder_detail::EncodeRows(map, column, codes.data(), 0, codes.size());
+    return true;
+}
+
+/**
+ * Fixed pool of the worker threads which dictionary encode large columns in parallel.
+ *
+ * encode() splits the column into chunks of kRowsPerChunk rows which the workers and
+ *  the calling thread take one by one from the shared counter, so the slow chunks
+ *  (e.g. long values) do not stall the rest of the workers. Columns of at most
+ *  kRowsPerChunk rows are encoded in the calling thread without waking the workers.
+ * Calls of encode() from several threads are serialized.
+ */
+class [[nodiscard]] DictionaryEncoderPool final {
+public:
+    // Large enough to amortize the chunk counter, small enough to balance the load
+    static constexpr std::size_t kRowsPerChunk = std::size_t{1} << 14;
+
+    // threads_count includes the thread calling encode(), so threads_count - 1 workers are run
+    explicit DictionaryEncoderPool(
+        const std::size_t threads_count = std::max(1u, std::thread::hardware_concurrency())) {
+        workers_.reserve(threads_count - std::min(threads_count, std::size_t{1}));
+        for (std::size_t i = 1; i < threads_count; i++) {
+            workers_.emplace_back([this]() { WorkerLoop(); });
+        }
+    }
+    DictionaryEncoderPool(const DictionaryEncoderPool&)            = delete;
+    DictionaryEncoderPool& operator=(const DictionaryEncoderPool&) = delete;
+    ~DictionaryEncoderPool() {
+        {
+            const std::lock_guard lock(mutex_);
+            stop_ = true;
+        }
+        job_started_.notify_all();
+        for (std::thread& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    [[nodiscard]] std::size_t threads_count() const noexcept {
+        return workers_.size() + 1;
+    }
+
+    // Same as DictionaryEncodeColumn, but the rows are encoded by all threads of the pool
+    template <class Map, class Offset, class Code>
+        requires(std::is_integral_v<Code>)
+    bool encode(const Map& map, const StringColumnView<Offset>& column, std::span<Code> codes) {
+        if (!string_column_encoder_detail::IsValidColumn(column, codes)) [[unlikely]] {
+            return false;
+        }
+        if (codes.size() <= kRowsPerChunk || workers_.empty()) {
+            string_column_encoder_detail::EncodeRows(map, column, codes.data(), 0, codes.size());
+            return true;
+        }
+
+        struct Context final {
+            const Map& map;
+            const StringColumnView<Offset>& column;
+            Code* codes;
+        } context{map, column, codes.data()};
+
+        const std::lock_guard encode_lock(encode_mutex_);
+        job_ = Job{
+            .encode_rows =
+                [](const void* const erased_context, const std::size_t first_row,
+                   const std::size_t last_row) noexcept {
+                    const auto& ctx = *static_cast<const Context*>(erased_context);
+                    string_column_encoder_detail::EncodeRows(ctx.map, ctx.column, ctx.codes,
+                                                             first_row, last_row);
+                },
+            .context    = &context,
+            .rows_count = codes.size(),
+        };
+        next_chunk_.store(0, std::memory_order_relaxed);
+        {
+            const std::lock_guard lock(mutex_);
+            generation_++;
+            running_workers_ = workers_.size();
+        }
+        job_started_.notify_all();
+
+        RunChunks();
+
+        std::unique_lock lock(mutex_);
+        job_finished_.wait(lock, [this]() noexcept { return running_workers_ == 0; });
+        return true;
+    }
+
+private:
+    struct Job final {
+        void (*encode_rows)(const void* context, std::size_t first_row,
+                            std::size_t last_row) noexcept = nullptr;
+        const void* context                                = nullptr;
+        std::size_t rows_count                             = 0;
+    };
+
+    void RunChunks() noexcept {
+        const Job job = job_;
+        for (;;) {
+            const std::size_t first_row =
+                next_chunk_.fetch_add(1, std::memory_order_relaxed) * kRowsPerChunk;
+            if (first_row >= job.rows_count) {
+                break;
+            }
+            job.encode_rows(job.context, first_row,
+                            std::min(first_row + kRowsPerChunk, job.rows_count));
+        }
+    }
+
+    void WorkerLoop() noexcept {
+        std::size_t seen_generation = 0;
+        for (;;) {
+            {
+                std::unique_lock lock(mutex_);
+                job_started_.wait(lock, [this, seen_generation]() noexcept {
+                    return stop_ || generation_ != seen_generation;
+                });
+                if (stop_) {
+                    return;
+                }
+                seen_generation = generation_;
+            }
+
+            RunChunks();
+
+            const std::lock_guard lock(mutex_);
+            if (--running_workers_ == 0) {
+                job_finished_.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    // Serializes the encode() calls, job_ and next_chunk_ belong to the current one
+    std::mutex encode_mutex_;
+    // Written before the generation_ is incremented under the mutex_, so workers see it
+    Job job_{};
+    std::atomic<std::size_t> next_chunk_{0};
+
+    std::mutex mutex_;
+    std::condition_variable job_started_;
+    std::condition_variable job_finished_;
+    std::size_t generation_      = 0;
+    std::size_t running_workers_ = 0;
+    bool stop_                   = false;
+};
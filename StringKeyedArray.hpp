@@ -0,0 +1,187 @@
+/**
+ * Copyright 2024 https://github.com/i80287
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <string_view>
+#include <type_traits>
+
+#include "StringMap.hpp"
+
+namespace string_keyed_array_detail {
+
+inline constexpr std::size_t kCacheLineSize = 64;
+
+/**
+ * Shard of the current thread: threads are spread round robin over the shards on their
+ *  first update, so up to Shards threads never write to the same cache line.
+ */
+template <std::size_t Shards>
+[[nodiscard]] inline std::size_t CurrentThreadShard() noexcept {
+    if constexpr (Shards == 1) {
+        return 0;
+    } else {
+        static std::atomic<std::size_t> next_shard{0};
+        thread_local const std::size_t shard =
+            next_shard.fetch_add(1, std::memory_order_relaxed) % Shards;
+        return shard;
+    }
+}
+
+}  // namespace string_keyed_array_detail
+
+/**
+ * Array of the runtime mutable values of type T indexed by the compile time strings.
+ *
+ * Key is resolved to the dense index with StringMatch<Keys...>, values are kept in
+ *  Shards cache line aligned copies of the array and updated with relaxed atomics,
+ *  so add() takes no locks, allocates nothing and threads writing to the different
+ *  shards do not share cache lines. Reads sum the value over all shards.
+ *
+ * snapshot() is not atomic across the keys: updates running concurrently with it may be
+ *  seen for some keys and not for the others, but every update is counted exactly once
+ *  by the sequence of take_snapshot() calls.
+ */
+template <class T, std::size_t Shards, string_map_detail::CompileTimeStringLiteral... Keys>
+    requires(std::is_arithmetic_v<T> && Shards > 0 && sizeof...(Keys) > 0)
+class [[nodiscard]] StringKeyedArrayWithShards final {
+public:
+    using ValueType = T;
+    using KeysMatch = StringMatch<Keys...>;
+    using Values    = std::array<T, sizeof...(Keys)>;
+
+    static constexpr std::size_t kKeysCount   = sizeof...(Keys);
+    static constexpr std::size_t kShardsCount = Shards;
+    // Index returned by index_of for the strings which are not keys
+    static constexpr std::size_t kNotFound = kKeysCount;
+
+    static constexpr std::array<std::string_view, kKeysCount> kKeys = {
+        std::string_view(Keys.value.data(), Keys.length)...,
+    };
+
+    static_assert(std::atomic<T>::is_always_lock_free,
+                  "Values of the StringKeyedArray should be lock free atomics");
+
+    constexpr StringKeyedArrayWithShards() noexcept = default;
+    StringKeyedArrayWithShards(const StringKeyedArrayWithShards&)            = delete;
+    StringKeyedArrayWithShards& operator=(const StringKeyedArrayWithShards&) = delete;
+
+    [[nodiscard]] static constexpr std::size_t index_of(std::string_view key) noexcept {
+        return kKeysMatch(key);
+    }
+
+    // Compile time index of the key, for the updates without lookup
+    template <string_map_detail::CompileTimeStringLiteral Key>
+    [[nodiscard]] static consteval std::size_t index_of() noexcept {
+        constexpr std::size_t kIndex = kKeysMatch(std::string_view(Key.value.data(), Key.length));
+        static_assert(kIndex != kNotFound, "Key is not in the StringKeyedArray");
+        return kIndex;
+    }
+
+    /**
+     * Adds delta to the value of the key. Returns false (and does nothing)
+     *  if the key is not one of the Keys...
+     */
+    bool add(std::string_view key, T delta = T{1}) noexcept {
+        const std::size_t index = index_of(key);
+        if (index == kNotFound) [[unlikely]] {
+            return false;
+        }
+        add_at(index, delta);
+        return true;
+    }
+
+    // index should be less than kKeysCount
+    void add_at(std::size_t index, T delta = T{1}) noexcept {
+        const std::size_t shard = string_keyed_array_detail::CurrentThreadShard<Shards>();
+        shards_[shard].values[index].fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    // Sum of the value of the key over all shards, T{} for the unknown key
+    [[nodiscard]] T load(std::string_view key) const noexcept {
+        const std::size_t index = index_of(key);
+        return index != kNotFound ? load_at(index) : T{};
+    }
+
+    [[nodiscard]] T load_at(std::size_t index) const noexcept {
+        T sum{};
+        for (const Shard& shard : shards_) {
+            sum += shard.values[index].load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+
+    [[nodiscard]] Values snapshot() const noexcept {
+        Values values{};
+        for (const Shard& shard : shards_) {
+            for (std::size_t i = 0; i < kKeysCount; i++) {
+                values[i] += shard.values[i].load(std::memory_order_relaxed);
+            }
+        }
+        return values;
+    }
+
+    // Returns values accumulated since the previous take_snapshot() / reset() and zeroes them
+    [[nodiscard]] Values take_snapshot() noexcept {
+        Values values{};
+        for (Shard& shard : shards_) {
+            for (std::size_t i = 0; i < kKeysCount; i++) {
+                values[i] += shard.values[i].exchange(T{}, std::memory_order_relaxed);
+            }
+        }
+        return values;
+    }
+
+    // Adds values (e.g. snapshot of another array or of the previous interval) to this array
+    void merge(const Values& values) noexcept {
+        const std::size_t shard = string_keyed_array_detail::CurrentThreadShard<Shards>();
+        for (std::size_t i = 0; i < kKeysCount; i++) {
+            shards_[shard].values[i].fetch_add(values[i], std::memory_order_relaxed);
+        }
+    }
+
+    void merge(const StringKeyedArrayWithShards& other) noexcept {
+        merge(other.snapshot());
+    }
+
+    void reset() noexcept {
+        for (Shard& shard : shards_) {
+            for (std::atomic<T>& value : shard.values) {
+                value.store(T{}, std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct alignas(string_keyed_array_detail::kCacheLineSize) Shard final {
+        std::array<std::atomic<T>, kKeysCount> values{};
+    };
+
+    static constexpr KeysMatch kKeysMatch{};
+
+    std::array<Shard, Shards> shards_{};
+};
+
+/**
+ * StringKeyedArrayWithShards with the number of shards enough for the typical
+ *  number of the worker threads. Use Shards = 1 for the mostly single threaded updates.
+ */
+template <class T, string_map_detail::CompileTimeStringLiteral... Keys>
+    requires(std::is_arithmetic_v<T> && sizeof...(Keys) > 0)
+using StringKeyedArray = StringKeyedArrayWithShards<T, 16, Keys...>;
@@ -14,14 +14,19 @@
  * limitations under the License.
  */
 
+#pragma once
+
 #include <algorithm>
 #include <array>
 #include <concepts>
 #include <cstdint>
+#include <cstring>
+#include <functional>
 #include <limits>
 #include <numeric>
 #include <string>
 #include <string_view>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 
@@ -119,12 +124,52 @@
 #define STRING_MAP_HAS_BIT 0
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define STRING_MAP_HAS_SSE2 1
+#include <emmintrin.h>
+#else
+#define STRING_MAP_HAS_SSE2 0
+#endif
+
+#if defined(__BMI2__)
+#define STRING_MAP_HAS_BMI2 1
+#include <immintrin.h>
+#else
+#define STRING_MAP_HAS_BMI2 0
+#endif
+
+// Extensions which are not enabled at compile time are detected at runtime (x86-64 only)
+#if !STRING_MAP_HAS_BMI2 && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define STRING_MAP_HAS_CPU_DISPATCH 1
+#else
+#define STRING_MAP_HAS_CPU_DISPATCH 0
+#endif
+
 #if defined(__cpp_consteval) && __cpp_consteval >= 201811L
 #define STRING_MAP_CONSTEVAL consteval
 #else
 #define STRING_MAP_CONSTEVAL constexpr
 #endif
 
+/**
+ * Define STRING_MAP_ENABLE_STATS to 1 before including this header to make every
+ *  StringMatch / StringMap type record lookup counters (see StringMapStats).
+ * When disabled (default) the counters are not compiled in at all.
+ */
+#if !defined(STRING_MAP_ENABLE_STATS)
+#define STRING_MAP_ENABLE_STATS 0
+#endif
+
+#if STRING_MAP_ENABLE_STATS
+#include <atomic>
+#include <mutex>
+#include <vector>
+// Lookups update the counters so they are not pure functions anymore
+#define ATTRIBUTE_LOOKUP_PURE
+#else
+#define ATTRIBUTE_LOOKUP_PURE ATTRIBUTE_PURE
+#endif
+
 namespace string_map_detail {
 
 inline constexpr std::size_t kMaxStringViewSize = 200;
@@ -393,325 +438,4663 @@ inline constexpr TrieParamsType kTrieParams = TrieParams<Strings...>();
 
 }  // namespace trie_tools
 
-namespace string_map_impl {
-
-template <trie_tools::TrieParamsType TrieParams, std::array MappedValues,
-          typename decltype(MappedValues)::value_type DefaultMapValue, CompileTimeStringLiteral... Strings>
-class [[nodiscard]] StringMapImplManyStrings final {
-    static_assert(0 < TrieParams.min_char && TrieParams.min_char <= TrieParams.max_char &&
-                      TrieParams.max_char <= std::numeric_limits<std::uint8_t>::max(),
-                  "Empty string was passed in StringMatch / StringMap");
-    static_assert(sizeof...(Strings) == std::size(MappedValues) && std::size(MappedValues) > 0,
-                  "internal error");
+namespace stats {
 
-    template <bool InCompileTime, bool ForceUnsignedChar = false>
-    struct [[nodiscard]] InternalIterator final {
-        using iterator_category = std::random_access_iterator_tag;
-        using difference_type   = std::ptrdiff_t;
-        using value_type = std::conditional_t<InCompileTime && !ForceUnsignedChar, const char,
-                                              const unsigned char>;
-        using pointer    = value_type*;
-        using reference  = value_type&;
+struct StringMapStats final {
+    std::uint64_t lookups{};
+    std::uint64_t hits{};
+    std::uint64_t misses{};
+    // Sum of the trie depths reached by all lookups
+    std::uint64_t total_depth{};
+    std::uint64_t max_depth{};
+    // Trie lookup exit paths on miss
+    std::uint64_t out_of_alphabet_exits{};
+    std::uint64_t missing_edge_exits{};
+    std::uint64_t non_terminal_exits{};
 
-        template <class CharType>
-        ATTRIBUTE_ALWAYS_INLINE explicit constexpr InternalIterator(const CharType* str) noexcept {
-            if constexpr (InCompileTime || std::is_same_v<CharType, value_type>) {
-                pointer_ = str;
-            } else {
-#if STRING_MAP_HAS_BIT
-                pointer_ = std::bit_cast<pointer>(str);
-#else
-                pointer_ = reinterpret_cast<pointer>(str);
-#endif
-            }
-        }
-        ATTRIBUTE_ALWAYS_INLINE constexpr InternalIterator& operator++() noexcept {
-            ++pointer_;
-            return *this;
-        }
-        [[nodiscard]] ATTRIBUTE_ALWAYS_INLINE constexpr value_type operator*() const noexcept {
-            return *pointer_;
-        }
-        [[nodiscard]] ATTRIBUTE_ALWAYS_INLINE constexpr value_type operator[](
-            std::size_t index) const noexcept {
-            return pointer_[index];
-        }
-        [[nodiscard]] ATTRIBUTE_CONST ATTRIBUTE_ALWAYS_INLINE constexpr bool operator==(
-            const InternalIterator& other) const noexcept {
-            return pointer_ == other.pointer_;
-        }
-        struct CStringSentinel {};
-        [[nodiscard]] ATTRIBUTE_PURE ATTRIBUTE_ALWAYS_INLINE constexpr bool operator==(
-            const CStringSentinel&) const noexcept {
-            return *pointer_ == '\0';
-        }
+    [[nodiscard]] constexpr double average_depth() const noexcept {
+        return lookups == 0 ? 0.0
+                            : static_cast<double>(total_depth) / static_cast<double>(lookups);
+    }
+};
 
-        pointer pointer_{};
-    };
+enum class LookupExit {
+    kHit,
+    kOutOfAlphabet,
+    kMissingEdge,
+    kNonTerminalEnd,
+    // Miss of the backend which does not walk the trie
+    kMismatch,
+};
 
-public:
-    using MappedType = typename decltype(MappedValues)::value_type;
-    static_assert(std::is_copy_assignable_v<MappedType>);
+#if STRING_MAP_ENABLE_STATS
 
-    static constexpr MappedType kDefaultValue = DefaultMapValue;
-    static constexpr char kMinChar            = static_cast<char>(TrieParams.min_char);
-    static constexpr char kMaxChar            = static_cast<char>(TrieParams.max_char);
+/**
+ * Counters of one thread. Every counter has exactly one writer (the owning thread),
+ *  so the increments are plain relaxed load + store without any lock prefix
+ *  and the other threads may read them concurrently when taking a snapshot.
+ *
+ * Other threads never write the counters: reset bumps the generation of the registry,
+ *  the owner zeroes its counters on the next lookup and until then the snapshots
+ *  treat the counters of the older generation as zeroes.
+ */
+struct alignas(64) ThreadLookupCounters final {
+    std::atomic<std::uint64_t> lookups{};
+    std::atomic<std::uint64_t> hits{};
+    std::atomic<std::uint64_t> misses{};
+    std::atomic<std::uint64_t> total_depth{};
+    std::atomic<std::uint64_t> max_depth{};
+    std::atomic<std::uint64_t> out_of_alphabet_exits{};
+    std::atomic<std::uint64_t> missing_edge_exits{};
+    std::atomic<std::uint64_t> non_terminal_exits{};
+    // Generation of the registry the counters were zeroed at
+    std::atomic<std::uint64_t> generation{};
 
-    STRING_MAP_CONSTEVAL StringMapImplManyStrings() noexcept {
-        AddPattern<0, Strings...>(kRootNodeIndex + 1);
+    static void Increment(std::atomic<std::uint64_t>& counter, std::uint64_t value) noexcept {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
     }
 
-    constexpr MappedType operator()(std::nullptr_t) const noexcept              = delete;
-    constexpr MappedType operator()(std::nullptr_t, std::size_t) const noexcept = delete;
-
-    // clang-format off
-    template <class CharType>
-    [[nodiscard]]
-    ATTRIBUTE_PURE
-    ATTRIBUTE_ALWAYS_INLINE
-    constexpr MappedType operator()(std::basic_string_view<CharType> str) const noexcept {
-        // clang-format on
-        return operator()(str.data(), str.size());
-    }
-    // clang-format off
-    template <class CharType>
-    [[nodiscard]]
-    ATTRIBUTE_PURE
-    ATTRIBUTE_ALWAYS_INLINE
-    constexpr MappedType operator()(const std::basic_string<CharType>& str) const noexcept {
-        // clang-format on
-        return operator()(str.data(), str.size());
-    }
-    // clang-format off
-    template <class CharType>
-    [[nodiscard]]
-    ATTRIBUTE_PURE
-    ATTRIBUTE_ALWAYS_INLINE
-    ATTRIBUTE_SIZED_ACCESS(read_only, 2, 3)
-    constexpr MappedType operator()(const CharType* str, std::size_t size) const noexcept {
-        // clang-format on
-        if (std::is_constant_evaluated()) {
-            if constexpr (std::is_same_v<CharType, char>) {
-                using IteratorType = InternalIterator</*InCompileTime = */ true>;
-                return operator_call_impl(IteratorType(str), IteratorType(str + size));
-            } else {
-                using IteratorType =
-                    InternalIterator</*InCompileTime = */ true, /*ForceUnsignedChar = */ true>;
-                return operator_call_impl(IteratorType(str), IteratorType(str + size));
-            }
-        } else {
-            if constexpr (std::is_same_v<CharType, char>) {
-                using IteratorType = InternalIterator</*InCompileTime = */ false>;
-                return operator_call_impl(IteratorType(str), IteratorType(str + size));
-            } else {
-                using IteratorType =
-                    InternalIterator</*InCompileTime = */ false, /*ForceUnsignedChar = */ true>;
-                return operator_call_impl(IteratorType(str), IteratorType(str + size));
+    void Record(LookupExit exit, std::size_t depth, std::uint64_t current_generation) noexcept {
+        if (generation.load(std::memory_order_relaxed) != current_generation) [[unlikely]] {
+            for (auto* counter : {&lookups, &hits, &misses, &total_depth, &max_depth,
+                                  &out_of_alphabet_exits, &missing_edge_exits,
+                                  &non_terminal_exits}) {
+                counter->store(0, std::memory_order_relaxed);
             }
+            // Snapshot which sees the new generation sees the zeroes as well
+            generation.store(current_generation, std::memory_order_release);
+        }
+        Increment(lookups, 1);
+        Increment(total_depth, depth);
+        if (depth > max_depth.load(std::memory_order_relaxed)) {
+            max_depth.store(depth, std::memory_order_relaxed);
+        }
+        switch (exit) {
+            case LookupExit::kHit:
+                Increment(hits, 1);
+                break;
+            case LookupExit::kOutOfAlphabet:
+                Increment(misses, 1);
+                Increment(out_of_alphabet_exits, 1);
+                break;
+            case LookupExit::kMissingEdge:
+                Increment(misses, 1);
+                Increment(missing_edge_exits, 1);
+                break;
+            case LookupExit::kNonTerminalEnd:
+                Increment(misses, 1);
+                Increment(non_terminal_exits, 1);
+                break;
+            case LookupExit::kMismatch:
+            default:
+                Increment(misses, 1);
+                break;
         }
     }
-    // clang-format off
-    [[nodiscard]]
-    ATTRIBUTE_PURE
-    ATTRIBUTE_ALWAYS_INLINE
-    ATTRIBUTE_ACCESS(read_only, 2)
-    constexpr MappedType operator()(const char* str) const noexcept {
-        // clang-format on
-        if (str == nullptr) [[unlikely]] {
-            return kDefaultValue;
+
+    void AddTo(StringMapStats& stats, std::uint64_t current_generation) const noexcept {
+        if (generation.load(std::memory_order_acquire) != current_generation) {
+            return;
         }
-        if (std::is_constant_evaluated()) {
-            using IteratorType = InternalIterator</*InCompileTime = */ true>;
-            using SentinelType = typename IteratorType::CStringSentinel;
-            return operator_call_impl(IteratorType(str), SentinelType{});
-        } else {
-            using IteratorType = InternalIterator</*InCompileTime = */ false>;
-            using SentinelType = typename IteratorType::CStringSentinel;
-            return operator_call_impl(IteratorType(str), SentinelType{});
+        stats.lookups += lookups.load(std::memory_order_relaxed);
+        stats.hits += hits.load(std::memory_order_relaxed);
+        stats.misses += misses.load(std::memory_order_relaxed);
+        stats.total_depth += total_depth.load(std::memory_order_relaxed);
+        stats.max_depth = std::max(stats.max_depth, max_depth.load(std::memory_order_relaxed));
+        stats.out_of_alphabet_exits += out_of_alphabet_exits.load(std::memory_order_relaxed);
+        stats.missing_edge_exits += missing_edge_exits.load(std::memory_order_relaxed);
+        stats.non_terminal_exits += non_terminal_exits.load(std::memory_order_relaxed);
+    }
+};
+
+/**
+ * Per map type registry of the thread counters. The mutex is taken only
+ *  when a thread performs its first lookup, exits or when stats are queried.
+ */
+template <class MapType>
+class LookupCountersRegistry final {
+public:
+    static StringMapStats Snapshot() {
+        Registry& registry = GetRegistry();
+        const std::lock_guard lock(registry.mutex);
+        const std::uint64_t current_generation = generation_.load(std::memory_order_relaxed);
+        StringMapStats stats = registry.retired_stats;
+        for (const ThreadLookupCounters* counters : registry.live_counters) {
+            counters->AddTo(stats, current_generation);
         }
+        return stats;
     }
 
-#if STRING_MAP_HAS_SPAN
-    // clang-format off
-    template <class CharType, std::size_t SpanExtent>
-    [[nodiscard]]
-    ATTRIBUTE_PURE
-    ATTRIBUTE_ALWAYS_INLINE
-    constexpr MappedType operator()(std::span<const CharType, SpanExtent> str) const noexcept {
-        // clang-format on
-        return operator()(str.data(), str.size());
+    static void Reset() {
+        Registry& registry = GetRegistry();
+        const std::lock_guard lock(registry.mutex);
+        registry.retired_stats = {};
+        generation_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static void Record(LookupExit exit, std::size_t depth) noexcept {
+        thread_local ThreadCountersHandle handle;
+        handle.counters.Record(exit, depth, generation_.load(std::memory_order_relaxed));
     }
-#endif
 
 private:
-    using NodeIndex = std::uint32_t;
+    struct Registry final {
+        std::mutex mutex;
+        std::vector<ThreadLookupCounters*> live_counters;
+        StringMapStats retired_stats{};
+    };
 
-    static constexpr NodeIndex kRootNodeIndex      = TrieParams.kRootNodeIndex;
-    static constexpr std::size_t kTrieAlphabetSize = TrieParams.trie_alphabet_size;
-    static constexpr std::size_t kNodesSize        = TrieParams.nodes_size;
+    struct ThreadCountersHandle final {
+        ThreadCountersHandle() {
+            Registry& registry = GetRegistry();
+            const std::lock_guard lock(registry.mutex);
+            counters.generation.store(generation_.load(std::memory_order_relaxed),
+                                      std::memory_order_relaxed);
+            registry.live_counters.push_back(&counters);
+        }
+        ThreadCountersHandle(const ThreadCountersHandle&)            = delete;
+        ThreadCountersHandle& operator=(const ThreadCountersHandle&) = delete;
+        ~ThreadCountersHandle() {
+            Registry& registry = GetRegistry();
+            const std::lock_guard lock(registry.mutex);
+            counters.AddTo(registry.retired_stats, generation_.load(std::memory_order_relaxed));
+            std::erase(registry.live_counters, &counters);
+        }
 
-    struct TrieNodeImpl final {
-        std::array<NodeIndex, kTrieAlphabetSize> edges{};
-        MappedType node_value = kDefaultValue;
+        ThreadLookupCounters counters;
     };
-    std::array<TrieNodeImpl, kNodesSize> nodes_
-#if !(defined(__GNUC__) && defined(__GNUC_MINOR__) && __GNUC__ == 13 && __GNUC_MINOR__ == 1)
-    // `internal compiler error: Segmentation fault` on gcc 13.1, see https://godbolt.org/z/6EWrd8sGG
-    {}
-#endif
-    ;
 
-    template <std::size_t CurrentPackIndex, string_map_detail::CompileTimeStringLiteral String,
-              string_map_detail::CompileTimeStringLiteral... AddStrings>
-    STRING_MAP_CONSTEVAL void AddPattern(std::size_t first_free_node_index) noexcept {
-        std::size_t current_node_index = 0;
-        constexpr std::size_t len      = String.size();
-        for (std::size_t i = 0; i < len; i++) {
-            std::size_t symbol_index    = TrieParams.CharToNodeIndex(String[i]);
-            std::size_t next_node_index = nodes_[current_node_index].edges[symbol_index];
-            if (next_node_index == 0) {
-                nodes_[current_node_index].edges[symbol_index] =
-                    static_cast<NodeIndex>(first_free_node_index);
-                next_node_index = first_free_node_index;
-                first_free_node_index++;
-            }
-            current_node_index = next_node_index;
-        }
+    // Incremented by every reset, constant initialized so the lookups read it without a guard
+    static inline std::atomic<std::uint64_t> generation_{0};
 
-        const bool already_added_string = nodes_[current_node_index].node_value != kDefaultValue;
-        // HINT: Remove duplicate strings from the StringMatch / StringMap
-        [[maybe_unused]] const auto duplicate_strings_check = 0 / !already_added_string;
+    static Registry& GetRegistry() {
+        static Registry registry;
+        return registry;
+    }
+};
 
-        static_assert(CurrentPackIndex < MappedValues.size(), "impl error");
-        nodes_[current_node_index].node_value = MappedValues[CurrentPackIndex];
-        if constexpr (sizeof...(AddStrings) >= 1) {
-            AddPattern<CurrentPackIndex + 1, AddStrings...>(first_free_node_index);
-        }
+#endif
+
+template <class MapType>
+ATTRIBUTE_ALWAYS_INLINE constexpr void RecordLookup([[maybe_unused]] LookupExit exit,
+                                                    [[maybe_unused]] std::size_t depth) noexcept {
+#if STRING_MAP_ENABLE_STATS
+    if (!std::is_constant_evaluated()) {
+        LookupCountersRegistry<MapType>::Record(exit, depth);
     }
+#endif
+}
 
-    // clang-format off
-    template <class IteratorType, class SentinelIteratorType>
-    ATTRIBUTE_PURE
-    constexpr MappedType operator_call_impl(IteratorType begin, SentinelIteratorType end) const noexcept {
-        // clang-format on
+template <class MapType>
+[[nodiscard]] inline StringMapStats GetLookupStats() {
+#if STRING_MAP_ENABLE_STATS
+    return LookupCountersRegistry<MapType>::Snapshot();
+#else
+    return {};
+#endif
+}
 
-#if defined(__cpp_lib_unreachable) && __cpp_lib_unreachable >= 202202L
-#define UNREACHABLE() std::unreachable()
-#elif CONFIG_HAS_BUILTIN(__builtin_unreachable)
-#define UNREACHABLE() __builtin_unreachable()
-#elif CONFIG_HAS_BUILTIN(__builtin_assume)
-#define UNREACHABLE() __builtin_assume(false)
-#elif CONFIG_HAS_AT_LEAST_CXX_23 && CONFIG_HAS_CPP_ATTRIBUTE(assume)
-#define UNREACHABLE() [[assume(false)]]
-#elif CONFIG_GNUC_PREREQ(13, 0) && CONFIG_HAS_ATTRIBUTE(assume)
-#define UNREACHABLE() __attribute__((assume(false)))
+template <class MapType>
+inline void ResetLookupStats() {
+#if STRING_MAP_ENABLE_STATS
+    LookupCountersRegistry<MapType>::Reset();
 #endif
+}
 
-        std::size_t current_node_index = kRootNodeIndex;
-        for (std::size_t height = 0; begin != end; ++begin, ++height) {
-            std::size_t index = TrieParams.CharToNodeIndex(*begin);
-            if (index >= kTrieAlphabetSize) {
-                return kDefaultValue;
-            }
+}  // namespace stats
 
-            std::size_t next_node_index = nodes_[current_node_index].edges[index];
-            if (next_node_index != 0) {
-                current_node_index = next_node_index;
-            } else {
-                return kDefaultValue;
-            }
+namespace cpu {
 
-            if (height > TrieParams.max_tree_height) {
-                UNREACHABLE();
-            }
-        }
+// Instruction set extensions of the host used by the lookups
+struct CpuFeatures final {
+    bool bmi2{};
+    // pext is microcoded on AMD before Zen 3 (tens of cycles), so it is not used there
+    bool fast_pext{};
+};
 
-        const auto returned_value = nodes_[current_node_index].node_value;
+[[nodiscard]] inline CpuFeatures DetectCpuFeatures() noexcept {
+#if STRING_MAP_HAS_BMI2
+    return {.bmi2 = true, .fast_pext = true};
+#elif STRING_MAP_HAS_CPU_DISPATCH
+    __builtin_cpu_init();
+    const bool bmi2      = __builtin_cpu_supports("bmi2");
+    const bool slow_pext = __builtin_cpu_is("znver1") || __builtin_cpu_is("znver2");
+    return {.bmi2 = bmi2, .fast_pext = bmi2 && !slow_pext};
+#else
+    return {};
+#endif
+}
 
-        if constexpr (kMappedTypesInfo.ordered) {
-            if (returned_value != kDefaultValue && (returned_value < kMappedTypesInfo.min_value ||
-                                                    returned_value > kMappedTypesInfo.max_value)) {
-                UNREACHABLE();
-            }
-        }
+/**
+ * Detected on the first use (thread safe), so there is no dynamic initializer in every
+ *  translation unit and the maps used by the other static initializers see the real
+ *  features. Later calls cost one well predicted check of the initialization guard.
+ */
+[[nodiscard]] inline const CpuFeatures& GetCpuFeatures() noexcept {
+    static const CpuFeatures features = DetectCpuFeatures();
+    return features;
+}
 
-#undef UNREACHABLE
+#if STRING_MAP_HAS_CPU_DISPATCH
+// Should be called only if GetCpuFeatures().bmi2 is set; inline asm does not require
+//  the translation unit to be built with -mbmi2
+[[nodiscard]] ATTRIBUTE_CONST ATTRIBUTE_ALWAYS_INLINE inline std::uint64_t Pext(
+    std::uint64_t word, std::uint64_t mask) noexcept {
+    std::uint64_t result;
+    asm("{pextq %2, %1, %0|pext %0, %1, %2}" : "=r"(result) : "r"(word), "rm"(mask));
+    return result;
+}
+#endif
 
-        return returned_value;
-    }
+}  // namespace cpu
 
-    struct TMappedTypesInfo final {
-        static constexpr bool kMaybeOrdered =
-            std::is_arithmetic_v<MappedType> ||
-            (std::is_enum_v<MappedType> && requires(MappedType x, MappedType y) {
-                { x < y } -> std::same_as<bool>;
+enum class StringMapBackend {
+    // kCompare for a few short strings, kTrie otherwise
+    kAuto,
+    // Sequential comparison with every added string
+    kCompare,
+    // Trie with a dense array of edges in every node
+    kTrie,
+    // Adaptive radix tree, node layout depends on the number of children. Smaller and
+    //  slower than kTrie, never selected by kAuto
+    kArt,
+    // Trie with the equivalent subtrees merged, fewer nodes for the keys with common suffixes
+    kDawg,
+    // Keys told apart by the length and a few chars, one compare with the only candidate
+    kPositions,
+    // Keys up to 16 chars packed into the integers, binary search over them
+    kPacked,
+    // Trie walked for the max key length steps without branches on the input
+    kFixedWork,
+    // Sorted 8 char key prefixes in the BFS order, branchless search with prefetch
+    kEytzinger,
+};
+
+// Keys of the map as a type, used to build new maps from the existing ones
+template <CompileTimeStringLiteral... Strings>
+struct KeysList final {};
+
+enum class StringMapMergePolicy {
+    // Value from the map which goes first in the list of the merged maps is used
+    kFirstWins,
+    // Value from the map which goes last in the list of the merged maps is used
+    kLastWins,
+    // Compile time error if some string is added to several maps
+    kError,
+};
+
+/**
+ * Tag which guarantees that at least Padding bytes after the end
+ *  of the string passed to the map are readable (like simdjson padding).
+ */
+template <std::size_t Padding>
+struct PaddedInput final {
+    static constexpr std::size_t kPadding = Padding;
+};
+
+/**
+ * Compile time sizes of the tables used by the lookup, see kFootprint of the
+ *  StringMatch / StringMap.
+ */
+struct StringMapFootprint final {
+    // kAuto for the maps which are not built by a backend (StringGlobMap, SegmentedStringMap)
+    StringMapBackend backend{};
+    std::size_t strings_count{};
+    // Number of the trie nodes (DFA states, segment tree nodes), 0 if there are no nodes
+    std::size_t nodes_count{};
+    std::size_t alphabet_size{};
+    std::size_t bytes_per_node{};
+    // Total size of the static tables the lookup may touch
+    std::size_t table_bytes{};
+    // Length of the longest string, i.e. max number of steps of the lookup
+    std::size_t max_depth{};
+};
+
+template <std::size_t BytesBudget, class MapType>
+struct BudgetCheckedMap final {
+    // HINT: Split the map, use another backend or increase the budget
+    static_assert(MapType::kFootprint.table_bytes <= BytesBudget,
+                  "Tables of the StringMatch / StringMap exceed the bytes budget");
+    using type = MapType;
+};
+
+/**
+ * Node of the list of the footprints registered by STRING_MAP_REGISTER_FOOTPRINT.
+ * Registrars are static objects, so the list is built during the static initialization
+ *  without allocations. Same name registered by several translation units (the macro
+ *  in the header) is listed once.
+ */
+class [[nodiscard]] FootprintRegistrar final {
+public:
+    FootprintRegistrar(std::string_view name, const StringMapFootprint& footprint) noexcept
+        : name_(name), footprint_(footprint) {
+        List& list = GetList();
+        for (const FootprintRegistrar* registrar = list.head; registrar != nullptr;
+             registrar = registrar->next_) {
+            if (registrar->name_ == name) {
+                return;
+            }
+        }
+        if (list.head == nullptr) {
+            list.head = this;
+        } else {
+            list.tail->next_ = this;
+        }
+        list.tail = this;
+    }
+    FootprintRegistrar(const FootprintRegistrar&)            = delete;
+    FootprintRegistrar& operator=(const FootprintRegistrar&) = delete;
+
+    // Calls callback(name, footprint) for every registered map in the registration order
+    template <class Callback>
+    static void ForEach(Callback&& callback) {
+        for (const FootprintRegistrar* registrar = GetList().head; registrar != nullptr;
+             registrar = registrar->next_) {
+            callback(registrar->name_, registrar->footprint_);
+        }
+    }
+
+private:
+    struct List final {
+        FootprintRegistrar* head = nullptr;
+        FootprintRegistrar* tail = nullptr;
+    };
+
+    static List& GetList() noexcept {
+        static List list;
+        return list;
+    }
+
+    std::string_view name_;
+    StringMapFootprint footprint_;
+    FootprintRegistrar* next_ = nullptr;
+};
+
+// Result of the match_until: mapped value (or default) and the position where the match stopped
+template <class MappedType>
+struct StringMapMatchResult final {
+    MappedType value;
+    std::size_t position;
+};
+
+// Result of the find_within_distance: closest entry (nullptr if none) and its edit distance
+template <class Entry>
+struct StringMapDistanceMatch final {
+    const Entry* entry;
+    std::size_t distance;
+};
+
+// Key and value of the map as returned by the ordered queries
+template <class MappedType>
+struct StringMapEntry final {
+    std::string_view key;
+    MappedType value;
+};
+
+// Contiguous range of the entries sorted by the key
+template <class Entry>
+class [[nodiscard]] StringMapEntriesRange final {
+public:
+    using value_type     = Entry;
+    using iterator       = const Entry*;
+    using const_iterator = const Entry*;
+
+    constexpr StringMapEntriesRange(const Entry* begin, const Entry* end) noexcept
+        : begin_(begin), end_(end) {}
+
+    [[nodiscard]] constexpr const Entry* begin() const noexcept {
+        return begin_;
+    }
+    [[nodiscard]] constexpr const Entry* end() const noexcept {
+        return end_;
+    }
+    [[nodiscard]] constexpr std::size_t size() const noexcept {
+        return static_cast<std::size_t>(end_ - begin_);
+    }
+    [[nodiscard]] constexpr bool empty() const noexcept {
+        return begin_ == end_;
+    }
+    [[nodiscard]] constexpr const Entry& operator[](std::size_t index) const noexcept {
+        return begin_[index];
+    }
+
+private:
+    const Entry* begin_;
+    const Entry* end_;
+};
+
+namespace string_map_impl {
+
+/**
+ * Rows of the Levenshtein distance DP D[i][j] between the first i chars of the key
+ *  and the first j chars of the str. Only the band j in [i - kMaxDistance, i + kMaxDistance]
+ *  is stored, cells outside of it and values above max_distance are max_distance + 1.
+ */
+struct EditDistanceBand final {
+    static constexpr std::size_t kMaxDistance = 7;
+    static constexpr std::size_t kWidth       = 2 * kMaxDistance + 1;
+    using Row                                 = std::array<std::uint8_t, kWidth>;
+
+    // Row D[0][*] of the empty key prefix
+    [[nodiscard]] static constexpr Row FirstRow(std::size_t str_size,
+                                                std::size_t max_distance) noexcept {
+        Row row{};
+        for (std::size_t offset = 0; offset < kWidth; offset++) {
+            row[offset] = offset >= kMaxDistance && offset - kMaxDistance <= str_size
+                              ? Cap(offset - kMaxDistance, max_distance)
+                              : Cap(max_distance + 1, max_distance);
+        }
+        return row;
+    }
+    // Fills D[depth][*] from D[depth - 1][*] where chr is the char number depth of the key.
+    //  Returns min value of the row, the key can't be extended if it's above max_distance
+    static constexpr std::size_t NextRow(const Row& prev_row, Row& row, std::size_t depth,
+                                         char chr, std::string_view str,
+                                         std::size_t max_distance) noexcept {
+        const std::size_t infinity = max_distance + 1;
+        std::size_t row_min        = infinity;
+        for (std::size_t offset = 0; offset < kWidth; offset++) {
+            // j = depth + offset - kMaxDistance
+            if (depth + offset < kMaxDistance || depth + offset - kMaxDistance > str.size()) {
+                row[offset] = static_cast<std::uint8_t>(infinity);
+                continue;
+            }
+            const std::size_t j = depth + offset - kMaxDistance;
+            std::size_t value   = infinity;
+            if (offset + 1 < kWidth) {
+                // Char of the key is deleted
+                value = std::min(value, std::size_t{prev_row[offset + 1]} + 1);
+            }
+            if (j > 0) {
+                // Char of the key is replaced by str[j - 1] or is equal to it
+                value = std::min(value,
+                                 std::size_t{prev_row[offset]} + (chr != str[j - 1] ? 1 : 0));
+                if (offset > 0) {
+                    // str[j - 1] is inserted
+                    value = std::min(value, std::size_t{row[offset - 1]} + 1);
+                }
+            }
+            row[offset] = Cap(value, max_distance);
+            row_min     = std::min(row_min, std::size_t{row[offset]});
+        }
+        return row_min;
+    }
+    // D[depth][str_size], i.e. distance between the key of length depth and the str
+    [[nodiscard]] static constexpr std::size_t Distance(const Row& row, std::size_t depth,
+                                                        std::size_t str_size,
+                                                        std::size_t max_distance) noexcept {
+        if (str_size + kMaxDistance < depth || str_size > depth + kMaxDistance) {
+            return max_distance + 1;
+        }
+        return row[str_size + kMaxDistance - depth];
+    }
+
+private:
+    [[nodiscard]] static constexpr std::uint8_t Cap(std::size_t value,
+                                                    std::size_t max_distance) noexcept {
+        return static_cast<std::uint8_t>(std::min(value, max_distance + 1));
+    }
+};
+
+/**
+ * Entries of the map sorted by the key. Order is the same as the one of the
+ *  std::string_view comparison (chars are compared as unsigned chars), i.e.
+ *  the order of the trie DFS.
+ */
+template <std::array MappedValues, CompileTimeStringLiteral... Strings>
+class SortedEntriesTable final {
+public:
+    using MappedType = typename decltype(MappedValues)::value_type;
+    using Entry      = StringMapEntry<MappedType>;
+    using Range      = StringMapEntriesRange<Entry>;
+
+    static constexpr std::size_t kSize = sizeof...(Strings);
+
+private:
+    static constexpr std::array<std::string_view, kSize> kKeys = {
+        std::string_view(Strings.value.data(), Strings.length)...,
+    };
+
+    STRING_MAP_CONSTEVAL static std::array<std::size_t, kSize> Order() noexcept {
+        std::array<std::size_t, kSize> order{};
+        // Insertion sort, number of strings is small and the std::sort
+        //  is not constexpr with _GLIBCXX_DEBUG
+        for (std::size_t i = 0; i < kSize; i++) {
+            std::size_t j = i;
+            for (; j > 0 && kKeys[i] < kKeys[order[j - 1]]; j--) {
+                order[j] = order[j - 1];
+            }
+            order[j] = i;
+        }
+        return order;
+    }
+
+    template <std::size_t... Ranks>
+    STRING_MAP_CONSTEVAL static std::array<Entry, kSize> Entries(
+        std::index_sequence<Ranks...>) noexcept {
+        return {
+            Entry{kKeys[kOrder[Ranks]], MappedValues[kOrder[Ranks]]}...,
+        };
+    }
+
+public:
+    // kOrder[rank] is the index of the string with this rank in the Strings...
+    static constexpr std::array<std::size_t, kSize> kOrder = Order();
+    static constexpr std::array<Entry, kSize> kEntries =
+        Entries(std::make_index_sequence<kSize>{});
+
+    [[nodiscard]] static constexpr Range all() noexcept {
+        return Range(kEntries.data(), kEntries.data() + kSize);
+    }
+    [[nodiscard]] static constexpr const Entry* at_rank(std::size_t rank) noexcept {
+        return kEntries.data() + rank;
+    }
+    // First rank in [from, to) with the key >= str (or > str if Upper is true)
+    template <bool Upper>
+    [[nodiscard]] static constexpr std::size_t bound(std::size_t from, std::size_t to,
+                                                     std::string_view str) noexcept {
+        while (from < to) {
+            const std::size_t middle = from + (to - from) / 2;
+            const std::string_view key = kEntries[middle].key;
+            if (Upper ? !(str < key) : key < str) {
+                from = middle + 1;
+            } else {
+                to = middle;
+            }
+        }
+        return from;
+    }
+    // First rank in [from, to) with the key[position] >= chr (or > chr if Upper is true),
+    //  all keys in [from, to) should be longer than position and share the first
+    //  position chars
+    template <bool Upper>
+    [[nodiscard]] static constexpr std::size_t char_bound(std::size_t from, std::size_t to,
+                                                          std::size_t position,
+                                                          char chr) noexcept {
+        while (from < to) {
+            const std::size_t middle = from + (to - from) / 2;
+            const char key_chr       = kEntries[middle].key[position];
+            if (Upper ? !std::char_traits<char>::lt(chr, key_chr)
+                      : std::char_traits<char>::lt(key_chr, chr)) {
+                from = middle + 1;
+            } else {
+                to = middle;
+            }
+        }
+        return from;
+    }
+    // match_until over the sorted keys, see StringMapImplManyStrings::match_until for the
+    //  result. Keys prefixed by the matched chars are one range of the ranks, every char
+    //  narrows it with two binary searches on this char only: O(length * log(keys)) char
+    //  comparisons, no key is compared as a whole
+    template <MappedType DefaultMapValue, class IsDelimiter>
+    [[nodiscard]] static constexpr StringMapMatchResult<MappedType> MatchUntil(
+        std::string_view buffer, IsDelimiter is_delimiter) noexcept {
+        // Keys in [from, to) are prefixed by buffer[0, position), they are contiguous
+        //  in the sorted order and the key equal to the prefix (if any) is the first one
+        std::size_t from = 0;
+        std::size_t to   = kSize;
+        for (std::size_t position = 0;; position++) {
+            if (position == buffer.size() || is_delimiter(buffer[position])) {
+                return kEntries[from].key.size() == position
+                           ? StringMapMatchResult<MappedType>{kEntries[from].value, position}
+                           : StringMapMatchResult<MappedType>{DefaultMapValue, position};
+            }
+            from += kEntries[from].key.size() == position;
+            const char chr = buffer[position];
+            from           = char_bound<false>(from, to, position, chr);
+            to             = char_bound<true>(from, to, position, chr);
+            if (from == to) {
+                return {DefaultMapValue, position};
+            }
+        }
+    }
+    // Calls callback(entry, distance) for every key within the max_distance
+    //  (at most EditDistanceBand::kMaxDistance) from the str
+    template <class Callback>
+    static constexpr void ForEachWithinDistance(std::string_view str, std::size_t max_distance,
+                                                Callback& callback) {
+        for (const Entry& entry : kEntries) {
+            EditDistanceBand::Row row = EditDistanceBand::FirstRow(str.size(), max_distance);
+            EditDistanceBand::Row next_row{};
+            bool pruned = false;
+            for (std::size_t i = 0; i < entry.key.size() && !pruned; i++) {
+                pruned = EditDistanceBand::NextRow(row, next_row, i + 1, entry.key[i], str,
+                                                   max_distance) > max_distance;
+                row = next_row;
+            }
+            if (pruned) {
+                continue;
+            }
+            const std::size_t distance =
+                EditDistanceBand::Distance(row, entry.key.size(), str.size(), max_distance);
+            if (distance <= max_distance) {
+                callback(entry, distance);
+            }
+        }
+    }
+    // First rank in [from, to) with the key which is not prefixed by the prefix,
+    //  all keys in [from, to) should be >= prefix
+    [[nodiscard]] static constexpr std::size_t prefix_end(std::size_t from, std::size_t to,
+                                                          std::string_view prefix) noexcept {
+        while (from < to) {
+            const std::size_t middle = from + (to - from) / 2;
+            if (kEntries[middle].key.starts_with(prefix)) {
+                from = middle + 1;
+            } else {
+                to = middle;
+            }
+        }
+        return from;
+    }
+};
+
+/**
+ * Ordered and typo-tolerant queries answered with the binary search / scan over
+ *  the sorted entries, for the backends which can't answer them with their own tables.
+ */
+template <std::array MappedValues, CompileTimeStringLiteral... Strings>
+class SortedEntriesQueries {
+    using SortedEntries = SortedEntriesTable<MappedValues, Strings...>;
+
+public:
+    using Entry         = typename SortedEntries::Entry;
+    using EntriesRange  = typename SortedEntries::Range;
+    using EntryIterator = const Entry*;
+    using DistanceMatch = StringMapDistanceMatch<Entry>;
+
+    static constexpr std::size_t kMaxEditDistance = EditDistanceBand::kMaxDistance;
+
+    /**
+     * All entries of the map sorted by the key.
+     */
+    [[nodiscard]] static constexpr EntriesRange entries() noexcept {
+        return SortedEntries::all();
+    }
+    /**
+     * Entries with the keys starting with the prefix, sorted by the key.
+     */
+    [[nodiscard]] static constexpr EntriesRange prefix_range(std::string_view prefix) noexcept {
+        const std::size_t begin =
+            SortedEntries::template bound</*Upper = */ false>(0, SortedEntries::kSize, prefix);
+        const std::size_t end = SortedEntries::prefix_end(begin, SortedEntries::kSize, prefix);
+        return EntriesRange(SortedEntries::at_rank(begin), SortedEntries::at_rank(end));
+    }
+    /**
+     * First entry with the key >= str or entries().end()
+     */
+    [[nodiscard]] static constexpr EntryIterator lower_bound(std::string_view str) noexcept {
+        return SortedEntries::at_rank(
+            SortedEntries::template bound</*Upper = */ false>(0, SortedEntries::kSize, str));
+    }
+    /**
+     * First entry with the key > str or entries().end()
+     */
+    [[nodiscard]] static constexpr EntryIterator upper_bound(std::string_view str) noexcept {
+        return SortedEntries::at_rank(
+            SortedEntries::template bound</*Upper = */ true>(0, SortedEntries::kSize, str));
+    }
+
+    /**
+     * Calls callback(entry, distance) for every entry whose key is within the
+     *  Levenshtein distance max_distance (at most kMaxEditDistance) from the str,
+     *  in the order of the keys.
+     */
+    template <class Callback>
+    static constexpr void for_each_within_distance(std::string_view str,
+                                                   std::size_t max_distance, Callback callback) {
+        max_distance = std::min(max_distance, kMaxEditDistance);
+        SortedEntries::ForEachWithinDistance(str, max_distance, callback);
+    }
+    /**
+     * Closest entry within the Levenshtein distance max_distance (at most kMaxEditDistance)
+     *  from the str, first in the order of the keys on ties. Entry is nullptr if there is none.
+     */
+    [[nodiscard]] static constexpr DistanceMatch find_within_distance(std::string_view str,
+                                                                      std::size_t max_distance) {
+        max_distance = std::min(max_distance, kMaxEditDistance);
+        DistanceMatch best{nullptr, max_distance + 1};
+        for_each_within_distance(str, max_distance,
+                                 [&best](const Entry& entry, std::size_t distance) constexpr {
+                                     if (distance < best.distance) {
+                                         best = {&entry, distance};
+                                     }
+                                 });
+        return best.entry != nullptr ? best : DistanceMatch{nullptr, 0};
+    }
+};
+
+/**
+ * Trie over the sorted keys with the nodes in the BFS order, so children of the node
+ *  always go after it. Keys with ranks [begin, end) share first depth chars of the node.
+ * Used at compile time by the backends which lay the trie out in their own way.
+ */
+template <std::size_t NodesSize, std::array MappedValues, CompileTimeStringLiteral... Strings>
+class SortedKeysTrie final {
+    using SortedEntries = SortedEntriesTable<MappedValues, Strings...>;
+
+public:
+    struct Node final {
+        std::size_t depth{};
+        std::size_t begin{};
+        std::size_t end{};
+        // Children are [first_child, first_child + children_count), sorted by the char
+        std::size_t first_child{};
+        std::size_t children_count{};
+    };
+
+    [[nodiscard]] static constexpr std::string_view Key(std::size_t rank) noexcept {
+        return SortedEntries::kEntries[rank].key;
+    }
+    // Key of the node itself (if any) goes first in the subtree
+    [[nodiscard]] static constexpr bool IsTerminal(const Node& node) noexcept {
+        return Key(node.begin).size() == node.depth;
+    }
+    // Char on the edge from the parent of the node
+    [[nodiscard]] static constexpr char EdgeChar(const Node& node) noexcept {
+        return Key(node.begin)[node.depth - 1];
+    }
+
+private:
+    STRING_MAP_CONSTEVAL static std::array<Node, NodesSize> BuildNodes() noexcept {
+        std::array<Node, NodesSize> nodes{};
+        nodes[0].end            = SortedEntries::kSize;
+        std::size_t nodes_count = 1;
+        // BFS, children of the node are the groups of its keys with the same char at depth
+        for (std::size_t i = 0; i < nodes_count; i++) {
+            Node& node       = nodes[i];
+            std::size_t rank = node.begin + IsTerminal(node);
+            node.first_child = nodes_count;
+            while (rank < node.end) {
+                const char chr        = Key(rank)[node.depth];
+                std::size_t group_end = rank + 1;
+                while (group_end < node.end && Key(group_end)[node.depth] == chr) {
+                    group_end++;
+                }
+                Node& child = nodes[nodes_count++];
+                child.depth = node.depth + 1;
+                child.begin = rank;
+                child.end   = group_end;
+                rank        = group_end;
+            }
+            node.children_count = nodes_count - node.first_child;
+        }
+        return nodes;
+    }
+
+public:
+    static constexpr std::array<Node, NodesSize> kNodes = BuildNodes();
+};
+
+/**
+ * Strings of the map stored one after another with the 8 bytes padding, so
+ *  they can be compared with the padded input using full-width unaligned loads.
+ */
+template <CompileTimeStringLiteral... Strings>
+class PaddedStringsTable final {
+    using Word = std::uint64_t;
+
+    static constexpr std::size_t kStringsCount = sizeof...(Strings);
+    static constexpr std::array<std::size_t, kStringsCount> kLengths = {Strings.size()...};
+
+    STRING_MAP_CONSTEVAL static std::array<std::size_t, kStringsCount> Offsets() noexcept {
+        std::array<std::size_t, kStringsCount> offsets{};
+        std::size_t offset = 0;
+        for (std::size_t i = 0; i < kStringsCount; i++) {
+            offsets[i] = offset;
+            offset += kLengths[i];
+        }
+        return offsets;
+    }
+    static constexpr std::array<std::size_t, kStringsCount> kOffsets = Offsets();
+    static constexpr std::size_t kTotalLength = (Strings.size() + ...);
+
+    STRING_MAP_CONSTEVAL static std::array<char, kTotalLength + sizeof(Word)> Bytes() noexcept {
+        std::array<char, kTotalLength + sizeof(Word)> bytes{};
+        std::size_t offset = 0;
+        (..., (std::char_traits<char>::copy(bytes.data() + offset, Strings.value.data(),
+                                            Strings.size()),
+               offset += Strings.size()));
+        return bytes;
+    }
+    static constexpr std::array<char, kTotalLength + sizeof(Word)> kBytes = Bytes();
+
+    ATTRIBUTE_ALWAYS_INLINE static Word LoadWord(const void* ptr) noexcept {
+        Word word;
+        std::memcpy(&word, ptr, sizeof(word));
+        return word;
+    }
+    // Mask of the first bytes_count (in 1...7) bytes of the loaded word
+    ATTRIBUTE_CONST ATTRIBUTE_ALWAYS_INLINE static Word FirstBytesMask(
+        std::size_t bytes_count) noexcept {
+        const auto bits = static_cast<unsigned>(bytes_count * 8);
+        if constexpr (std::endian::native == std::endian::big) {
+            return ~Word{0} << (64 - bits);
+        } else {
+            return (Word{1} << bits) - 1;
+        }
+    }
+
+public:
+    static constexpr std::size_t kMinPadding = sizeof(Word) - 1;
+
+    [[nodiscard]] static constexpr std::size_t length(std::size_t string_index) noexcept {
+        return kLengths[string_index];
+    }
+
+    /**
+     * Checks that input[from, length(string_index)) is equal to the same part of
+     *  the string with the index string_index. Input should have at least kMinPadding
+     *  readable bytes after the input + length(string_index).
+     */
+    [[nodiscard]] ATTRIBUTE_PURE ATTRIBUTE_ALWAYS_INLINE static bool EqualsSuffix(
+        std::size_t string_index, const void* input, std::size_t from) noexcept {
+        const auto* const input_bytes  = static_cast<const unsigned char*>(input);
+        const char* const string_bytes = kBytes.data() + kOffsets[string_index];
+        const std::size_t len          = kLengths[string_index];
+        Word difference                = 0;
+        std::size_t pos                = from;
+        for (; pos + sizeof(Word) <= len; pos += sizeof(Word)) {
+            difference |= LoadWord(input_bytes + pos) ^ LoadWord(string_bytes + pos);
+        }
+        if (pos < len) {
+            difference |= (LoadWord(input_bytes + pos) ^ LoadWord(string_bytes + pos)) &
+                          FirstBytesMask(len - pos);
+        }
+        return difference == 0;
+    }
+};
+
+template <trie_tools::TrieParamsType TrieParams, std::array MappedValues,
+          typename decltype(MappedValues)::value_type DefaultMapValue, CompileTimeStringLiteral... Strings>
+class [[nodiscard]] StringMapImplManyStrings final {
+    static_assert(0 < TrieParams.min_char && TrieParams.min_char <= TrieParams.max_char &&
+                      TrieParams.max_char <= std::numeric_limits<std::uint8_t>::max(),
+                  "Empty string was passed in StringMatch / StringMap");
+    static_assert(sizeof...(Strings) == std::size(MappedValues) && std::size(MappedValues) > 0,
+                  "internal error");
+
+    template <bool InCompileTime, bool ForceUnsignedChar = false>
+    struct [[nodiscard]] InternalIterator final {
+        using iterator_category = std::random_access_iterator_tag;
+        using difference_type   = std::ptrdiff_t;
+        using value_type = std::conditional_t<InCompileTime && !ForceUnsignedChar, const char,
+                                              const unsigned char>;
+        using pointer    = value_type*;
+        using reference  = value_type&;
+
+        template <class CharType>
+        ATTRIBUTE_ALWAYS_INLINE explicit constexpr InternalIterator(const CharType* str) noexcept {
+            if constexpr (InCompileTime || std::is_same_v<CharType, value_type>) {
+                pointer_ = str;
+            } else {
+#if STRING_MAP_HAS_BIT
+                pointer_ = std::bit_cast<pointer>(str);
+#else
+                pointer_ = reinterpret_cast<pointer>(str);
+#endif
+            }
+        }
+        ATTRIBUTE_ALWAYS_INLINE constexpr InternalIterator& operator++() noexcept {
+            ++pointer_;
+            return *this;
+        }
+        [[nodiscard]] ATTRIBUTE_ALWAYS_INLINE constexpr value_type operator*() const noexcept {
+            return *pointer_;
+        }
+        [[nodiscard]] ATTRIBUTE_ALWAYS_INLINE constexpr value_type operator[](
+            std::size_t index) const noexcept {
+            return pointer_[index];
+        }
+        [[nodiscard]] ATTRIBUTE_CONST ATTRIBUTE_ALWAYS_INLINE constexpr bool operator==(
+            const InternalIterator& other) const noexcept {
+            return pointer_ == other.pointer_;
+        }
+        struct CStringSentinel {};
+        [[nodiscard]] ATTRIBUTE_PURE ATTRIBUTE_ALWAYS_INLINE constexpr bool operator==(
+            const CStringSentinel&) const noexcept {
+            return *pointer_ == '\0';
+        }
+
+        pointer pointer_{};
+    };
+
+public:
+    using MappedType = typename decltype(MappedValues)::value_type;
+    static_assert(std::is_copy_assignable_v<MappedType>);
+
+    static constexpr MappedType kDefaultValue = DefaultMapValue;
+    static constexpr char kMinChar            = static_cast<char>(TrieParams.min_char);
+    static constexpr char kMaxChar            = static_cast<char>(TrieParams.max_char);
+    static constexpr bool kStatsEnabled       = STRING_MAP_ENABLE_STATS;
+    static constexpr StringMapBackend kBackend = StringMapBackend::kTrie;
+    static constexpr auto kMappedValues        = MappedValues;
+    using KeysType                             = KeysList<Strings...>;
+
+    /**
+     * Lookup counters aggregated over all threads. Counters are shared by all
+     *  objects of the same map type. Always empty if STRING_MAP_ENABLE_STATS is 0.
+     */
+    [[nodiscard]] static stats::StringMapStats stats() {
+        return stats::GetLookupStats<StringMapImplManyStrings>();
+    }
+    static void reset_stats() {
+        stats::ResetLookupStats<StringMapImplManyStrings>();
+    }
+
+    // Zero size handle, the trie is the static kNodes table
+    STRING_MAP_CONSTEVAL StringMapImplManyStrings() noexcept = default;
+
+    constexpr MappedType operator()(std::nullptr_t) const noexcept              = delete;
+    constexpr MappedType operator()(std::nullptr_t, std::size_t) const noexcept = delete;
+
+    // clang-format off
+    template <class CharType>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(std::basic_string_view<CharType> str) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size());
+    }
+    // clang-format off
+    template <class CharType>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(const std::basic_string<CharType>& str) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size());
+    }
+    // clang-format off
+    template <class CharType>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    ATTRIBUTE_SIZED_ACCESS(read_only, 2, 3)
+    constexpr MappedType operator()(const CharType* str, std::size_t size) const noexcept {
+        // clang-format on
+        if (std::is_constant_evaluated()) {
+            if constexpr (std::is_same_v<CharType, char>) {
+                using IteratorType = InternalIterator</*InCompileTime = */ true>;
+                return operator_call_impl(IteratorType(str), IteratorType(str + size));
+            } else {
+                using IteratorType =
+                    InternalIterator</*InCompileTime = */ true, /*ForceUnsignedChar = */ true>;
+                return operator_call_impl(IteratorType(str), IteratorType(str + size));
+            }
+        } else {
+            if constexpr (std::is_same_v<CharType, char>) {
+                using IteratorType = InternalIterator</*InCompileTime = */ false>;
+                return operator_call_impl(IteratorType(str), IteratorType(str + size));
+            } else {
+                using IteratorType =
+                    InternalIterator</*InCompileTime = */ false, /*ForceUnsignedChar = */ true>;
+                return operator_call_impl(IteratorType(str), IteratorType(str + size));
+            }
+        }
+    }
+    // clang-format off
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    ATTRIBUTE_ACCESS(read_only, 2)
+    constexpr MappedType operator()(const char* str) const noexcept {
+        // clang-format on
+        if (str == nullptr) [[unlikely]] {
+            return kDefaultValue;
+        }
+        if (std::is_constant_evaluated()) {
+            using IteratorType = InternalIterator</*InCompileTime = */ true>;
+            using SentinelType = typename IteratorType::CStringSentinel;
+            return operator_call_impl(IteratorType(str), SentinelType{});
+        } else {
+            using IteratorType = InternalIterator</*InCompileTime = */ false>;
+            using SentinelType = typename IteratorType::CStringSentinel;
+            return operator_call_impl(IteratorType(str), SentinelType{});
+        }
+    }
+
+#if STRING_MAP_HAS_SPAN
+    // clang-format off
+    template <class CharType, std::size_t SpanExtent>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(std::span<const CharType, SpanExtent> str) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size());
+    }
+#endif
+
+    /**
+     * Lookup of the string followed by at least Padding readable bytes. Trie is walked
+     *  char by char, with the check of the string end on every step, only until the node
+     *  through which one string passes, then the rest of this string is compared using
+     *  full-width unaligned loads and masks without per char end checks.
+     */
+    // clang-format off
+    template <class CharType, std::size_t Padding>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(std::basic_string_view<CharType> str, PaddedInput<Padding> padding) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size(), padding);
+    }
+    // clang-format off
+    template <class CharType, std::size_t Padding>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(const CharType* str, std::size_t size, PaddedInput<Padding>) const noexcept {
+        // clang-format on
+        static_assert(Padding >= PaddedStrings::kMinPadding, "Not enough padding");
+        static_assert(sizeof(CharType) == sizeof(char));
+        if (std::is_constant_evaluated()) {
+            return operator()(str, size);
+        }
+        return padded_operator_call_impl(str, size);
+    }
+
+    using Entry         = StringMapEntry<MappedType>;
+    using EntriesRange  = StringMapEntriesRange<Entry>;
+    using EntryIterator = const Entry*;
+
+    /**
+     * All entries of the map sorted by the key.
+     */
+    [[nodiscard]] static constexpr EntriesRange entries() noexcept {
+        return SortedEntries::all();
+    }
+    /**
+     * Entries with the keys starting with the prefix, sorted by the key.
+     * Trie is walked down to the prefix node whose subtree is the answer.
+     */
+    [[nodiscard]] constexpr EntriesRange prefix_range(std::string_view prefix) const noexcept {
+        const NodeWalk walk = walk_down(prefix);
+        if (walk.depth == prefix.size()) {
+            return EntriesRange(SortedEntries::at_rank(walk.ranks.begin),
+                                SortedEntries::at_rank(walk.ranks.end));
+        }
+        const std::size_t rank =
+            SortedEntries::template bound</*Upper = */ false>(walk.ranks.begin, walk.ranks.end,
+                                                              prefix);
+        return EntriesRange(SortedEntries::at_rank(rank), SortedEntries::at_rank(rank));
+    }
+    /**
+     * First entry with the key >= str or entries().end()
+     */
+    [[nodiscard]] constexpr EntryIterator lower_bound(std::string_view str) const noexcept {
+        const NodeWalk walk = walk_down(str);
+        if (walk.depth == str.size()) {
+            return SortedEntries::at_rank(walk.ranks.begin);
+        }
+        return SortedEntries::at_rank(SortedEntries::template bound</*Upper = */ false>(
+            walk.ranks.begin, walk.ranks.end, str));
+    }
+    /**
+     * First entry with the key > str or entries().end()
+     */
+    [[nodiscard]] constexpr EntryIterator upper_bound(std::string_view str) const noexcept {
+        const NodeWalk walk = walk_down(str);
+        if (walk.depth == str.size()) {
+            // Key of the node itself (if any) goes first in the subtree
+            const bool node_is_key = walk.ranks.begin < walk.ranks.end &&
+                                     SortedEntries::kEntries[walk.ranks.begin].key.size() ==
+                                         str.size();
+            return SortedEntries::at_rank(walk.ranks.begin + node_is_key);
+        }
+        return SortedEntries::at_rank(SortedEntries::template bound</*Upper = */ true>(
+            walk.ranks.begin, walk.ranks.end, str));
+    }
+
+    using MatchResult = StringMapMatchResult<MappedType>;
+
+    /**
+     * One pass tokenization: matches the longest prefix of the buffer which does not
+     *  contain the delimiters. Stops at the first delimiter, at the end of the buffer
+     *  or at the first char after which no key can match, the trie is walked once
+     *  over the buffer.
+     * Returns the value of the key equal to buffer[0, position) if the match stopped at
+     *  the delimiter or at the end of the buffer, default value otherwise. Position is
+     *  the number of chars matched before the stop.
+     *
+     *  // "Content-Length: 42" -> {kContentLength, 14}
+     *  const auto [header, position] = headers.match_until<':'>(line);
+     */
+    template <char... Delimiters>
+    [[nodiscard]] constexpr MatchResult match_until(std::string_view buffer) const noexcept {
+        constexpr bool kDelimitersInTrie =
+            ((TrieParams.CharToNodeIndex(Delimiters) < kTrieAlphabetSize) || ...);
+        return match_until_impl<kDelimitersInTrie>(
+            buffer, [](const char chr) constexpr noexcept { return ((chr == Delimiters) || ...); });
+    }
+    [[nodiscard]] constexpr MatchResult match_until(std::string_view buffer,
+                                                    std::string_view delimiters) const noexcept {
+        return match_until_impl</*DelimitersInTrie = */ true>(
+            buffer, [delimiters](const char chr) constexpr noexcept {
+                return delimiters.find(chr) != std::string_view::npos;
+            });
+    }
+
+    using DistanceMatch = StringMapDistanceMatch<Entry>;
+
+    static constexpr std::size_t kMaxEditDistance = EditDistanceBand::kMaxDistance;
+
+    /**
+     * Calls callback(entry, distance) for every entry whose key is within the
+     *  Levenshtein distance max_distance (at most kMaxEditDistance) from the str,
+     *  in the order of the keys.
+     * Trie is traversed with one DP row per node, subtrees where every prefix
+     *  is already farther than max_distance are skipped.
+     */
+    template <class Callback>
+    constexpr void for_each_within_distance(std::string_view str, std::size_t max_distance,
+                                            Callback callback) const {
+        max_distance = std::min(max_distance, kMaxEditDistance);
+        if (str.size() > TrieParams.max_tree_height + max_distance) {
+            return;
+        }
+        std::array<EditDistanceBand::Row, TrieParams.max_tree_height + 1> rows{};
+        rows[0] = EditDistanceBand::FirstRow(str.size(), max_distance);
+        within_distance_dfs(kRootNodeIndex, 0, str, max_distance, rows, callback);
+    }
+    /**
+     * Closest entry within the Levenshtein distance max_distance (at most kMaxEditDistance)
+     *  from the str, first in the order of the keys on ties. Entry is nullptr if there is none.
+     *
+     *  if (const auto [entry, distance] = commands.find_within_distance(token, 2); entry) {
+     *      std::printf("did you mean %s?\n", std::string(entry->key).c_str());
+     *  }
+     */
+    [[nodiscard]] constexpr DistanceMatch find_within_distance(
+        std::string_view str, std::size_t max_distance) const {
+        max_distance = std::min(max_distance, kMaxEditDistance);
+        DistanceMatch best{nullptr, max_distance + 1};
+        for_each_within_distance(str, max_distance,
+                                 [&best](const Entry& entry, std::size_t distance) constexpr {
+                                     if (distance < best.distance) {
+                                         best = {&entry, distance};
+                                     }
+                                 });
+        return best.entry != nullptr ? best : DistanceMatch{nullptr, 0};
+    }
+
+private:
+    using NodeIndex = std::uint32_t;
+    using SortedEntries = SortedEntriesTable<MappedValues, Strings...>;
+
+    static constexpr NodeIndex kRootNodeIndex      = TrieParams.kRootNodeIndex;
+    static constexpr std::size_t kTrieAlphabetSize = TrieParams.trie_alphabet_size;
+    static constexpr std::size_t kNodesSize        = TrieParams.nodes_size;
+
+    struct TrieNodeImpl final {
+        std::array<NodeIndex, kTrieAlphabetSize> edges{};
+        MappedType node_value = kDefaultValue;
+    };
+    using PaddedStrings = PaddedStringsTable<Strings...>;
+
+public:
+    static constexpr StringMapFootprint kFootprint = {
+        .backend        = kBackend,
+        .strings_count  = sizeof...(Strings),
+        .nodes_count    = kNodesSize,
+        .alphabet_size  = kTrieAlphabetSize,
+        .bytes_per_node = sizeof(TrieNodeImpl),
+        .table_bytes    = sizeof(std::array<TrieNodeImpl, kNodesSize>),
+        .max_depth      = TrieParams.max_tree_height,
+    };
+
+private:
+    // For every node: index + 1 of the only string in the node's subtree, 0 if there are many
+    STRING_MAP_CONSTEVAL static auto ComputeSingleStringNodes() noexcept {
+        std::array<std::size_t, kNodesSize> strings_count{};
+        std::array<std::size_t, kNodesSize> single_string_nodes{};
+        const std::array<std::string_view, sizeof...(Strings)> strings = {
+            std::string_view(Strings.value.data(), Strings.length)...,
+        };
+        for (std::size_t string_index = 0; string_index < strings.size(); string_index++) {
+            const std::string_view string  = strings[string_index];
+            std::size_t current_node_index = kRootNodeIndex;
+            for (std::size_t i = 0;; i++) {
+                strings_count[current_node_index]++;
+                single_string_nodes[current_node_index] = string_index + 1;
+                if (i == string.size()) {
+                    break;
+                }
+                current_node_index =
+                    kNodes[current_node_index].edges[TrieParams.CharToNodeIndex(string[i])];
+            }
+        }
+
+        std::array<std::uint32_t, kNodesSize> result{};
+        for (std::size_t i = 0; i < kNodesSize; i++) {
+            result[i] = strings_count[i] == 1
+                            ? static_cast<std::uint32_t>(single_string_nodes[i])
+                            : 0;
+        }
+        return result;
+    }
+
+    // Ranks [begin, end) of the sorted keys in the subtree of the node
+    struct NodeRanks final {
+        std::uint32_t begin{};
+        std::uint32_t end{};
+    };
+
+    STRING_MAP_CONSTEVAL static std::array<NodeRanks, kNodesSize> ComputeNodeRanks() noexcept {
+        // Empty range {0, 0} marks the node which was not visited yet
+        std::array<NodeRanks, kNodesSize> node_ranks{};
+        // Every node is on the path of some key. Keys are visited in the reversed
+        //  sorted order, so the first visit of the node sets the end of its range
+        //  and the last one sets the begin
+        for (std::size_t rank = SortedEntries::kSize; rank-- > 0;) {
+            const std::string_view key     = SortedEntries::kEntries[rank].key;
+            std::size_t current_node_index = kRootNodeIndex;
+            for (std::size_t i = 0;; i++) {
+                NodeRanks& ranks = node_ranks[current_node_index];
+                ranks.begin      = static_cast<std::uint32_t>(rank);
+                if (ranks.end == 0) {
+                    ranks.end = static_cast<std::uint32_t>(rank + 1);
+                }
+                if (i == key.size()) {
+                    break;
+                }
+                current_node_index =
+                    kNodes[current_node_index].edges[TrieParams.CharToNodeIndex(key[i])];
+            }
+        }
+        return node_ranks;
+    }
+
+    // Built on the first use, so maps without the ordered queries do not pay for it
+    struct NodeRanksTable final {
+        static constexpr std::array<NodeRanks, kNodesSize> kRanks = ComputeNodeRanks();
+    };
+
+    struct NodeWalk final {
+        NodeRanks ranks;
+        // Number of chars of the string consumed by the walk
+        std::size_t depth;
+    };
+
+    // Walks down the trie while the edges for the chars of the str exist
+    [[nodiscard]] constexpr NodeWalk walk_down(std::string_view str) const noexcept {
+        std::size_t current_node_index = kRootNodeIndex;
+        std::size_t depth              = 0;
+        for (; depth < str.size(); depth++) {
+            const std::size_t index = TrieParams.CharToNodeIndex(str[depth]);
+            if (index >= kTrieAlphabetSize) {
+                break;
+            }
+            const std::size_t next_node_index = kNodes[current_node_index].edges[index];
+            if (next_node_index == 0) {
+                break;
+            }
+            current_node_index = next_node_index;
+        }
+        return {NodeRanksTable::kRanks[current_node_index], depth};
+    }
+
+    template <class Callback>
+    constexpr void within_distance_dfs(
+        std::size_t node_index, std::size_t depth, std::string_view str,
+        std::size_t max_distance,
+        std::array<EditDistanceBand::Row, TrieParams.max_tree_height + 1>& rows,
+        Callback& callback) const {
+        const NodeRanks ranks = NodeRanksTable::kRanks[node_index];
+        // Key of the node itself (if any) goes first in the subtree
+        if (SortedEntries::kEntries[ranks.begin].key.size() == depth) {
+            const std::size_t distance =
+                EditDistanceBand::Distance(rows[depth], depth, str.size(), max_distance);
+            if (distance <= max_distance) {
+                callback(*SortedEntries::at_rank(ranks.begin), distance);
+            }
+        }
+        if (depth == TrieParams.max_tree_height) {
+            return;
+        }
+        for (std::size_t index = 0; index < kTrieAlphabetSize; index++) {
+            const std::size_t child_index = kNodes[node_index].edges[index];
+            if (child_index == 0) {
+                continue;
+            }
+            const char chr = static_cast<char>(TrieParams.min_char + index);
+            if (EditDistanceBand::NextRow(rows[depth], rows[depth + 1], depth + 1, chr, str,
+                                          max_distance) <= max_distance) {
+                within_distance_dfs(child_index, depth + 1, str, max_distance, rows, callback);
+            }
+        }
+    }
+
+    // If DelimitersInTrie is false, delimiters have no edges and are checked only
+    //  when the walk can't continue
+    template <bool DelimitersInTrie, class IsDelimiter>
+    [[nodiscard]] constexpr MatchResult match_until_impl(std::string_view buffer,
+                                                         IsDelimiter is_delimiter) const noexcept {
+        std::size_t current_node_index = kRootNodeIndex;
+        std::size_t position           = 0;
+        for (; position < buffer.size(); position++) {
+            const char chr = buffer[position];
+            if constexpr (DelimitersInTrie) {
+                if (is_delimiter(chr)) {
+                    break;
+                }
+            }
+            const std::size_t index = TrieParams.CharToNodeIndex(chr);
+            const std::size_t next_node_index =
+                index < kTrieAlphabetSize ? kNodes[current_node_index].edges[index] : 0;
+            if (next_node_index == 0) {
+                if (DelimitersInTrie || !is_delimiter(chr)) {
+                    stats::RecordLookup<StringMapImplManyStrings>(
+                        index < kTrieAlphabetSize ? stats::LookupExit::kMissingEdge
+                                                  : stats::LookupExit::kOutOfAlphabet,
+                        position);
+                    return {kDefaultValue, position};
+                }
+                break;
+            }
+            current_node_index = next_node_index;
+        }
+
+        const auto returned_value = kNodes[current_node_index].node_value;
+        stats::RecordLookup<StringMapImplManyStrings>(returned_value != kDefaultValue
+                                                          ? stats::LookupExit::kHit
+                                                          : stats::LookupExit::kNonTerminalEnd,
+                                                      position);
+        return {returned_value, position};
+    }
+
+    // clang-format off
+    template <class CharType>
+    ATTRIBUTE_LOOKUP_PURE
+    MappedType padded_operator_call_impl(const CharType* str, std::size_t size) const noexcept {
+        // clang-format on
+        static constexpr std::array<std::uint32_t, kNodesSize> kSingleStringNodes =
+            ComputeSingleStringNodes();
+
+        std::size_t current_node_index = kRootNodeIndex;
+        for (std::size_t height = 0;; ++height) {
+            // Rest of the string is checked at once if only one string passes through this node
+            if (const std::size_t single_string = kSingleStringNodes[current_node_index];
+                single_string != 0) {
+                const std::size_t string_index = single_string - 1;
+                if (size == PaddedStrings::length(string_index) &&
+                    PaddedStrings::EqualsSuffix(string_index, str, height)) {
+                    stats::RecordLookup<StringMapImplManyStrings>(stats::LookupExit::kHit, size);
+                    return MappedValues[string_index];
+                }
+                stats::RecordLookup<StringMapImplManyStrings>(stats::LookupExit::kMissingEdge,
+                                                              height);
+                return kDefaultValue;
+            }
+            if (height == size) {
+                const auto returned_value = kNodes[current_node_index].node_value;
+                stats::RecordLookup<StringMapImplManyStrings>(
+                    returned_value != kDefaultValue ? stats::LookupExit::kHit
+                                                    : stats::LookupExit::kNonTerminalEnd,
+                    height);
+                return returned_value;
+            }
+
+            const std::size_t index = TrieParams.CharToNodeIndex(str[height]);
+            if (index >= kTrieAlphabetSize) {
+                stats::RecordLookup<StringMapImplManyStrings>(stats::LookupExit::kOutOfAlphabet,
+                                                              height);
+                return kDefaultValue;
+            }
+            const std::size_t next_node_index = kNodes[current_node_index].edges[index];
+            if (next_node_index == 0) {
+                stats::RecordLookup<StringMapImplManyStrings>(stats::LookupExit::kMissingEdge,
+                                                              height);
+                return kDefaultValue;
+            }
+            current_node_index = next_node_index;
+        }
+    }
+
+    template <std::size_t CurrentPackIndex, string_map_detail::CompileTimeStringLiteral String,
+              string_map_detail::CompileTimeStringLiteral... AddStrings>
+    STRING_MAP_CONSTEVAL static void AddPattern(std::array<TrieNodeImpl, kNodesSize>& nodes,
+                                                std::size_t first_free_node_index) noexcept {
+        std::size_t current_node_index = 0;
+        constexpr std::size_t len      = String.size();
+        for (std::size_t i = 0; i < len; i++) {
+            std::size_t symbol_index    = TrieParams.CharToNodeIndex(String[i]);
+            std::size_t next_node_index = nodes[current_node_index].edges[symbol_index];
+            if (next_node_index == 0) {
+                nodes[current_node_index].edges[symbol_index] =
+                    static_cast<NodeIndex>(first_free_node_index);
+                next_node_index = first_free_node_index;
+                first_free_node_index++;
+            }
+            current_node_index = next_node_index;
+        }
+
+        const bool already_added_string = nodes[current_node_index].node_value != kDefaultValue;
+        // HINT: Remove duplicate strings from the StringMatch / StringMap
+        [[maybe_unused]] const auto duplicate_strings_check = 0 / !already_added_string;
+
+        static_assert(CurrentPackIndex < MappedValues.size(), "impl error");
+        nodes[current_node_index].node_value = MappedValues[CurrentPackIndex];
+        if constexpr (sizeof...(AddStrings) >= 1) {
+            AddPattern<CurrentPackIndex + 1, AddStrings...>(nodes, first_free_node_index);
+        }
+    }
+
+    STRING_MAP_CONSTEVAL static std::array<TrieNodeImpl, kNodesSize> BuildNodes() noexcept {
+        std::array<TrieNodeImpl, kNodesSize> nodes{};
+        AddPattern<0, Strings...>(nodes, kRootNodeIndex + 1);
+        return nodes;
+    }
+
+    /**
+     * Static data member of the class template is an inline variable: one copy of the
+     *  trie per set of the template parameters in the whole program, however many map
+     *  objects, functions and translation units use it.
+     */
+    static constexpr std::array<TrieNodeImpl, kNodesSize> kNodes = BuildNodes();
+
+    // clang-format off
+    template <class IteratorType, class SentinelIteratorType>
+    ATTRIBUTE_LOOKUP_PURE
+    constexpr MappedType operator_call_impl(IteratorType begin, SentinelIteratorType end) const noexcept {
+        // clang-format on
+
+#if defined(__cpp_lib_unreachable) && __cpp_lib_unreachable >= 202202L
+#define UNREACHABLE() std::unreachable()
+#elif CONFIG_HAS_BUILTIN(__builtin_unreachable)
+#define UNREACHABLE() __builtin_unreachable()
+#elif CONFIG_HAS_BUILTIN(__builtin_assume)
+#define UNREACHABLE() __builtin_assume(false)
+#elif CONFIG_HAS_AT_LEAST_CXX_23 && CONFIG_HAS_CPP_ATTRIBUTE(assume)
+#define UNREACHABLE() [[assume(false)]]
+#elif CONFIG_GNUC_PREREQ(13, 0) && CONFIG_HAS_ATTRIBUTE(assume)
+#define UNREACHABLE() __attribute__((assume(false)))
+#endif
+
+        std::size_t current_node_index = kRootNodeIndex;
+        std::size_t height             = 0;
+        for (; begin != end; ++begin, ++height) {
+            std::size_t index = TrieParams.CharToNodeIndex(*begin);
+            if (index >= kTrieAlphabetSize) {
+                stats::RecordLookup<StringMapImplManyStrings>(stats::LookupExit::kOutOfAlphabet,
+                                                              height);
+                return kDefaultValue;
+            }
+
+            std::size_t next_node_index = kNodes[current_node_index].edges[index];
+            if (next_node_index != 0) {
+                current_node_index = next_node_index;
+            } else {
+                stats::RecordLookup<StringMapImplManyStrings>(stats::LookupExit::kMissingEdge,
+                                                              height);
+                return kDefaultValue;
+            }
+
+            if (height > TrieParams.max_tree_height) {
+                UNREACHABLE();
+            }
+        }
+
+        const auto returned_value = kNodes[current_node_index].node_value;
+
+        if constexpr (kMappedTypesInfo.ordered) {
+            if (returned_value != kDefaultValue && (returned_value < kMappedTypesInfo.min_value ||
+                                                    returned_value > kMappedTypesInfo.max_value)) {
+                UNREACHABLE();
+            }
+        }
+
+#undef UNREACHABLE
+
+        stats::RecordLookup<StringMapImplManyStrings>(returned_value != kDefaultValue
+                                                          ? stats::LookupExit::kHit
+                                                          : stats::LookupExit::kNonTerminalEnd,
+                                                      height);
+        return returned_value;
+    }
+
+    struct TMappedTypesInfo final {
+        static constexpr bool kMaybeOrdered =
+            std::is_arithmetic_v<MappedType> ||
+            (std::is_enum_v<MappedType> && requires(MappedType x, MappedType y) {
+                { x < y } -> std::same_as<bool>;
                 { x <= y } -> std::same_as<bool>;
                 { x > y } -> std::same_as<bool>;
                 { x >= y } -> std::same_as<bool>;
             });
-        using DefaultConstructibleSentinelType =
-            std::conditional_t<std::is_default_constructible_v<MappedType>, MappedType, int>;
+        using DefaultConstructibleSentinelType =
+            std::conditional_t<std::is_default_constructible_v<MappedType>, MappedType, int>;
+
+        bool ordered = false;
+        DefaultConstructibleSentinelType max_value{};
+        DefaultConstructibleSentinelType min_value{};
+    };
+
+    STRING_MAP_CONSTEVAL static TMappedTypesInfo get_mapped_values_info() noexcept {
+        TMappedTypesInfo info{};
+
+        // TODO: Add support for pointers (ub gets very tricky there)
+        if constexpr (TMappedTypesInfo::kMaybeOrdered) {
+            if constexpr (std::is_floating_point_v<MappedType>) {
+                auto bad_float = [](MappedType x) constexpr noexcept -> bool {
+                    return x != x || x >= std::numeric_limits<MappedType>::infinity() ||
+                           x <= -std::numeric_limits<MappedType>::infinity() ||
+                           x == std::numeric_limits<MappedType>::quiet_NaN() ||
+                           x == std::numeric_limits<MappedType>::signaling_NaN();
+                };
+#if defined(__cpp_lib_constexpr_algorithms) && __cpp_lib_constexpr_algorithms >= 201806L && \
+    !defined(_GLIBCXX_DEBUG) && !defined(_LIBCPP_ENABLE_ASSERTIONS)
+                if (std::any_of(MappedValues.begin(), MappedValues.end(), bad_float)) {
+                    return info;
+                }
+#else
+                for (const auto x : MappedValues) {
+                    if (bad_float(x)) {
+                        return info;
+                    }
+                }
+#endif
+            }
+
+            info.ordered = true;
+#if !defined(_GLIBCXX_DEBUG) && !defined(_LIBCPP_ENABLE_ASSERTIONS)
+            const auto [min_iter, max_iter] =
+                std::minmax_element(MappedValues.begin(), MappedValues.end());
+            info.min_value = *min_iter;
+            info.max_value = *max_iter;
+#else
+            info.min_value = MappedValues.front();
+            info.max_value = MappedValues.front();
+            for (const auto value : MappedValues) {
+                info.min_value = std::min(info.min_value, value);
+                info.max_value = std::max(info.max_value, value);
+            }
+#endif
+        }
+
+        return info;
+    }
+
+    static constexpr TMappedTypesInfo kMappedTypesInfo = get_mapped_values_info();
+};
+
+template <trie_tools::TrieParamsType TrieParams, std::array MappedValues,
+          typename decltype(MappedValues)::value_type DefaultMapValue, CompileTimeStringLiteral... Strings>
+class [[nodiscard]] StringMapImplFewStrings final
+    : public SortedEntriesQueries<MappedValues, Strings...> {
+    static_assert(0 < TrieParams.min_char && TrieParams.min_char <= TrieParams.max_char &&
+                      TrieParams.max_char <= std::numeric_limits<std::uint8_t>::max(),
+                  "Empty string was passed in StringMatch / StringMap");
+    static_assert(sizeof...(Strings) == std::size(MappedValues) && std::size(MappedValues) > 0,
+                  "internal error");
+
+public:
+    using MappedType = typename decltype(MappedValues)::value_type;
+    static_assert(std::is_copy_assignable_v<MappedType>);
+
+    static constexpr MappedType kDefaultValue = DefaultMapValue;
+    static constexpr char kMinChar            = static_cast<char>(TrieParams.min_char);
+    static constexpr char kMaxChar            = static_cast<char>(TrieParams.max_char);
+    static constexpr bool kStatsEnabled       = STRING_MAP_ENABLE_STATS;
+    static constexpr StringMapBackend kBackend = StringMapBackend::kCompare;
+    static constexpr auto kMappedValues        = MappedValues;
+    using KeysType                             = KeysList<Strings...>;
+    // Strings are compared with the literals, there are no nodes
+    static constexpr StringMapFootprint kFootprint = {
+        .backend        = kBackend,
+        .strings_count  = sizeof...(Strings),
+        .nodes_count    = 0,
+        .alphabet_size  = TrieParams.trie_alphabet_size,
+        .bytes_per_node = 0,
+        .table_bytes    = (Strings.size() + ...) + sizeof(MappedValues),
+        .max_depth      = TrieParams.max_tree_height,
+    };
+
+    /**
+     * Lookup counters aggregated over all threads. Counters are shared by all
+     *  objects of the same map type. Always empty if STRING_MAP_ENABLE_STATS is 0.
+     */
+    [[nodiscard]] static stats::StringMapStats stats() {
+        return stats::GetLookupStats<StringMapImplFewStrings>();
+    }
+    static void reset_stats() {
+        stats::ResetLookupStats<StringMapImplFewStrings>();
+    }
+
+    STRING_MAP_CONSTEVAL StringMapImplFewStrings() noexcept = default;
+
+    constexpr MappedType operator()(std::nullptr_t) const noexcept              = delete;
+    constexpr MappedType operator()(std::nullptr_t, std::size_t) const noexcept = delete;
+
+    // clang-format off
+    template <class CharType>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(std::basic_string_view<CharType> str) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size());
+    }
+    // clang-format off
+    template <class CharType>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE    
+    constexpr MappedType operator()(const std::basic_string<CharType>& str) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size());
+    }
+    // clang-format off
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    ATTRIBUTE_ACCESS(read_only, 2)
+    constexpr MappedType operator()(const char* str) const noexcept {
+        // clang-format on
+        if (str == nullptr) [[unlikely]] {
+            return kDefaultValue;
+        }
+        return operator()(str, std::char_traits<char>::length(str));
+    }
+    // clang-format off
+    template <class CharType>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    ATTRIBUTE_SIZED_ACCESS(read_only, 2, 3)
+    constexpr MappedType operator()(const CharType* str, std::size_t size) const noexcept {
+        // clang-format on
+        return operator_call_impl<CharType, 0, Strings...>(str, size);
+    }
+
+#if STRING_MAP_HAS_SPAN
+    // clang-format off
+    template <class CharType, std::size_t SpanExtent>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(std::span<const CharType, SpanExtent> str) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size());
+    }
+#endif
+
+    /**
+     * Lookup of the string followed by at least Padding readable bytes: strings are
+     *  compared using full-width unaligned loads and masks without per char end checks.
+     */
+    // clang-format off
+    template <class CharType, std::size_t Padding>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(std::basic_string_view<CharType> str, PaddedInput<Padding> padding) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size(), padding);
+    }
+    // clang-format off
+    template <class CharType, std::size_t Padding>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(const CharType* str, std::size_t size, PaddedInput<Padding>) const noexcept {
+        // clang-format on
+        static_assert(Padding >= PaddedStrings::kMinPadding, "Not enough padding");
+        static_assert(sizeof(CharType) == sizeof(char));
+        if (std::is_constant_evaluated()) {
+            return operator()(str, size);
+        }
+        return padded_operator_call_impl(str, size);
+    }
+
+    using MatchResult = StringMapMatchResult<MappedType>;
+
+    /**
+     * Same as StringMapImplManyStrings::match_until. Keys are not compared one by one,
+     *  the range of the sorted keys is narrowed per char, see SortedEntriesTable::MatchUntil.
+     */
+    template <char... Delimiters>
+    [[nodiscard]] static constexpr MatchResult match_until(std::string_view buffer) noexcept {
+        return match_until_impl(
+            buffer, [](const char chr) constexpr noexcept { return ((chr == Delimiters) || ...); });
+    }
+    [[nodiscard]] static constexpr MatchResult match_until(std::string_view buffer,
+                                                           std::string_view delimiters) noexcept {
+        return match_until_impl(buffer, [delimiters](const char chr) constexpr noexcept {
+            return delimiters.find(chr) != std::string_view::npos;
+        });
+    }
+
+private:
+    using PaddedStrings = PaddedStringsTable<Strings...>;
+    using SortedEntries = SortedEntriesTable<MappedValues, Strings...>;
+
+    template <class IsDelimiter>
+    [[nodiscard]] static constexpr MatchResult match_until_impl(
+        std::string_view buffer, IsDelimiter is_delimiter) noexcept {
+        const MatchResult result =
+            SortedEntries::template MatchUntil<kDefaultValue>(buffer, is_delimiter);
+        stats::RecordLookup<StringMapImplFewStrings>(result.value != kDefaultValue
+                                                         ? stats::LookupExit::kHit
+                                                         : stats::LookupExit::kMismatch,
+                                                     0);
+        return result;
+    }
+
+    // clang-format off
+    template <class CharType, std::size_t Index = 0>
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    static MappedType padded_operator_call_impl(const CharType* str, std::size_t size) noexcept {
+        // clang-format on
+        if (size == PaddedStrings::length(Index) && PaddedStrings::EqualsSuffix(Index, str, 0)) {
+            stats::RecordLookup<StringMapImplFewStrings>(stats::LookupExit::kHit, 0);
+            return MappedValues[Index];
+        }
+        if constexpr (Index + 1 < sizeof...(Strings)) {
+            return padded_operator_call_impl<CharType, Index + 1>(str, size);
+        }
+        stats::RecordLookup<StringMapImplFewStrings>(stats::LookupExit::kMismatch, 0);
+        return kDefaultValue;
+    }
+
+    // clang-format off
+    template <class CharType, std::size_t Index, CompileTimeStringLiteral CompString, CompileTimeStringLiteral... CompStrings>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    ATTRIBUTE_SIZED_ACCESS(read_only, 1, 2)
+    static constexpr MappedType operator_call_impl(const CharType* str, std::size_t size) noexcept {
+        // clang-format on
+        if (CompString == std::basic_string_view<CharType>(str, size)) {
+            static_assert(Index < std::size(MappedValues));
+            stats::RecordLookup<StringMapImplFewStrings>(stats::LookupExit::kHit, 0);
+            return MappedValues[Index];
+        }
+        if constexpr (sizeof...(CompStrings) >= 1) {
+            return operator_call_impl<CharType, Index + 1, CompStrings...>(str, size);
+        }
+        stats::RecordLookup<StringMapImplFewStrings>(stats::LookupExit::kMismatch, 0);
+        return kDefaultValue;
+    }
+};
+
+/**
+ * Adaptive radix tree: the layout of every node is chosen at compile time by the
+ *  number of its children, so sparse nodes do not pay for the whole alphabet:
+ *  - Node4: up to 4 chars packed in one word, searched with SWAR compare
+ *  - Node16: up to 16 chars, searched with one SSE2 compare (if available)
+ *  - Node48: 256 bytes index from the char to one of 48 children
+ *  - Node256: children indexed by the char directly
+ *
+ * Opt-in only, kAuto never selects it: the branch on the node kind and the search in
+ *  Node4 / Node16 per char make it slower than the dense trie, it trades the lookup
+ *  speed for the table size. Use it when the trie does not fit the budget
+ *  (StringMapWithinBudget) and the lookups are not on the hot path.
+ */
+template <trie_tools::TrieParamsType TrieParams, std::array MappedValues,
+          typename decltype(MappedValues)::value_type DefaultMapValue, CompileTimeStringLiteral... Strings>
+class [[nodiscard]] StringMapImplArt final : public SortedEntriesQueries<MappedValues, Strings...> {
+    static_assert(0 < TrieParams.min_char && TrieParams.min_char <= TrieParams.max_char &&
+                      TrieParams.max_char <= std::numeric_limits<std::uint8_t>::max(),
+                  "Empty string was passed in StringMatch / StringMap");
+    static_assert(sizeof...(Strings) == std::size(MappedValues) && std::size(MappedValues) > 0,
+                  "internal error");
+
+public:
+    using MappedType = typename decltype(MappedValues)::value_type;
+    static_assert(std::is_copy_assignable_v<MappedType>);
+
+    static constexpr MappedType kDefaultValue = DefaultMapValue;
+    static constexpr char kMinChar            = static_cast<char>(TrieParams.min_char);
+    static constexpr char kMaxChar            = static_cast<char>(TrieParams.max_char);
+    static constexpr bool kStatsEnabled       = STRING_MAP_ENABLE_STATS;
+    static constexpr StringMapBackend kBackend = StringMapBackend::kArt;
+    static constexpr auto kMappedValues        = MappedValues;
+    using KeysType                             = KeysList<Strings...>;
+
+    /**
+     * Lookup counters aggregated over all threads. Counters are shared by all
+     *  objects of the same map type. Always empty if STRING_MAP_ENABLE_STATS is 0.
+     */
+    [[nodiscard]] static stats::StringMapStats stats() {
+        return stats::GetLookupStats<StringMapImplArt>();
+    }
+    static void reset_stats() {
+        stats::ResetLookupStats<StringMapImplArt>();
+    }
+
+    STRING_MAP_CONSTEVAL StringMapImplArt() noexcept = default;
+
+    constexpr MappedType operator()(std::nullptr_t) const noexcept              = delete;
+    constexpr MappedType operator()(std::nullptr_t, std::size_t) const noexcept = delete;
+
+    // clang-format off
+    template <class CharType>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(std::basic_string_view<CharType> str) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size());
+    }
+    // clang-format off
+    template <class CharType>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(const std::basic_string<CharType>& str) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size());
+    }
+    // clang-format off
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    ATTRIBUTE_ACCESS(read_only, 2)
+    constexpr MappedType operator()(const char* str) const noexcept {
+        // clang-format on
+        if (str == nullptr) [[unlikely]] {
+            return kDefaultValue;
+        }
+        return operator()(str, std::char_traits<char>::length(str));
+    }
+    // clang-format off
+    template <class CharType>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    ATTRIBUTE_SIZED_ACCESS(read_only, 2, 3)
+    constexpr MappedType operator()(const CharType* str, std::size_t size) const noexcept {
+        // clang-format on
+        static_assert(sizeof(CharType) == sizeof(char));
+        return operator_call_impl(str, size);
+    }
+
+#if STRING_MAP_HAS_SPAN
+    // clang-format off
+    template <class CharType, std::size_t SpanExtent>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(std::span<const CharType, SpanExtent> str) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size());
+    }
+#endif
+
+    /**
+     * Lookup of the string followed by at least Padding readable bytes. Nodes are
+     *  visited char by char anyway, so it is the same as the regular lookup and exists
+     *  only for the generic callers (e.g. DictionaryEncodeColumn).
+     */
+    // clang-format off
+    template <class CharType, std::size_t Padding>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(std::basic_string_view<CharType> str, PaddedInput<Padding>) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size());
+    }
+    // clang-format off
+    template <class CharType, std::size_t Padding>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(const CharType* str, std::size_t size, PaddedInput<Padding>) const noexcept {
+        // clang-format on
+        return operator()(str, size);
+    }
+
+    using MatchResult = StringMapMatchResult<MappedType>;
+
+    /**
+     * Same as StringMapImplManyStrings::match_until, the tree is walked once over the buffer.
+     */
+    template <char... Delimiters>
+    [[nodiscard]] constexpr MatchResult match_until(std::string_view buffer) const noexcept {
+        return match_until_impl(
+            buffer, [](const char chr) constexpr noexcept { return ((chr == Delimiters) || ...); });
+    }
+    [[nodiscard]] constexpr MatchResult match_until(std::string_view buffer,
+                                                    std::string_view delimiters) const noexcept {
+        return match_until_impl(buffer, [delimiters](const char chr) constexpr noexcept {
+            return delimiters.find(chr) != std::string_view::npos;
+        });
+    }
+
+private:
+    using SortedEntries = SortedEntriesTable<MappedValues, Strings...>;
+
+    // (slot + 1) << 2 | kind, 0 is a missing child
+    using NodeRef = std::uint32_t;
+
+    enum NodeKind : std::uint32_t {
+        kNode4   = 0,
+        kNode16  = 1,
+        kNode48  = 2,
+        kNode256 = 3,
+    };
+    static constexpr std::size_t kNodeKinds = 4;
+
+    // Unused keys are 0 which is never a char of the keys, and their children are 0
+    struct Node4 final {
+        // Char i is in the bits [8 * i, 8 * i + 8)
+        std::uint32_t packed_keys{};
+        std::array<NodeRef, 4> children{};
+        MappedType node_value = kDefaultValue;
+    };
+    struct alignas(16) Node16 final {
+        std::array<unsigned char, 16> keys{};
+        std::array<NodeRef, 16> children{};
+        MappedType node_value = kDefaultValue;
+    };
+    struct Node48 final {
+        // 0 if there is no child, child slot + 1 otherwise
+        std::array<std::uint8_t, 256> child_slots{};
+        std::array<NodeRef, 48> children{};
+        MappedType node_value = kDefaultValue;
+    };
+    struct Node256 final {
+        std::array<NodeRef, 256> children{};
+        MappedType node_value = kDefaultValue;
+    };
+
+    static constexpr std::size_t kNodesSize = TrieParams.nodes_size;
+
+    using Trie     = SortedKeysTrie<kNodesSize, MappedValues, Strings...>;
+    using TrieNode = typename Trie::Node;
+
+    // Layout of the trie node: kind of the node and its index in the table of this kind
+    struct NodePlacement final {
+        NodeKind kind{};
+        std::size_t slot{};
+    };
+
+    STRING_MAP_CONSTEVAL static std::array<NodePlacement, kNodesSize> PlaceNodes() noexcept {
+        std::array<NodePlacement, kNodesSize> placements{};
+        std::array<std::size_t, kNodeKinds> kind_counts{};
+        for (std::size_t i = 0; i < kNodesSize; i++) {
+            const std::size_t children_count = Trie::kNodes[i].children_count;
+            const NodeKind kind              = children_count <= 4    ? kNode4
+                                               : children_count <= 16 ? kNode16
+                                               : children_count <= 48 ? kNode48
+                                                                      : kNode256;
+            placements[i] = {kind, kind_counts[kind]++};
+        }
+        return placements;
+    }
+
+    static constexpr std::array<NodePlacement, kNodesSize> kPlacements = PlaceNodes();
+
+    STRING_MAP_CONSTEVAL static std::array<std::size_t, kNodeKinds> CountNodeKinds() noexcept {
+        std::array<std::size_t, kNodeKinds> counts{};
+        for (const NodePlacement& placement : kPlacements) {
+            counts[placement.kind]++;
+        }
+        return counts;
+    }
+
+public:
+    // Number of the nodes of every kind: Node4, Node16, Node48, Node256
+    static constexpr std::array<std::size_t, kNodeKinds> kNodeKindCounts = CountNodeKinds();
+
+private:
+    [[nodiscard]] STRING_MAP_CONSTEVAL static NodeRef MakeRef(std::size_t node_index) noexcept {
+        const NodePlacement placement = kPlacements[node_index];
+        return static_cast<NodeRef>(((placement.slot + 1) << 2) | placement.kind);
+    }
+
+    template <class Node, NodeKind Kind>
+    STRING_MAP_CONSTEVAL static std::array<Node, kNodeKindCounts[Kind]> FillNodes() noexcept {
+        std::array<Node, kNodeKindCounts[Kind]> result{};
+        for (std::size_t node_index = 0; node_index < kNodesSize; node_index++) {
+            if (kPlacements[node_index].kind != Kind) {
+                continue;
+            }
+            const TrieNode& node = Trie::kNodes[node_index];
+            Node& filled_node    = result[kPlacements[node_index].slot];
+            if (Trie::IsTerminal(node)) {
+                filled_node.node_value = SortedEntries::kEntries[node.begin].value;
+            }
+            for (std::size_t i = 0; i < node.children_count; i++) {
+                const std::size_t child_index = node.first_child + i;
+                const auto chr =
+                    static_cast<unsigned char>(Trie::EdgeChar(Trie::kNodes[child_index]));
+                if constexpr (Kind == kNode4) {
+                    filled_node.packed_keys |= std::uint32_t{chr} << (8 * i);
+                    filled_node.children[i] = MakeRef(child_index);
+                } else if constexpr (Kind == kNode16) {
+                    filled_node.keys[i]     = chr;
+                    filled_node.children[i] = MakeRef(child_index);
+                } else if constexpr (Kind == kNode48) {
+                    filled_node.child_slots[chr] = static_cast<std::uint8_t>(i + 1);
+                    filled_node.children[i]      = MakeRef(child_index);
+                } else {
+                    filled_node.children[chr] = MakeRef(child_index);
+                }
+            }
+        }
+        return result;
+    }
+
+    static constexpr auto kNodes4   = FillNodes<Node4, kNode4>();
+    static constexpr auto kNodes16  = FillNodes<Node16, kNode16>();
+    static constexpr auto kNodes48  = FillNodes<Node48, kNode48>();
+    static constexpr auto kNodes256 = FillNodes<Node256, kNode256>();
+    static constexpr NodeRef kRootRef = MakeRef(0);
+
+public:
+    static constexpr StringMapFootprint kFootprint = {
+        .backend        = kBackend,
+        .strings_count  = sizeof...(Strings),
+        .nodes_count    = kNodesSize,
+        .alphabet_size  = TrieParams.trie_alphabet_size,
+        // Average over all nodes
+        .bytes_per_node = (sizeof(kNodes4) + sizeof(kNodes16) + sizeof(kNodes48) +
+                           sizeof(kNodes256)) / kNodesSize,
+        .table_bytes    = sizeof(kNodes4) + sizeof(kNodes16) + sizeof(kNodes48) +
+                          sizeof(kNodes256),
+        .max_depth      = TrieParams.max_tree_height,
+    };
+
+private:
+    [[nodiscard]] ATTRIBUTE_PURE ATTRIBUTE_ALWAYS_INLINE static constexpr NodeRef FindChild4(
+        const Node4& node, unsigned char chr) noexcept {
+        // Zero byte of the packed_keys ^ (chr repeated 4 times) is the matched key,
+        //  lowest set bit of the classic haszero() mask is exact
+        const std::uint32_t diff = node.packed_keys ^ (std::uint32_t{chr} * 0x01010101U);
+        const std::uint32_t zero_bytes = (diff - 0x01010101U) & ~diff & 0x80808080U;
+        if (zero_bytes == 0) {
+            return 0;
+        }
+#if STRING_MAP_HAS_BIT
+        return node.children[static_cast<std::size_t>(std::countr_zero(zero_bytes)) / 8];
+#else
+        std::size_t index = 0;
+        while ((zero_bytes >> (8 * index + 7) & 1) == 0) {
+            index++;
+        }
+        return node.children[index];
+#endif
+    }
+
+    [[nodiscard]] ATTRIBUTE_PURE ATTRIBUTE_ALWAYS_INLINE static constexpr NodeRef FindChild16(
+        const Node16& node, unsigned char chr) noexcept {
+#if STRING_MAP_HAS_SSE2 && STRING_MAP_HAS_BIT
+        if (!std::is_constant_evaluated()) {
+            const __m128i keys =
+                _mm_load_si128(reinterpret_cast<const __m128i*>(node.keys.data()));
+            const __m128i matched = _mm_cmpeq_epi8(keys, _mm_set1_epi8(static_cast<char>(chr)));
+            const auto mask       = static_cast<std::uint32_t>(_mm_movemask_epi8(matched));
+            return mask != 0 ? node.children[static_cast<std::size_t>(std::countr_zero(mask))]
+                             : 0;
+        }
+#endif
+        for (std::size_t i = 0; i < node.keys.size(); i++) {
+            if (node.keys[i] == chr) {
+                return node.children[i];
+            }
+        }
+        return 0;
+    }
+
+    // Kinds without nodes are skipped, so there are no accesses to the empty tables
+    [[nodiscard]] ATTRIBUTE_PURE ATTRIBUTE_ALWAYS_INLINE static constexpr NodeRef FindChild(
+        NodeRef ref, unsigned char chr) noexcept {
+        const std::size_t slot = (ref >> 2) - 1;
+        switch (ref & 3) {
+            case kNode4:
+                if constexpr (kNodeKindCounts[kNode4] != 0) {
+                    return FindChild4(kNodes4[slot], chr);
+                }
+                break;
+            case kNode16:
+                if constexpr (kNodeKindCounts[kNode16] != 0) {
+                    return FindChild16(kNodes16[slot], chr);
+                }
+                break;
+            case kNode48:
+                if constexpr (kNodeKindCounts[kNode48] != 0) {
+                    const std::size_t child_slot = kNodes48[slot].child_slots[chr];
+                    return child_slot != 0 ? kNodes48[slot].children[child_slot - 1] : 0;
+                }
+                break;
+            default:
+                if constexpr (kNodeKindCounts[kNode256] != 0) {
+                    return kNodes256[slot].children[chr];
+                }
+                break;
+        }
+        return 0;
+    }
+
+    [[nodiscard]] ATTRIBUTE_PURE ATTRIBUTE_ALWAYS_INLINE static constexpr MappedType NodeValue(
+        NodeRef ref) noexcept {
+        const std::size_t slot = (ref >> 2) - 1;
+        switch (ref & 3) {
+            case kNode4:
+                if constexpr (kNodeKindCounts[kNode4] != 0) {
+                    return kNodes4[slot].node_value;
+                }
+                break;
+            case kNode16:
+                if constexpr (kNodeKindCounts[kNode16] != 0) {
+                    return kNodes16[slot].node_value;
+                }
+                break;
+            case kNode48:
+                if constexpr (kNodeKindCounts[kNode48] != 0) {
+                    return kNodes48[slot].node_value;
+                }
+                break;
+            default:
+                if constexpr (kNodeKindCounts[kNode256] != 0) {
+                    return kNodes256[slot].node_value;
+                }
+                break;
+        }
+        return kDefaultValue;
+    }
+
+    // clang-format off
+    template <class CharType>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_SIZED_ACCESS(read_only, 1, 2)
+    static constexpr MappedType operator_call_impl(const CharType* str, std::size_t size) noexcept {
+        // clang-format on
+        NodeRef ref = kRootRef;
+        for (std::size_t height = 0; height < size; height++) {
+            ref = FindChild(ref, static_cast<unsigned char>(str[height]));
+            if (ref == 0) {
+                stats::RecordLookup<StringMapImplArt>(stats::LookupExit::kMissingEdge, height);
+                return kDefaultValue;
+            }
+        }
+        const auto returned_value = NodeValue(ref);
+        stats::RecordLookup<StringMapImplArt>(returned_value != kDefaultValue
+                                                  ? stats::LookupExit::kHit
+                                                  : stats::LookupExit::kNonTerminalEnd,
+                                              size);
+        return returned_value;
+    }
+
+    template <class IsDelimiter>
+    [[nodiscard]] static constexpr MatchResult match_until_impl(
+        std::string_view buffer, IsDelimiter is_delimiter) noexcept {
+        NodeRef ref          = kRootRef;
+        std::size_t position = 0;
+        for (; position < buffer.size(); position++) {
+            const char chr = buffer[position];
+            if (is_delimiter(chr)) {
+                break;
+            }
+            const NodeRef next_ref = FindChild(ref, static_cast<unsigned char>(chr));
+            if (next_ref == 0) {
+                stats::RecordLookup<StringMapImplArt>(stats::LookupExit::kMissingEdge, position);
+                return {kDefaultValue, position};
+            }
+            ref = next_ref;
+        }
+        const auto returned_value = NodeValue(ref);
+        stats::RecordLookup<StringMapImplArt>(returned_value != kDefaultValue
+                                                  ? stats::LookupExit::kHit
+                                                  : stats::LookupExit::kNonTerminalEnd,
+                                              position);
+        return {returned_value, position};
+    }
+};
+
+/**
+ * Directed acyclic word graph: the trie with the equivalent subtrees merged, so keys
+ *  sharing the suffixes (e.g. "*_bytes_total", "*_seconds_total") share the nodes too.
+ * Values can't live in the shared nodes, so every edge holds the number of keys which
+ *  are less than all keys of its subtree and the sum of them over the path of the key
+ *  is the rank of the key in the sorted order.
+ */
+template <trie_tools::TrieParamsType TrieParams, std::array MappedValues,
+          typename decltype(MappedValues)::value_type DefaultMapValue, CompileTimeStringLiteral... Strings>
+class [[nodiscard]] StringMapImplDawg final : public SortedEntriesQueries<MappedValues, Strings...> {
+    static_assert(0 < TrieParams.min_char && TrieParams.min_char <= TrieParams.max_char &&
+                      TrieParams.max_char <= std::numeric_limits<std::uint8_t>::max(),
+                  "Empty string was passed in StringMatch / StringMap");
+    static_assert(sizeof...(Strings) == std::size(MappedValues) && std::size(MappedValues) > 0,
+                  "internal error");
+
+public:
+    using MappedType = typename decltype(MappedValues)::value_type;
+    static_assert(std::is_copy_assignable_v<MappedType>);
+
+    static constexpr MappedType kDefaultValue = DefaultMapValue;
+    static constexpr char kMinChar            = static_cast<char>(TrieParams.min_char);
+    static constexpr char kMaxChar            = static_cast<char>(TrieParams.max_char);
+    static constexpr bool kStatsEnabled       = STRING_MAP_ENABLE_STATS;
+    static constexpr StringMapBackend kBackend = StringMapBackend::kDawg;
+    static constexpr auto kMappedValues        = MappedValues;
+    using KeysType                             = KeysList<Strings...>;
+
+    /**
+     * Lookup counters aggregated over all threads. Counters are shared by all
+     *  objects of the same map type. Always empty if STRING_MAP_ENABLE_STATS is 0.
+     */
+    [[nodiscard]] static stats::StringMapStats stats() {
+        return stats::GetLookupStats<StringMapImplDawg>();
+    }
+    static void reset_stats() {
+        stats::ResetLookupStats<StringMapImplDawg>();
+    }
+
+    STRING_MAP_CONSTEVAL StringMapImplDawg() noexcept = default;
+
+    constexpr MappedType operator()(std::nullptr_t) const noexcept              = delete;
+    constexpr MappedType operator()(std::nullptr_t, std::size_t) const noexcept = delete;
+
+    // clang-format off
+    template <class CharType>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(std::basic_string_view<CharType> str) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size());
+    }
+    // clang-format off
+    template <class CharType>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(const std::basic_string<CharType>& str) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size());
+    }
+    // clang-format off
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    ATTRIBUTE_ACCESS(read_only, 2)
+    constexpr MappedType operator()(const char* str) const noexcept {
+        // clang-format on
+        if (str == nullptr) [[unlikely]] {
+            return kDefaultValue;
+        }
+        return operator()(str, std::char_traits<char>::length(str));
+    }
+    // clang-format off
+    template <class CharType>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    ATTRIBUTE_SIZED_ACCESS(read_only, 2, 3)
+    constexpr MappedType operator()(const CharType* str, std::size_t size) const noexcept {
+        // clang-format on
+        static_assert(sizeof(CharType) == sizeof(char));
+        return operator_call_impl(str, size);
+    }
+
+#if STRING_MAP_HAS_SPAN
+    // clang-format off
+    template <class CharType, std::size_t SpanExtent>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(std::span<const CharType, SpanExtent> str) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size());
+    }
+#endif
+
+    /**
+     * Lookup of the string followed by at least Padding readable bytes. Nodes are
+     *  visited char by char anyway, so it is the same as the regular lookup.
+     */
+    // clang-format off
+    template <class CharType, std::size_t Padding>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(std::basic_string_view<CharType> str, PaddedInput<Padding>) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size());
+    }
+    // clang-format off
+    template <class CharType, std::size_t Padding>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(const CharType* str, std::size_t size, PaddedInput<Padding>) const noexcept {
+        // clang-format on
+        return operator()(str, size);
+    }
+
+    using MatchResult = StringMapMatchResult<MappedType>;
+
+    /**
+     * Same as StringMapImplManyStrings::match_until, the graph is walked once over the buffer.
+     */
+    template <char... Delimiters>
+    [[nodiscard]] constexpr MatchResult match_until(std::string_view buffer) const noexcept {
+        return match_until_impl(
+            buffer, [](const char chr) constexpr noexcept { return ((chr == Delimiters) || ...); });
+    }
+    [[nodiscard]] constexpr MatchResult match_until(std::string_view buffer,
+                                                    std::string_view delimiters) const noexcept {
+        return match_until_impl(buffer, [delimiters](const char chr) constexpr noexcept {
+            return delimiters.find(chr) != std::string_view::npos;
+        });
+    }
+
+private:
+    using SortedEntries = SortedEntriesTable<MappedValues, Strings...>;
+
+    static constexpr std::size_t kTrieAlphabetSize = TrieParams.trie_alphabet_size;
+    static constexpr std::size_t kTrieNodesSize    = TrieParams.nodes_size;
+
+    using Trie     = SortedKeysTrie<kTrieNodesSize, MappedValues, Strings...>;
+    using TrieNode = typename Trie::Node;
+
+    struct Minimization final {
+        // Graph node of every trie node, root is the graph node 0
+        std::array<std::uint32_t, kTrieNodesSize> graph_nodes{};
+        // Trie node which represents every graph node
+        std::array<std::uint32_t, kTrieNodesSize> representatives{};
+        std::size_t graph_nodes_count{};
+    };
+
+    [[nodiscard]] STRING_MAP_CONSTEVAL static bool Equivalent(
+        const Minimization& minimization, const TrieNode& lhs, const TrieNode& rhs) noexcept {
+        if (Trie::IsTerminal(lhs) != Trie::IsTerminal(rhs) ||
+            lhs.children_count != rhs.children_count) {
+            return false;
+        }
+        for (std::size_t i = 0; i < lhs.children_count; i++) {
+            const std::size_t lhs_child = lhs.first_child + i;
+            const std::size_t rhs_child = rhs.first_child + i;
+            if (Trie::EdgeChar(Trie::kNodes[lhs_child]) !=
+                    Trie::EdgeChar(Trie::kNodes[rhs_child]) ||
+                minimization.graph_nodes[lhs_child] != minimization.graph_nodes[rhs_child]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    STRING_MAP_CONSTEVAL static Minimization Minimize() noexcept {
+        Minimization minimization{};
+        // Open addressing, 0 is an empty cell, trie node + 1 otherwise
+        constexpr std::size_t kHashTableSize = 2 * kTrieNodesSize + 1;
+        std::array<std::uint32_t, kHashTableSize> hash_table{};
+        // Children go after the parent in the BFS order, so they are merged before it.
+        //  Graph nodes are numbered from the last one here and renumbered below
+        std::size_t classes_count = 0;
+        for (std::size_t node_index = kTrieNodesSize; node_index-- > 0;) {
+            const TrieNode& node = Trie::kNodes[node_index];
+            std::uint64_t hash   = Trie::IsTerminal(node) ? 0x9E3779B97F4A7C15ULL : 1;
+            for (std::size_t i = 0; i < node.children_count; i++) {
+                const std::size_t child = node.first_child + i;
+                hash = (hash ^ static_cast<unsigned char>(Trie::EdgeChar(Trie::kNodes[child]))) *
+                       0x100000001B3ULL;
+                hash = (hash ^ minimization.graph_nodes[child]) * 0x100000001B3ULL;
+            }
+            std::size_t cell = static_cast<std::size_t>(hash ^ (hash >> 29)) % kHashTableSize;
+            while (hash_table[cell] != 0 &&
+                   !Equivalent(minimization, Trie::kNodes[hash_table[cell] - 1], node)) {
+                cell = (cell + 1) % kHashTableSize;
+            }
+            if (hash_table[cell] != 0) {
+                minimization.graph_nodes[node_index] =
+                    minimization.graph_nodes[hash_table[cell] - 1];
+                continue;
+            }
+            hash_table[cell]                     = static_cast<std::uint32_t>(node_index + 1);
+            minimization.graph_nodes[node_index] = static_cast<std::uint32_t>(classes_count++);
+        }
+        for (std::size_t node_index = 0; node_index < kTrieNodesSize; node_index++) {
+            std::uint32_t& graph_node = minimization.graph_nodes[node_index];
+            graph_node = static_cast<std::uint32_t>(classes_count - 1 - graph_node);
+            minimization.representatives[graph_node] = static_cast<std::uint32_t>(node_index);
+        }
+        minimization.graph_nodes_count = classes_count;
+        return minimization;
+    }
+
+    static constexpr Minimization kMinimization = Minimize();
+
+public:
+    // Number of the nodes left after merging, the plain trie has TrieParams.nodes_size nodes
+    static constexpr std::size_t kNodesSize = kMinimization.graph_nodes_count;
+
+private:
+    // Edge is (rank_offset << kChildBits) | child, 0 is a missing edge (root is never a child)
+    using Edge = std::uint32_t;
+
+    [[nodiscard]] STRING_MAP_CONSTEVAL static std::size_t BitWidth(std::size_t value) noexcept {
+        std::size_t width = 0;
+        for (; value != 0; value >>= 1) {
+            width++;
+        }
+        return width;
+    }
+
+    static constexpr std::size_t kChildBits = BitWidth(kNodesSize);
+    static_assert(kChildBits + BitWidth(sizeof...(Strings)) <= 32,
+                  "Too many strings for the StringMapBackend::kDawg");
+    static constexpr Edge kChildMask = (Edge{1} << kChildBits) - 1;
+
+    struct DawgNode final {
+        std::array<Edge, kTrieAlphabetSize> edges{};
+        bool is_terminal{};
+    };
+
+    STRING_MAP_CONSTEVAL static std::array<DawgNode, kNodesSize> BuildGraph() noexcept {
+        std::array<DawgNode, kNodesSize> graph{};
+        for (std::size_t graph_node = 0; graph_node < kNodesSize; graph_node++) {
+            const TrieNode& node  = Trie::kNodes[kMinimization.representatives[graph_node]];
+            DawgNode& dawg_node   = graph[graph_node];
+            dawg_node.is_terminal = Trie::IsTerminal(node);
+            // Node key (if any) and keys of the previous children are less than the child keys
+            std::size_t rank_offset = dawg_node.is_terminal;
+            for (std::size_t i = 0; i < node.children_count; i++) {
+                const std::size_t child = node.first_child + i;
+                const TrieNode& child_node = Trie::kNodes[child];
+                dawg_node.edges[TrieParams.CharToNodeIndex(Trie::EdgeChar(child_node))] =
+                    static_cast<Edge>((rank_offset << kChildBits) |
+                                      kMinimization.graph_nodes[child]);
+                rank_offset += child_node.end - child_node.begin;
+            }
+        }
+        return graph;
+    }
+
+    template <std::size_t... Ranks>
+    STRING_MAP_CONSTEVAL static std::array<MappedType, sizeof...(Strings)> SortedValues(
+        std::index_sequence<Ranks...>) noexcept {
+        return {SortedEntries::kEntries[Ranks].value...};
+    }
+
+    static constexpr std::array<DawgNode, kNodesSize> kGraph = BuildGraph();
+    // Values by the rank of the key
+    static constexpr std::array<MappedType, sizeof...(Strings)> kSortedValues =
+        SortedValues(std::make_index_sequence<sizeof...(Strings)>{});
+
+public:
+    static constexpr StringMapFootprint kFootprint = {
+        .backend        = kBackend,
+        .strings_count  = sizeof...(Strings),
+        .nodes_count    = kNodesSize,
+        .alphabet_size  = kTrieAlphabetSize,
+        .bytes_per_node = sizeof(DawgNode),
+        .table_bytes    = sizeof(kGraph) + sizeof(kSortedValues),
+        .max_depth      = TrieParams.max_tree_height,
+    };
+
+private:
+    // Node and the number of keys less than the path to it
+    struct GraphPosition final {
+        std::size_t node;
+        std::size_t rank;
+    };
+
+    // Returns false if there is no edge for the chr
+    [[nodiscard]] ATTRIBUTE_PURE ATTRIBUTE_ALWAYS_INLINE static constexpr bool Step(
+        GraphPosition& position, char chr) noexcept {
+        const std::size_t index = TrieParams.CharToNodeIndex(chr);
+        if (index >= kTrieAlphabetSize) {
+            return false;
+        }
+        const Edge edge = kGraph[position.node].edges[index];
+        if (edge == 0) {
+            return false;
+        }
+        position.node = edge & kChildMask;
+        position.rank += edge >> kChildBits;
+        return true;
+    }
+
+    // clang-format off
+    template <class CharType>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_SIZED_ACCESS(read_only, 1, 2)
+    static constexpr MappedType operator_call_impl(const CharType* str, std::size_t size) noexcept {
+        // clang-format on
+        GraphPosition position{0, 0};
+        for (std::size_t height = 0; height < size; height++) {
+            if (!Step(position, static_cast<char>(str[height]))) {
+                stats::RecordLookup<StringMapImplDawg>(stats::LookupExit::kMissingEdge, height);
+                return kDefaultValue;
+            }
+        }
+        if (!kGraph[position.node].is_terminal) {
+            stats::RecordLookup<StringMapImplDawg>(stats::LookupExit::kNonTerminalEnd, size);
+            return kDefaultValue;
+        }
+        stats::RecordLookup<StringMapImplDawg>(stats::LookupExit::kHit, size);
+        return kSortedValues[position.rank];
+    }
+
+    template <class IsDelimiter>
+    [[nodiscard]] static constexpr MatchResult match_until_impl(
+        std::string_view buffer, IsDelimiter is_delimiter) noexcept {
+        GraphPosition position{0, 0};
+        std::size_t matched = 0;
+        for (; matched < buffer.size(); matched++) {
+            const char chr = buffer[matched];
+            if (is_delimiter(chr)) {
+                break;
+            }
+            if (!Step(position, chr)) {
+                stats::RecordLookup<StringMapImplDawg>(stats::LookupExit::kMissingEdge, matched);
+                return {kDefaultValue, matched};
+            }
+        }
+        if (!kGraph[position.node].is_terminal) {
+            stats::RecordLookup<StringMapImplDawg>(stats::LookupExit::kNonTerminalEnd, matched);
+            return {kDefaultValue, matched};
+        }
+        stats::RecordLookup<StringMapImplDawg>(stats::LookupExit::kHit, matched);
+        return {kSortedValues[position.rank], matched};
+    }
+};
+
+/**
+ * Keys are told apart by the length and the chars at a few positions: lookup gathers
+ *  them into one word, extracts the discriminating bits (BMI2 pext if available) and
+ *  gets the only candidate key from the small table, which is then compared once.
+ * Positions and bits are chosen at compile time, so the lookup cost does not depend
+ *  on the number of keys.
+ */
+template <trie_tools::TrieParamsType TrieParams, std::array MappedValues,
+          typename decltype(MappedValues)::value_type DefaultMapValue, CompileTimeStringLiteral... Strings>
+class [[nodiscard]] StringMapImplPositions final
+    : public SortedEntriesQueries<MappedValues, Strings...> {
+    static_assert(0 < TrieParams.min_char && TrieParams.min_char <= TrieParams.max_char &&
+                      TrieParams.max_char <= std::numeric_limits<std::uint8_t>::max(),
+                  "Empty string was passed in StringMatch / StringMap");
+    static_assert(sizeof...(Strings) == std::size(MappedValues) && std::size(MappedValues) > 0,
+                  "internal error");
+
+public:
+    using MappedType = typename decltype(MappedValues)::value_type;
+    static_assert(std::is_copy_assignable_v<MappedType>);
+
+    static constexpr MappedType kDefaultValue = DefaultMapValue;
+    static constexpr char kMinChar            = static_cast<char>(TrieParams.min_char);
+    static constexpr char kMaxChar            = static_cast<char>(TrieParams.max_char);
+    static constexpr bool kStatsEnabled       = STRING_MAP_ENABLE_STATS;
+    static constexpr StringMapBackend kBackend = StringMapBackend::kPositions;
+    static constexpr auto kMappedValues        = MappedValues;
+    using KeysType                             = KeysList<Strings...>;
+
+    // Low byte of the gathered word is the length, chars at the positions go after it
+    static constexpr std::size_t kMaxPositions = 7;
+    // Candidates table has 2^kIndexBits entries
+    static constexpr std::size_t kMaxIndexBits = 16;
+
+    /**
+     * Lookup counters aggregated over all threads. Counters are shared by all
+     *  objects of the same map type. Always empty if STRING_MAP_ENABLE_STATS is 0.
+     */
+    [[nodiscard]] static stats::StringMapStats stats() {
+        return stats::GetLookupStats<StringMapImplPositions>();
+    }
+    static void reset_stats() {
+        stats::ResetLookupStats<StringMapImplPositions>();
+    }
+
+    STRING_MAP_CONSTEVAL StringMapImplPositions() noexcept = default;
+
+    constexpr MappedType operator()(std::nullptr_t) const noexcept              = delete;
+    constexpr MappedType operator()(std::nullptr_t, std::size_t) const noexcept = delete;
+
+    // clang-format off
+    template <class CharType>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(std::basic_string_view<CharType> str) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size());
+    }
+    // clang-format off
+    template <class CharType>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(const std::basic_string<CharType>& str) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size());
+    }
+    // clang-format off
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    ATTRIBUTE_ACCESS(read_only, 2)
+    constexpr MappedType operator()(const char* str) const noexcept {
+        // clang-format on
+        if (str == nullptr) [[unlikely]] {
+            return kDefaultValue;
+        }
+        return operator()(str, std::char_traits<char>::length(str));
+    }
+    // clang-format off
+    template <class CharType>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    ATTRIBUTE_SIZED_ACCESS(read_only, 2, 3)
+    constexpr MappedType operator()(const CharType* str, std::size_t size) const noexcept {
+        // clang-format on
+        static_assert(sizeof(CharType) == sizeof(char));
+        const std::size_t string_index = Candidate(str, size);
+        if (string_index < sizeof...(Strings) && EqualsKey(string_index, str, size)) {
+            stats::RecordLookup<StringMapImplPositions>(stats::LookupExit::kHit, 0);
+            return MappedValues[string_index];
+        }
+        stats::RecordLookup<StringMapImplPositions>(stats::LookupExit::kMismatch, 0);
+        return kDefaultValue;
+    }
+
+#if STRING_MAP_HAS_SPAN
+    // clang-format off
+    template <class CharType, std::size_t SpanExtent>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(std::span<const CharType, SpanExtent> str) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size());
+    }
+#endif
+
+    /**
+     * Lookup of the string followed by at least Padding readable bytes: the candidate
+     *  is compared using full-width unaligned loads and masks.
+     */
+    // clang-format off
+    template <class CharType, std::size_t Padding>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(std::basic_string_view<CharType> str, PaddedInput<Padding> padding) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size(), padding);
+    }
+    // clang-format off
+    template <class CharType, std::size_t Padding>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(const CharType* str, std::size_t size, PaddedInput<Padding>) const noexcept {
+        // clang-format on
+        static_assert(Padding >= PaddedStrings::kMinPadding, "Not enough padding");
+        static_assert(sizeof(CharType) == sizeof(char));
+        if (std::is_constant_evaluated()) {
+            return operator()(str, size);
+        }
+        const std::size_t string_index = Candidate(str, size);
+        if (string_index < sizeof...(Strings) && size == PaddedStrings::length(string_index) &&
+            PaddedStrings::EqualsSuffix(string_index, str, 0)) {
+            stats::RecordLookup<StringMapImplPositions>(stats::LookupExit::kHit, 0);
+            return MappedValues[string_index];
+        }
+        stats::RecordLookup<StringMapImplPositions>(stats::LookupExit::kMismatch, 0);
+        return kDefaultValue;
+    }
+
+    using MatchResult = StringMapMatchResult<MappedType>;
+
+    /**
+     * Same as StringMapImplManyStrings::match_until. The positions table does not apply to
+     *  the prefixes, so the range of the sorted keys is narrowed per char instead, see
+     *  SortedEntriesTable::MatchUntil.
+     */
+    template <char... Delimiters>
+    [[nodiscard]] static constexpr MatchResult match_until(std::string_view buffer) noexcept {
+        return match_until_impl(
+            buffer, [](const char chr) constexpr noexcept { return ((chr == Delimiters) || ...); });
+    }
+    [[nodiscard]] static constexpr MatchResult match_until(std::string_view buffer,
+                                                           std::string_view delimiters) noexcept {
+        return match_until_impl(buffer, [delimiters](const char chr) constexpr noexcept {
+            return delimiters.find(chr) != std::string_view::npos;
+        });
+    }
+
+private:
+    using PaddedStrings = PaddedStringsTable<Strings...>;
+    using SortedEntries = SortedEntriesTable<MappedValues, Strings...>;
+    using Word          = std::uint64_t;
+
+    static constexpr std::size_t kStringsCount = sizeof...(Strings);
+    static constexpr std::array<std::string_view, kStringsCount> kKeys = {
+        std::string_view(Strings.value.data(), Strings.length)...,
+    };
+
+    struct Selection final {
+        std::array<std::size_t, kMaxPositions> positions{};
+        std::size_t positions_count{};
+        Word mask{};
+        bool found{};
+    };
+
+    // Length byte and chars at the positions, 0 for the positions out of the string
+    template <class CharType, std::size_t PositionsCount>
+    [[nodiscard]] ATTRIBUTE_ALWAYS_INLINE static constexpr Word GatherWord(
+        const CharType* str, std::size_t size,
+        const std::array<std::size_t, PositionsCount>& positions,
+        std::size_t positions_count = PositionsCount) noexcept {
+        Word word = static_cast<std::uint8_t>(size);
+        for (std::size_t i = 0; i < positions_count; i++) {
+            if (positions[i] < size) {
+                word |= Word{static_cast<unsigned char>(str[positions[i]])} << (8 * (i + 1));
+            }
+        }
+        return word;
+    }
+
+    [[nodiscard]] static constexpr Word ExtractBitsSlow(Word word, Word mask) noexcept {
+        Word result = 0;
+        std::size_t result_bit = 0;
+        for (std::size_t bit = 0; bit < 64; bit++) {
+            if ((mask >> bit) & 1) {
+                result |= ((word >> bit) & 1) << result_bit++;
+            }
+        }
+        return result;
+    }
+
+    [[nodiscard]] STRING_MAP_CONSTEVAL static bool AllDistinct(
+        const std::array<Word, kStringsCount>& words, Word mask) noexcept {
+        for (std::size_t i = 0; i < kStringsCount; i++) {
+            for (std::size_t j = i + 1; j < kStringsCount; j++) {
+                if (((words[i] ^ words[j]) & mask) == 0) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    STRING_MAP_CONSTEVAL static Selection SelectPositions() noexcept {
+        Selection selection{};
+        // Keys are split into the groups by the length and the chars at the selected
+        //  positions, every step takes the position which gives the most groups
+        std::array<std::size_t, kStringsCount> groups{};
+        std::size_t groups_count = 0;
+        for (std::size_t i = 0; i < kStringsCount; i++) {
+            groups[i] = groups_count;
+            for (std::size_t j = 0; j < i; j++) {
+                if (static_cast<std::uint8_t>(kKeys[j].size()) ==
+                    static_cast<std::uint8_t>(kKeys[i].size())) {
+                    groups[i] = groups[j];
+                    break;
+                }
+            }
+            groups_count += groups[i] == groups_count;
+        }
+
+        const auto char_at = [](std::size_t string_index, std::size_t position) constexpr {
+            const std::string_view key = kKeys[string_index];
+            return position < key.size() ? static_cast<unsigned char>(key[position]) : 0;
+        };
+        const auto split = [&char_at](const std::array<std::size_t, kStringsCount>& old_groups,
+                                      std::size_t position,
+                                      std::array<std::size_t, kStringsCount>& new_groups) {
+            std::size_t new_groups_count = 0;
+            for (std::size_t i = 0; i < kStringsCount; i++) {
+                new_groups[i] = new_groups_count;
+                for (std::size_t j = 0; j < i; j++) {
+                    if (old_groups[j] == old_groups[i] &&
+                        char_at(j, position) == char_at(i, position)) {
+                        new_groups[i] = new_groups[j];
+                        break;
+                    }
+                }
+                new_groups_count += new_groups[i] == new_groups_count;
+            }
+            return new_groups_count;
+        };
+
+        while (groups_count < kStringsCount && selection.positions_count < kMaxPositions) {
+            std::size_t best_position     = 0;
+            std::size_t best_groups_count = groups_count;
+            std::array<std::size_t, kStringsCount> new_groups{};
+            for (std::size_t position = 0; position < TrieParams.max_tree_height; position++) {
+                const std::size_t new_groups_count = split(groups, position, new_groups);
+                if (new_groups_count > best_groups_count) {
+                    best_position     = position;
+                    best_groups_count = new_groups_count;
+                }
+            }
+            if (best_groups_count == groups_count) {
+                break;
+            }
+            groups_count = split(groups, best_position, new_groups);
+            groups       = new_groups;
+            selection.positions[selection.positions_count++] = best_position;
+        }
+        if (groups_count < kStringsCount) {
+            return selection;
+        }
+
+        // Bits of the gathered words which are not needed to tell the keys apart are dropped
+        std::array<Word, kStringsCount> words{};
+        for (std::size_t i = 0; i < kStringsCount; i++) {
+            words[i] = GatherWord(kKeys[i].data(), kKeys[i].size(), selection.positions,
+                                  selection.positions_count);
+        }
+        const std::size_t used_bits = 8 * (selection.positions_count + 1);
+        selection.mask = used_bits == 64 ? ~Word{0} : (Word{1} << used_bits) - 1;
+        for (std::size_t bit = used_bits; bit-- > 0;) {
+            const Word reduced_mask = selection.mask & ~(Word{1} << bit);
+            if (AllDistinct(words, reduced_mask)) {
+                selection.mask = reduced_mask;
+            }
+        }
+        selection.found = true;
+        return selection;
+    }
+
+    static constexpr Selection kSelection = SelectPositions();
+    static_assert(kSelection.found,
+                  "Keys can't be told apart by the length and kMaxPositions chars, use another "
+                  "StringMapBackend");
+
+    STRING_MAP_CONSTEVAL static std::array<std::size_t, kSelection.positions_count>
+    Positions() noexcept {
+        std::array<std::size_t, kSelection.positions_count> positions{};
+        for (std::size_t i = 0; i < positions.size(); i++) {
+            positions[i] = kSelection.positions[i];
+        }
+        return positions;
+    }
+
+    [[nodiscard]] STRING_MAP_CONSTEVAL static std::size_t CountBits(Word mask) noexcept {
+        std::size_t count = 0;
+        for (; mask != 0; mask &= mask - 1) {
+            count++;
+        }
+        return count;
+    }
+
+public:
+    // Positions of the chars which (with the length) tell the keys apart
+    static constexpr std::size_t kPositionsCount = kSelection.positions_count;
+    static constexpr std::array<std::size_t, kPositionsCount> kPositions = Positions();
+    static constexpr Word kIndexMask       = kSelection.mask;
+    static constexpr std::size_t kIndexBits = CountBits(kIndexMask);
+    static_assert(kIndexBits <= kMaxIndexBits,
+                  "Candidates table of the StringMapBackend::kPositions is too large, use another "
+                  "StringMapBackend");
+
+private:
+    // Index of the key + 1, 0 if there is no key with such bits
+    using Slot = std::conditional_t<(kStringsCount < std::numeric_limits<std::uint8_t>::max()),
+                                    std::uint8_t, std::uint16_t>;
+    static constexpr std::size_t kTableSize = std::size_t{1} << kIndexBits;
+
+    STRING_MAP_CONSTEVAL static std::array<Slot, kTableSize> BuildTable() noexcept {
+        std::array<Slot, kTableSize> table{};
+        for (std::size_t i = 0; i < kStringsCount; i++) {
+            const Word word = GatherWord(kKeys[i].data(), kKeys[i].size(), kPositions);
+            table[ExtractBitsSlow(word, kIndexMask)] = static_cast<Slot>(i + 1);
+        }
+        return table;
+    }
+
+    static constexpr std::array<Slot, kTableSize> kTable = BuildTable();
+
+    // Runs of the consecutive bits of the kIndexMask, extracted with one shift and mask each
+    struct BitsRun final {
+        std::uint32_t shift{};
+        std::uint32_t result_shift{};
+        Word mask{};
+    };
+
+    STRING_MAP_CONSTEVAL static std::size_t CountRuns() noexcept {
+        std::size_t runs_count = 0;
+        for (std::size_t bit = 0; bit < 64; bit++) {
+            const bool is_set       = ((kIndexMask >> bit) & 1) != 0;
+            const bool previous_set = bit > 0 && ((kIndexMask >> (bit - 1)) & 1) != 0;
+            runs_count += is_set && !previous_set;
+        }
+        return runs_count;
+    }
+
+    STRING_MAP_CONSTEVAL static std::array<BitsRun, CountRuns()> BitsRuns() noexcept {
+        std::array<BitsRun, CountRuns()> runs{};
+        std::size_t runs_count   = 0;
+        std::size_t result_shift = 0;
+        for (std::size_t bit = 0; bit < 64;) {
+            if (((kIndexMask >> bit) & 1) == 0) {
+                bit++;
+                continue;
+            }
+            std::size_t width = 0;
+            while (bit + width < 64 && ((kIndexMask >> (bit + width)) & 1) != 0) {
+                width++;
+            }
+            runs[runs_count++] = {
+                static_cast<std::uint32_t>(bit),
+                static_cast<std::uint32_t>(result_shift),
+                width == 64 ? ~Word{0} : (Word{1} << width) - 1,
+            };
+            result_shift += width;
+            bit += width;
+        }
+        return runs;
+    }
+
+    static constexpr auto kBitsRuns = BitsRuns();
+
+public:
+    static constexpr StringMapFootprint kFootprint = {
+        .backend        = kBackend,
+        .strings_count  = kStringsCount,
+        .nodes_count    = kTableSize,
+        .alphabet_size  = TrieParams.trie_alphabet_size,
+        .bytes_per_node = sizeof(Slot),
+        .table_bytes    = sizeof(kTable) + (Strings.size() + ...) + sizeof(MappedValues),
+        .max_depth      = TrieParams.max_tree_height,
+    };
+
+private:
+    // Pure rather than const: reads the detected features of the host
+    [[nodiscard]] ATTRIBUTE_PURE ATTRIBUTE_ALWAYS_INLINE static constexpr std::size_t ExtractIndex(
+        Word word) noexcept {
+#if STRING_MAP_HAS_BMI2
+        if (!std::is_constant_evaluated()) {
+            return static_cast<std::size_t>(_pext_u64(word, kIndexMask));
+        }
+#elif STRING_MAP_HAS_CPU_DISPATCH
+        // Well predicted branch on the detected flag instead of the indirect call
+        if (!std::is_constant_evaluated() && cpu::GetCpuFeatures().fast_pext) {
+            return static_cast<std::size_t>(cpu::Pext(word, kIndexMask));
+        }
+#endif
+        Word index = 0;
+        for (const BitsRun& run : kBitsRuns) {
+            index |= ((word >> run.shift) & run.mask) << run.result_shift;
+        }
+        return static_cast<std::size_t>(index);
+    }
+
+    // Index of the only key which may be equal to the str, kStringsCount if there is none
+    template <class CharType>
+    [[nodiscard]] ATTRIBUTE_PURE ATTRIBUTE_ALWAYS_INLINE static constexpr std::size_t Candidate(
+        const CharType* str, std::size_t size) noexcept {
+        const std::size_t slot = kTable[ExtractIndex(GatherWord(str, size, kPositions))];
+        return slot != 0 ? slot - 1 : kStringsCount;
+    }
+
+    template <class CharType>
+    [[nodiscard]] ATTRIBUTE_PURE ATTRIBUTE_ALWAYS_INLINE static constexpr bool EqualsKey(
+        std::size_t string_index, const CharType* str, std::size_t size) noexcept {
+        const std::string_view key = kKeys[string_index];
+        if (size != key.size()) {
+            return false;
+        }
+        if (std::is_constant_evaluated()) {
+            for (std::size_t i = 0; i < size; i++) {
+                if (static_cast<char>(str[i]) != key[i]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        return std::memcmp(str, key.data(), size) == 0;
+    }
+
+    template <class IsDelimiter>
+    [[nodiscard]] static constexpr MatchResult match_until_impl(
+        std::string_view buffer, IsDelimiter is_delimiter) noexcept {
+        const MatchResult result =
+            SortedEntries::template MatchUntil<kDefaultValue>(buffer, is_delimiter);
+        stats::RecordLookup<StringMapImplPositions>(result.value != kDefaultValue
+                                                        ? stats::LookupExit::kHit
+                                                        : stats::LookupExit::kMismatch,
+                                                    0);
+        return result;
+    }
+};
+
+/**
+ * Keys of at most 16 bytes packed at compile time into the pairs of the little endian
+ *  integers (just one integer if all keys are at most 8 bytes long). Lookup packs the
+ *  input with a few overlapping unaligned loads and does the branchless binary search
+ *  over the sorted integers, so there are no per char loops and no nodes at all.
+ */
+template <trie_tools::TrieParamsType TrieParams, std::array MappedValues,
+          typename decltype(MappedValues)::value_type DefaultMapValue, CompileTimeStringLiteral... Strings>
+class [[nodiscard]] StringMapImplPacked final
+    : public SortedEntriesQueries<MappedValues, Strings...> {
+    static_assert(0 < TrieParams.min_char && TrieParams.min_char <= TrieParams.max_char &&
+                      TrieParams.max_char <= std::numeric_limits<std::uint8_t>::max(),
+                  "Empty string was passed in StringMatch / StringMap");
+    static_assert(sizeof...(Strings) == std::size(MappedValues) && std::size(MappedValues) > 0,
+                  "internal error");
+    static_assert(TrieParams.max_tree_height <= 16,
+                  "Strings of the StringMapBackend::kPacked should be at most 16 chars long");
+
+public:
+    using MappedType = typename decltype(MappedValues)::value_type;
+    static_assert(std::is_copy_assignable_v<MappedType>);
+
+    static constexpr MappedType kDefaultValue = DefaultMapValue;
+    static constexpr char kMinChar            = static_cast<char>(TrieParams.min_char);
+    static constexpr char kMaxChar            = static_cast<char>(TrieParams.max_char);
+    static constexpr bool kStatsEnabled       = STRING_MAP_ENABLE_STATS;
+    static constexpr StringMapBackend kBackend = StringMapBackend::kPacked;
+    static constexpr auto kMappedValues        = MappedValues;
+    using KeysType                             = KeysList<Strings...>;
+
+    // Number of the integers every key is packed into
+    static constexpr std::size_t kWordsPerKey = TrieParams.max_tree_height <= 8 ? 1 : 2;
+
+    /**
+     * Lookup counters aggregated over all threads. Counters are shared by all
+     *  objects of the same map type. Always empty if STRING_MAP_ENABLE_STATS is 0.
+     */
+    [[nodiscard]] static stats::StringMapStats stats() {
+        return stats::GetLookupStats<StringMapImplPacked>();
+    }
+    static void reset_stats() {
+        stats::ResetLookupStats<StringMapImplPacked>();
+    }
+
+    STRING_MAP_CONSTEVAL StringMapImplPacked() noexcept = default;
+
+    constexpr MappedType operator()(std::nullptr_t) const noexcept              = delete;
+    constexpr MappedType operator()(std::nullptr_t, std::size_t) const noexcept = delete;
+
+    // clang-format off
+    template <class CharType>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(std::basic_string_view<CharType> str) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size());
+    }
+    // clang-format off
+    template <class CharType>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(const std::basic_string<CharType>& str) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size());
+    }
+    // clang-format off
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    ATTRIBUTE_ACCESS(read_only, 2)
+    constexpr MappedType operator()(const char* str) const noexcept {
+        // clang-format on
+        if (str == nullptr) [[unlikely]] {
+            return kDefaultValue;
+        }
+        return operator()(str, std::char_traits<char>::length(str));
+    }
+    // clang-format off
+    template <class CharType>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    ATTRIBUTE_SIZED_ACCESS(read_only, 2, 3)
+    constexpr MappedType operator()(const CharType* str, std::size_t size) const noexcept {
+        // clang-format on
+        static_assert(sizeof(CharType) == sizeof(char));
+        if (size == 0 || size > TrieParams.max_tree_height) {
+            stats::RecordLookup<StringMapImplPacked>(stats::LookupExit::kMismatch, 0);
+            return kDefaultValue;
+        }
+        if (std::is_constant_evaluated() || std::endian::native != std::endian::little) {
+            return Find(PackSlow(str, size), size);
+        }
+        return Find(Pack(str, size), size);
+    }
+
+#if STRING_MAP_HAS_SPAN
+    // clang-format off
+    template <class CharType, std::size_t SpanExtent>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(std::span<const CharType, SpanExtent> str) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size());
+    }
+#endif
+
+    /**
+     * Lookup of the string followed by at least Padding readable bytes: with the padding
+     *  of 15 bytes the input is packed with the full-width loads and masks.
+     */
+    // clang-format off
+    template <class CharType, std::size_t Padding>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(std::basic_string_view<CharType> str, PaddedInput<Padding> padding) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size(), padding);
+    }
+    // clang-format off
+    template <class CharType, std::size_t Padding>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(const CharType* str, std::size_t size, PaddedInput<Padding>) const noexcept {
+        // clang-format on
+        static_assert(sizeof(CharType) == sizeof(char));
+        if constexpr (Padding + 1 >= kWordsPerKey * sizeof(Word)) {
+            if (!std::is_constant_evaluated() && std::endian::native == std::endian::little) {
+                if (size == 0 || size > TrieParams.max_tree_height) {
+                    stats::RecordLookup<StringMapImplPacked>(stats::LookupExit::kMismatch, 0);
+                    return kDefaultValue;
+                }
+                return Find(PackPadded(str, size), size);
+            }
+        }
+        return operator()(str, size);
+    }
+
+    using MatchResult = StringMapMatchResult<MappedType>;
+
+    /**
+     * Same as StringMapImplManyStrings::match_until. The packed keys do not apply to the
+     *  prefixes, so the range of the sorted keys is narrowed per char instead, see
+     *  SortedEntriesTable::MatchUntil.
+     */
+    template <char... Delimiters>
+    [[nodiscard]] static constexpr MatchResult match_until(std::string_view buffer) noexcept {
+        return match_until_impl(
+            buffer, [](const char chr) constexpr noexcept { return ((chr == Delimiters) || ...); });
+    }
+    [[nodiscard]] static constexpr MatchResult match_until(std::string_view buffer,
+                                                           std::string_view delimiters) noexcept {
+        return match_until_impl(buffer, [delimiters](const char chr) constexpr noexcept {
+            return delimiters.find(chr) != std::string_view::npos;
+        });
+    }
+
+private:
+    using SortedEntries = SortedEntriesTable<MappedValues, Strings...>;
+    using Word          = std::uint64_t;
+
+    static constexpr std::size_t kStringsCount = sizeof...(Strings);
+
+    // Chars [0, 8) are in the low word, [8, 16) in the high one, the first char
+    //  is the lowest byte. Unused bytes are 0 which is never a char of the keys
+    struct PackedKey final {
+        Word low{};
+        Word high{};
+
+        [[nodiscard]] constexpr bool operator==(const PackedKey&) const noexcept = default;
+    };
+
+    [[nodiscard]] ATTRIBUTE_PURE ATTRIBUTE_ALWAYS_INLINE static constexpr bool Less(
+        const PackedKey& lhs, const PackedKey& rhs) noexcept {
+        if constexpr (kWordsPerKey == 1) {
+            return lhs.low < rhs.low;
+        } else {
+#if defined(__SIZEOF_INT128__)
+            // One 128 bit comparison instead of the branches on the low words
+            if (!std::is_constant_evaluated()) {
+                __extension__ typedef unsigned __int128 Wide;
+                return ((Wide{lhs.low} << 64) | lhs.high) < ((Wide{rhs.low} << 64) | rhs.high);
+            }
+#endif
+            return lhs.low < rhs.low || (lhs.low == rhs.low && lhs.high < rhs.high);
+        }
+    }
+
+    template <class CharType>
+    [[nodiscard]] static constexpr PackedKey PackSlow(const CharType* str,
+                                                      std::size_t size) noexcept {
+        PackedKey key{};
+        for (std::size_t i = 0; i < size; i++) {
+            const Word byte = static_cast<unsigned char>(str[i]);
+            if (i < sizeof(Word)) {
+                key.low |= byte << (8 * i);
+            } else {
+                key.high |= byte << (8 * (i - sizeof(Word)));
+            }
+        }
+        return key;
+    }
+
+    template <std::size_t Bytes>
+    [[nodiscard]] ATTRIBUTE_ALWAYS_INLINE static Word Load(const void* ptr) noexcept {
+        if constexpr (Bytes == 8) {
+            std::uint64_t word;
+            std::memcpy(&word, ptr, sizeof(word));
+            return word;
+        } else {
+            static_assert(Bytes == 4);
+            std::uint32_t word;
+            std::memcpy(&word, ptr, sizeof(word));
+            return word;
+        }
+    }
+
+    // Packs 1 <= size <= 16 chars without reading out of [str, str + size): loads
+    //  overlap and the overlapped bytes are the same, so they are combined with or
+    template <class CharType>
+    [[nodiscard]] ATTRIBUTE_ALWAYS_INLINE static PackedKey Pack(const CharType* str,
+                                                                std::size_t size) noexcept {
+        const auto* const bytes = reinterpret_cast<const unsigned char*>(str);
+        if (size >= 8) {
+            PackedKey key{Load<8>(bytes), 0};
+            if constexpr (kWordsPerKey == 2) {
+                if (size > 8) {
+                    key.high = Load<8>(bytes + size - 8) >> (8 * (16 - size));
+                }
+            }
+            return key;
+        }
+        if (size >= 4) {
+            return {Load<4>(bytes) | (Load<4>(bytes + size - 4) << (8 * (size - 4))), 0};
+        }
+        // Chars 0, size / 2 and size - 1 cover all chars of the string of 1...3 chars
+        return {Word{bytes[0]} | (Word{bytes[size / 2]} << (8 * (size / 2))) |
+                    (Word{bytes[size - 1]} << (8 * (size - 1))),
+                0};
+    }
+
+    template <class CharType>
+    [[nodiscard]] ATTRIBUTE_ALWAYS_INLINE static PackedKey PackPadded(const CharType* str,
+                                                                      std::size_t size) noexcept {
+        const auto* const bytes = reinterpret_cast<const unsigned char*>(str);
+        const auto first_bytes_mask = [](std::size_t bytes_count) noexcept {
+            return bytes_count >= 8 ? ~Word{0} : (Word{1} << (8 * bytes_count)) - 1;
+        };
+        PackedKey key{Load<8>(bytes) & first_bytes_mask(size), 0};
+        if constexpr (kWordsPerKey == 2) {
+            key.high = Load<8>(bytes + 8) & (size > 8 ? first_bytes_mask(size - 8) : 0);
+        }
+        return key;
+    }
+
+    STRING_MAP_CONSTEVAL static std::array<std::size_t, kStringsCount> Order() noexcept {
+        const std::array<PackedKey, kStringsCount> keys = {
+            PackSlow(Strings.value.data(), Strings.length)...,
+        };
+        std::array<std::size_t, kStringsCount> order{};
+        for (std::size_t i = 0; i < kStringsCount; i++) {
+            std::size_t j = i;
+            for (; j > 0 && Less(keys[i], keys[order[j - 1]]); j--) {
+                order[j] = order[j - 1];
+            }
+            order[j] = i;
+        }
+        return order;
+    }
+
+    // kOrder[rank] is the index of the string with this rank of its packed key
+    static constexpr std::array<std::size_t, kStringsCount> kOrder = Order();
+
+    template <std::size_t... Ranks>
+    STRING_MAP_CONSTEVAL static std::array<PackedKey, kStringsCount> SortedKeys(
+        std::index_sequence<Ranks...>) noexcept {
+        const std::array<PackedKey, kStringsCount> keys = {
+            PackSlow(Strings.value.data(), Strings.length)...,
+        };
+        return {keys[kOrder[Ranks]]...};
+    }
+    template <std::size_t... Ranks>
+    STRING_MAP_CONSTEVAL static std::array<std::uint8_t, kStringsCount> SortedLengths(
+        std::index_sequence<Ranks...>) noexcept {
+        const std::array<std::size_t, kStringsCount> lengths = {Strings.length...};
+        return {static_cast<std::uint8_t>(lengths[kOrder[Ranks]])...};
+    }
+    template <std::size_t... Ranks>
+    STRING_MAP_CONSTEVAL static std::array<MappedType, kStringsCount> SortedValues(
+        std::index_sequence<Ranks...>) noexcept {
+        return {MappedValues[kOrder[Ranks]]...};
+    }
+
+    static constexpr std::array<PackedKey, kStringsCount> kKeys =
+        SortedKeys(std::make_index_sequence<kStringsCount>{});
+    static constexpr std::array<std::uint8_t, kStringsCount> kLengths =
+        SortedLengths(std::make_index_sequence<kStringsCount>{});
+    static constexpr std::array<MappedType, kStringsCount> kValues =
+        SortedValues(std::make_index_sequence<kStringsCount>{});
+
+public:
+    static constexpr StringMapFootprint kFootprint = {
+        .backend        = kBackend,
+        .strings_count  = kStringsCount,
+        .nodes_count    = 0,
+        .alphabet_size  = TrieParams.trie_alphabet_size,
+        .bytes_per_node = 0,
+        .table_bytes    = kStringsCount * kWordsPerKey * sizeof(Word) + sizeof(kLengths) +
+                          sizeof(kValues),
+        .max_depth      = TrieParams.max_tree_height,
+    };
+
+private:
+    // Input "GET\0" is packed as "GET", so the length is checked too
+    [[nodiscard]] ATTRIBUTE_LOOKUP_PURE ATTRIBUTE_ALWAYS_INLINE static constexpr MappedType Find(
+        const PackedKey& key, std::size_t size) noexcept {
+        // Branchless lower bound: the range halves every step regardless of the comparison
+        const PackedKey* first = kKeys.data();
+        std::size_t length     = kStringsCount;
+        while (length > 1) {
+            const std::size_t half = length / 2;
+            first += Less(first[half], key) ? half : 0;
+            length -= half;
+        }
+        // first is the last key < key or the lower bound itself
+        first += Less(*first, key);
+        const auto rank = static_cast<std::size_t>(first - kKeys.data());
+        if (rank < kStringsCount && *first == key && kLengths[rank] == size) {
+            stats::RecordLookup<StringMapImplPacked>(stats::LookupExit::kHit, 0);
+            return kValues[rank];
+        }
+        stats::RecordLookup<StringMapImplPacked>(stats::LookupExit::kMismatch, 0);
+        return kDefaultValue;
+    }
+
+    template <class IsDelimiter>
+    [[nodiscard]] static constexpr MatchResult match_until_impl(
+        std::string_view buffer, IsDelimiter is_delimiter) noexcept {
+        const MatchResult result =
+            SortedEntries::template MatchUntil<kDefaultValue>(buffer, is_delimiter);
+        stats::RecordLookup<StringMapImplPacked>(result.value != kDefaultValue
+                                                     ? stats::LookupExit::kHit
+                                                     : stats::LookupExit::kMismatch,
+                                                 0);
+        return result;
+    }
+};
+
+/**
+ * Trie walked with the fixed amount of work: every lookup takes exactly kSteps steps
+ *  (length of the longest key) without the data dependent branches. The string end,
+ *  a char out of the alphabet and a missing edge select the special columns of the
+ *  edges table with masks instead of the early exits: missing edges lead to the sink
+ *  node 0 which never leaves, steps after the end of the string stay at the same node.
+ * Latency does not depend on the input except through the caches: addresses of the
+ *  loaded edges still depend on the chars.
+ */
+template <trie_tools::TrieParamsType TrieParams, std::array MappedValues,
+          typename decltype(MappedValues)::value_type DefaultMapValue, CompileTimeStringLiteral... Strings>
+class [[nodiscard]] StringMapImplFixedWork final
+    : public SortedEntriesQueries<MappedValues, Strings...> {
+    static_assert(0 < TrieParams.min_char && TrieParams.min_char <= TrieParams.max_char &&
+                      TrieParams.max_char <= std::numeric_limits<std::uint8_t>::max(),
+                  "Empty string was passed in StringMatch / StringMap");
+    static_assert(sizeof...(Strings) == std::size(MappedValues) && std::size(MappedValues) > 0,
+                  "internal error");
+
+public:
+    using MappedType = typename decltype(MappedValues)::value_type;
+    static_assert(std::is_copy_assignable_v<MappedType>);
+
+    static constexpr MappedType kDefaultValue = DefaultMapValue;
+    static constexpr char kMinChar            = static_cast<char>(TrieParams.min_char);
+    static constexpr char kMaxChar            = static_cast<char>(TrieParams.max_char);
+    static constexpr bool kStatsEnabled       = STRING_MAP_ENABLE_STATS;
+    static constexpr StringMapBackend kBackend = StringMapBackend::kFixedWork;
+    static constexpr auto kMappedValues        = MappedValues;
+    using KeysType                             = KeysList<Strings...>;
+
+    // Number of the steps of every lookup
+    static constexpr std::size_t kSteps = TrieParams.max_tree_height;
+
+    /**
+     * Lookup counters aggregated over all threads. Counters are shared by all
+     *  objects of the same map type. Always empty if STRING_MAP_ENABLE_STATS is 0.
+     */
+    [[nodiscard]] static stats::StringMapStats stats() {
+        return stats::GetLookupStats<StringMapImplFixedWork>();
+    }
+    static void reset_stats() {
+        stats::ResetLookupStats<StringMapImplFixedWork>();
+    }
+
+    STRING_MAP_CONSTEVAL StringMapImplFixedWork() noexcept = default;
+
+    constexpr MappedType operator()(std::nullptr_t) const noexcept              = delete;
+    constexpr MappedType operator()(std::nullptr_t, std::size_t) const noexcept = delete;
+
+    // clang-format off
+    template <class CharType>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(std::basic_string_view<CharType> str) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size());
+    }
+    // clang-format off
+    template <class CharType>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(const std::basic_string<CharType>& str) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size());
+    }
+    // clang-format off
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    ATTRIBUTE_ACCESS(read_only, 2)
+    constexpr MappedType operator()(const char* str) const noexcept {
+        // clang-format on
+        if (str == nullptr) [[unlikely]] {
+            return kDefaultValue;
+        }
+        return operator()(str, std::char_traits<char>::length(str));
+    }
+    // clang-format off
+    template <class CharType>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    ATTRIBUTE_SIZED_ACCESS(read_only, 2, 3)
+    constexpr MappedType operator()(const CharType* str, std::size_t size) const noexcept {
+        // clang-format on
+        static_assert(sizeof(CharType) == sizeof(char));
+        const MappedType returned_value = kNodeValues[FinalNode(str, size) / kColumnsCount];
+        stats::RecordLookup<StringMapImplFixedWork>(returned_value != kDefaultValue
+                                                        ? stats::LookupExit::kHit
+                                                        : stats::LookupExit::kMismatch,
+                                                    kSteps);
+        return returned_value;
+    }
+
+#if STRING_MAP_HAS_SPAN
+    // clang-format off
+    template <class CharType, std::size_t SpanExtent>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(std::span<const CharType, SpanExtent> str) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size());
+    }
+#endif
+
+    /**
+     * Lookup of the string followed by at least Padding readable bytes. All steps are
+     *  done anyway, so it is the same as the regular lookup.
+     */
+    // clang-format off
+    template <class CharType, std::size_t Padding>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(std::basic_string_view<CharType> str, PaddedInput<Padding>) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size());
+    }
+    // clang-format off
+    template <class CharType, std::size_t Padding>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(const CharType* str, std::size_t size, PaddedInput<Padding>) const noexcept {
+        // clang-format on
+        return operator()(str, size);
+    }
+
+    using MatchResult = StringMapMatchResult<MappedType>;
+
+    /**
+     * Same as StringMapImplManyStrings::match_until. Edges table is walked until the
+     *  delimiter or the sink node, so unlike the lookup the work done depends on the buffer.
+     */
+    template <char... Delimiters>
+    [[nodiscard]] static constexpr MatchResult match_until(std::string_view buffer) noexcept {
+        return match_until_impl(
+            buffer, [](const char chr) constexpr noexcept { return ((chr == Delimiters) || ...); });
+    }
+    [[nodiscard]] static constexpr MatchResult match_until(std::string_view buffer,
+                                                           std::string_view delimiters) noexcept {
+        return match_until_impl(buffer, [delimiters](const char chr) constexpr noexcept {
+            return delimiters.find(chr) != std::string_view::npos;
+        });
+    }
+
+private:
+    using SortedEntries = SortedEntriesTable<MappedValues, Strings...>;
+
+    static constexpr std::size_t kTrieNodesSize    = TrieParams.nodes_size;
+    static constexpr std::size_t kTrieAlphabetSize = TrieParams.trie_alphabet_size;
+
+    using Trie     = SortedKeysTrie<kTrieNodesSize, MappedValues, Strings...>;
+    using TrieNode = typename Trie::Node;
+
+    // Node 0 is the sink, trie node i is the node i + 1
+    static constexpr std::size_t kNodesSize = kTrieNodesSize + 1;
+    static constexpr std::size_t kSinkNode  = 0;
+    static constexpr std::size_t kRootNode  = 1;
+
+    // Columns of the alphabet chars, then the column of the chars out of the
+    //  alphabet (always leads to the sink) and the column of the string end (self loop)
+    static constexpr std::size_t kOutOfAlphabetColumn = kTrieAlphabetSize;
+    static constexpr std::size_t kEndColumn           = kTrieAlphabetSize + 1;
+    static constexpr std::size_t kColumnsCount        = kTrieAlphabetSize + 2;
+
+    using Column = std::conditional_t<(kColumnsCount <= std::numeric_limits<std::uint8_t>::max()),
+                                      std::uint8_t, std::uint16_t>;
+
+    // Edges hold the offset of the node row (node * kColumnsCount) instead of the node
+    //  index, so there is no multiplication in the chain of the dependent loads
+    static constexpr std::size_t kEdgesSize = kNodesSize * kColumnsCount;
+    using NodeOffset = std::conditional_t<(kEdgesSize <= std::numeric_limits<std::uint16_t>::max()),
+                                          std::uint16_t, std::uint32_t>;
+
+    STRING_MAP_CONSTEVAL static std::array<Column, 256> BuildColumns() noexcept {
+        std::array<Column, 256> columns{};
+        for (std::size_t chr = 0; chr < columns.size(); chr++) {
+            const std::size_t index = TrieParams.CharToNodeIndex(static_cast<char>(chr));
+            columns[chr] =
+                static_cast<Column>(index < kTrieAlphabetSize ? index : kOutOfAlphabetColumn);
+        }
+        return columns;
+    }
+
+    STRING_MAP_CONSTEVAL static std::array<NodeOffset, kEdgesSize> BuildEdges() noexcept {
+        std::array<NodeOffset, kEdgesSize> edges{};
+        for (std::size_t trie_node = 0; trie_node < kTrieNodesSize; trie_node++) {
+            const TrieNode& node   = Trie::kNodes[trie_node];
+            const std::size_t from = trie_node + 1;
+            for (std::size_t i = 0; i < node.children_count; i++) {
+                const std::size_t child = node.first_child + i;
+                const std::size_t column =
+                    TrieParams.CharToNodeIndex(Trie::EdgeChar(Trie::kNodes[child]));
+                edges[from * kColumnsCount + column] =
+                    static_cast<NodeOffset>((child + 1) * kColumnsCount);
+            }
+            edges[from * kColumnsCount + kEndColumn] =
+                static_cast<NodeOffset>(from * kColumnsCount);
+        }
+        return edges;
+    }
+
+    STRING_MAP_CONSTEVAL static std::array<MappedType, kNodesSize> BuildNodeValues() noexcept {
+        std::array<MappedType, kNodesSize> values{};
+        values[kSinkNode] = kDefaultValue;
+        for (std::size_t trie_node = 0; trie_node < kTrieNodesSize; trie_node++) {
+            const TrieNode& node  = Trie::kNodes[trie_node];
+            values[trie_node + 1] = Trie::IsTerminal(node)
+                                        ? SortedEntries::kEntries[node.begin].value
+                                        : kDefaultValue;
+        }
+        return values;
+    }
+
+    static constexpr std::array<Column, 256> kColumns = BuildColumns();
+    static constexpr std::array<NodeOffset, kEdgesSize> kEdges = BuildEdges();
+    static constexpr std::array<MappedType, kNodesSize> kNodeValues = BuildNodeValues();
+
+public:
+    static constexpr StringMapFootprint kFootprint = {
+        .backend        = kBackend,
+        .strings_count  = sizeof...(Strings),
+        .nodes_count    = kNodesSize,
+        .alphabet_size  = kTrieAlphabetSize,
+        .bytes_per_node = kColumnsCount * sizeof(NodeOffset) + sizeof(MappedType),
+        .table_bytes    = sizeof(kColumns) + sizeof(kEdges) + sizeof(kNodeValues),
+        .max_depth      = kSteps,
+    };
+
+private:
+    static constexpr unsigned char kEmptyStringByte = 0;
+
+    // Returns offset of the row of the node where the string ends
+    template <class CharType>
+    [[nodiscard]] ATTRIBUTE_PURE ATTRIBUTE_ALWAYS_INLINE static constexpr std::size_t FinalNode(
+        const CharType* str, std::size_t size) noexcept {
+        constexpr std::size_t kRootOffset = kRootNode * kColumnsCount;
+        if (std::is_constant_evaluated()) {
+            std::size_t offset = size <= kSteps ? kRootOffset : kSinkNode;
+            for (std::size_t i = 0; i < size && offset != kSinkNode; i++) {
+                offset = kEdges[offset + kColumns[static_cast<unsigned char>(str[i])]];
+            }
+            return offset;
+        }
+
+        // The only branch on the input, empty string_view may have nullptr data
+        const auto* const bytes = size != 0 ? reinterpret_cast<const unsigned char*>(str)
+                                            : &kEmptyStringByte;
+        // All ones if the string is not longer than the longest key, 0 otherwise
+        const std::size_t fits = std::size_t{0} - static_cast<std::size_t>(size <= kSteps);
+        std::size_t offset     = kRootOffset & fits;
+        for (std::size_t i = 0; i < kSteps; i++) {
+            const std::size_t in_string =
+                std::size_t{0} - static_cast<std::size_t>(i < size);
+            // Char 0 of the string is reloaded after the end, its column is not used
+            const std::size_t column =
+                (kColumns[bytes[i & in_string]] & in_string) | (kEndColumn & ~in_string);
+            offset = kEdges[offset + column];
+        }
+        return offset;
+    }
+
+    template <class IsDelimiter>
+    [[nodiscard]] static constexpr MatchResult match_until_impl(
+        std::string_view buffer, IsDelimiter is_delimiter) noexcept {
+        // Walks the edges table until the delimiter, the end of the buffer or the sink
+        std::size_t offset   = kRootNode * kColumnsCount;
+        std::size_t position = 0;
+        for (; position < buffer.size() && !is_delimiter(buffer[position]); position++) {
+            const std::size_t next =
+                kEdges[offset + kColumns[static_cast<unsigned char>(buffer[position])]];
+            if (next == kSinkNode) {
+                break;
+            }
+            offset = next;
+        }
+        const MatchResult result = {
+            position == buffer.size() || is_delimiter(buffer[position])
+                ? kNodeValues[offset / kColumnsCount]
+                : kDefaultValue,
+            position,
+        };
+        stats::RecordLookup<StringMapImplFixedWork>(result.value != kDefaultValue
+                                                        ? stats::LookupExit::kHit
+                                                        : stats::LookupExit::kMismatch,
+                                                    result.position);
+        return result;
+    }
+};
+
+/**
+ * Sorted keys searched by the first 8 chars: the prefixes (big endian, padded with 0,
+ *  so they compare as the strings do) are laid out at compile time in the Eytzinger
+ *  (BFS) order, where the children of the node k are 2k and 2k + 1. Lookup descends
+ *  the implicit tree without branches on the comparisons and prefetches the nodes a
+ *  few levels below the current one, so for the large key sets the cache misses of
+ *  the levels overlap. Keys with the same prefix are told apart by the binary search
+ *  over their full strings.
+ * Table is one uint64_t and two small ranks per key, whatever the keys length is.
+ */
+template <trie_tools::TrieParamsType TrieParams, std::array MappedValues,
+          typename decltype(MappedValues)::value_type DefaultMapValue, CompileTimeStringLiteral... Strings>
+class [[nodiscard]] StringMapImplEytzinger final
+    : public SortedEntriesQueries<MappedValues, Strings...> {
+    static_assert(0 < TrieParams.min_char && TrieParams.min_char <= TrieParams.max_char &&
+                      TrieParams.max_char <= std::numeric_limits<std::uint8_t>::max(),
+                  "Empty string was passed in StringMatch / StringMap");
+    static_assert(sizeof...(Strings) == std::size(MappedValues) && std::size(MappedValues) > 0,
+                  "internal error");
+
+public:
+    using MappedType = typename decltype(MappedValues)::value_type;
+    static_assert(std::is_copy_assignable_v<MappedType>);
+
+    static constexpr MappedType kDefaultValue = DefaultMapValue;
+    static constexpr char kMinChar            = static_cast<char>(TrieParams.min_char);
+    static constexpr char kMaxChar            = static_cast<char>(TrieParams.max_char);
+    static constexpr bool kStatsEnabled       = STRING_MAP_ENABLE_STATS;
+    static constexpr StringMapBackend kBackend = StringMapBackend::kEytzinger;
+    static constexpr auto kMappedValues        = MappedValues;
+    using KeysType                             = KeysList<Strings...>;
+
+    /**
+     * Lookup counters aggregated over all threads. Counters are shared by all
+     *  objects of the same map type. Always empty if STRING_MAP_ENABLE_STATS is 0.
+     */
+    [[nodiscard]] static stats::StringMapStats stats() {
+        return stats::GetLookupStats<StringMapImplEytzinger>();
+    }
+    static void reset_stats() {
+        stats::ResetLookupStats<StringMapImplEytzinger>();
+    }
+
+    STRING_MAP_CONSTEVAL StringMapImplEytzinger() noexcept = default;
+
+    constexpr MappedType operator()(std::nullptr_t) const noexcept              = delete;
+    constexpr MappedType operator()(std::nullptr_t, std::size_t) const noexcept = delete;
+
+    // clang-format off
+    template <class CharType>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(std::basic_string_view<CharType> str) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size());
+    }
+    // clang-format off
+    template <class CharType>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(const std::basic_string<CharType>& str) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size());
+    }
+    // clang-format off
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    ATTRIBUTE_ACCESS(read_only, 2)
+    constexpr MappedType operator()(const char* str) const noexcept {
+        // clang-format on
+        if (str == nullptr) [[unlikely]] {
+            return kDefaultValue;
+        }
+        return operator()(str, std::char_traits<char>::length(str));
+    }
+    // clang-format off
+    template <class CharType>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_SIZED_ACCESS(read_only, 2, 3)
+    constexpr MappedType operator()(const CharType* str, std::size_t size) const noexcept {
+        // clang-format on
+        static_assert(sizeof(CharType) == sizeof(char));
+        if (size == 0 || size > TrieParams.max_tree_height) {
+            stats::RecordLookup<StringMapImplEytzinger>(stats::LookupExit::kMismatch, 0);
+            return kDefaultValue;
+        }
+        if (std::is_constant_evaluated() || std::endian::native != std::endian::little) {
+            return Find(str, size, PrefixSlow(str, size));
+        }
+        return Find(str, size, Prefix(str, size));
+    }
+
+#if STRING_MAP_HAS_SPAN
+    // clang-format off
+    template <class CharType, std::size_t SpanExtent>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(std::span<const CharType, SpanExtent> str) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size());
+    }
+#endif
+
+    /**
+     * Lookup of the string followed by at least Padding readable bytes. With 7 bytes
+     *  of the padding the prefix is one 8 bytes load with the bytes after the end
+     *  masked out, otherwise it is the regular lookup.
+     */
+    // clang-format off
+    template <class CharType, std::size_t Padding>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(std::basic_string_view<CharType> str, PaddedInput<Padding>) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size(), PaddedInput<Padding>{});
+    }
+    // clang-format off
+    template <class CharType, std::size_t Padding>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    constexpr MappedType operator()(const CharType* str, std::size_t size, PaddedInput<Padding>) const noexcept {
+        // clang-format on
+        static_assert(sizeof(CharType) == sizeof(char));
+        if constexpr (Padding + 1 >= sizeof(Word)) {
+            if (!std::is_constant_evaluated() && std::endian::native == std::endian::little) {
+                if (size == 0 || size > TrieParams.max_tree_height) {
+                    stats::RecordLookup<StringMapImplEytzinger>(stats::LookupExit::kMismatch, 0);
+                    return kDefaultValue;
+                }
+                return Find(str, size, PaddedPrefix(str, size));
+            }
+        }
+        return operator()(str, size);
+    }
+
+    using MatchResult = StringMapMatchResult<MappedType>;
+
+    /**
+     * Same as StringMapImplManyStrings::match_until. The Eytzinger layout does not apply to
+     *  the prefixes, so the range of the sorted keys is narrowed per char instead, see
+     *  SortedEntriesTable::MatchUntil.
+     */
+    template <char... Delimiters>
+    [[nodiscard]] static constexpr MatchResult match_until(std::string_view buffer) noexcept {
+        return match_until_impl(
+            buffer, [](const char chr) constexpr noexcept { return ((chr == Delimiters) || ...); });
+    }
+    [[nodiscard]] static constexpr MatchResult match_until(std::string_view buffer,
+                                                           std::string_view delimiters) noexcept {
+        return match_until_impl(buffer, [delimiters](const char chr) constexpr noexcept {
+            return delimiters.find(chr) != std::string_view::npos;
+        });
+    }
+
+private:
+    using SortedEntries = SortedEntriesTable<MappedValues, Strings...>;
+    using Word          = std::uint64_t;
+
+    static constexpr std::size_t kStringsCount = sizeof...(Strings);
+
+    // Rank of the key in the SortedEntries
+    using Rank = std::conditional_t<kStringsCount < std::numeric_limits<std::uint16_t>::max(),
+                                    std::uint16_t, std::uint32_t>;
+
+    // Prefetched node is 3 levels below the current one: its 8 descendants on that level
+    //  are 8 adjacent prefixes, i.e. one cache line
+    static constexpr std::size_t kPrefetchLevels = 3;
+    static constexpr std::size_t kCacheLineSize  = 64;
+
+    // First 8 chars, the first one is the highest byte
+    template <class CharType>
+    [[nodiscard]] static constexpr Word PrefixSlow(const CharType* str, std::size_t size) noexcept {
+        Word prefix = 0;
+        for (std::size_t i = 0; i < sizeof(Word); i++) {
+            prefix = (prefix << 8) | (i < size ? static_cast<unsigned char>(str[i]) : 0);
+        }
+        return prefix;
+    }
+
+    template <std::size_t Bytes>
+    [[nodiscard]] ATTRIBUTE_ALWAYS_INLINE static Word Load(const void* ptr) noexcept {
+        if constexpr (Bytes == 8) {
+            std::uint64_t word;
+            std::memcpy(&word, ptr, sizeof(word));
+            return word;
+        } else {
+            static_assert(Bytes == 4);
+            std::uint32_t word;
+            std::memcpy(&word, ptr, sizeof(word));
+            return word;
+        }
+    }
+
+    [[nodiscard]] ATTRIBUTE_CONST ATTRIBUTE_ALWAYS_INLINE static Word ByteSwap(Word word) noexcept {
+#if CONFIG_HAS_BUILTIN(__builtin_bswap64)
+        return __builtin_bswap64(word);
+#else
+        Word swapped = 0;
+        for (std::size_t i = 0; i < sizeof(Word); i++) {
+            swapped = (swapped << 8) | ((word >> (8 * i)) & 0xFF);
+        }
+        return swapped;
+#endif
+    }
+
+    // Same as PrefixSlow for 1 <= size on the little endian hosts, loads do not read out
+    //  of [str, str + size) and overlap like in the StringMapImplPacked::Pack
+    template <class CharType>
+    [[nodiscard]] ATTRIBUTE_ALWAYS_INLINE static Word Prefix(const CharType* str,
+                                                             std::size_t size) noexcept {
+        const auto* const bytes = reinterpret_cast<const unsigned char*>(str);
+        Word word;
+        if (size >= 8) {
+            word = Load<8>(bytes);
+        } else if (size >= 4) {
+            word = Load<4>(bytes) | (Load<4>(bytes + size - 4) << (8 * (size - 4)));
+        } else {
+            word = Word{bytes[0]} | (Word{bytes[size / 2]} << (8 * (size / 2))) |
+                   (Word{bytes[size - 1]} << (8 * (size - 1)));
+        }
+        return ByteSwap(word);
+    }
+
+    // Same as Prefix for 1 <= size if at least 7 bytes after the str are readable
+    template <class CharType>
+    [[nodiscard]] ATTRIBUTE_ALWAYS_INLINE static Word PaddedPrefix(const CharType* str,
+                                                                   std::size_t size) noexcept {
+        const Word word = Load<8>(str);
+        const Word mask = size >= sizeof(Word) ? ~Word{0} : (Word{1} << (8 * size)) - 1;
+        return ByteSwap(word & mask);
+    }
+
+    struct Layout final {
+        // Index 0 is unused, the root is 1
+        std::array<Word, kStringsCount + 1> prefixes{};
+        std::array<Rank, kStringsCount + 1> ranks{};
+        // End of the run of the keys with the same prefix as the key with this rank
+        std::array<Rank, kStringsCount> group_ends{};
+    };
+
+    // In-order traversal of the implicit tree visits the nodes in the sorted order
+    STRING_MAP_CONSTEVAL static void Fill(Layout& layout, std::size_t node,
+                                          std::size_t& rank) noexcept {
+        if (node > kStringsCount) {
+            return;
+        }
+        Fill(layout, 2 * node, rank);
+        const std::string_view key = SortedEntries::kEntries[rank].key;
+        layout.prefixes[node]      = PrefixSlow(key.data(), key.size());
+        layout.ranks[node]         = static_cast<Rank>(rank);
+        rank++;
+        Fill(layout, 2 * node + 1, rank);
+    }
+
+    STRING_MAP_CONSTEVAL static Layout BuildLayout() noexcept {
+        Layout layout{};
+        std::size_t rank = 0;
+        Fill(layout, 1, rank);
+        std::size_t group_end = kStringsCount;
+        for (std::size_t i = kStringsCount; i > 0; i--) {
+            const std::string_view key = SortedEntries::kEntries[i - 1].key;
+            if (i < kStringsCount) {
+                const std::string_view next_key = SortedEntries::kEntries[i].key;
+                if (PrefixSlow(key.data(), key.size()) !=
+                    PrefixSlow(next_key.data(), next_key.size())) {
+                    group_end = i;
+                }
+            }
+            layout.group_ends[i - 1] = static_cast<Rank>(group_end);
+        }
+        return layout;
+    }
+
+    static constexpr Layout kLayout = BuildLayout();
+
+    struct alignas(kCacheLineSize) AlignedPrefixes final {
+        std::array<Word, kStringsCount + 1> values{};
+    };
+    // Siblings 8k...8k + 7 share one cache line
+    static constexpr AlignedPrefixes kPrefixes = {kLayout.prefixes};
+
+    [[nodiscard]] ATTRIBUTE_CONST ATTRIBUTE_ALWAYS_INLINE static constexpr std::size_t
+    CountTrailingOnes(std::size_t value) noexcept {
+#if STRING_MAP_HAS_BIT
+        return static_cast<std::size_t>(std::countr_one(value));
+#else
+        std::size_t count = 0;
+        while ((value & 1) != 0) {
+            value >>= 1;
+            count++;
+        }
+        return count;
+#endif
+    }
+
+public:
+    // Number of the levels of the implicit tree every lookup descends
+    static constexpr std::size_t kLevels = [] {
+        std::size_t levels = 0;
+        while ((std::size_t{1} << levels) <= kStringsCount) {
+            levels++;
+        }
+        return levels;
+    }();
+
+    static constexpr StringMapFootprint kFootprint = {
+        .backend        = kBackend,
+        .strings_count  = kStringsCount,
+        .nodes_count    = kStringsCount,
+        .alphabet_size  = TrieParams.trie_alphabet_size,
+        .bytes_per_node = sizeof(Word) + 2 * sizeof(Rank),
+        .table_bytes    = sizeof(kPrefixes) + sizeof(kLayout.ranks) + sizeof(kLayout.group_ends) +
+                          sizeof(SortedEntries::kEntries),
+        .max_depth      = kLevels,
+    };
+
+private:
+    template <class CharType>
+    [[nodiscard]] ATTRIBUTE_LOOKUP_PURE ATTRIBUTE_ALWAYS_INLINE static constexpr MappedType Find(
+        const CharType* str, std::size_t size, Word prefix) noexcept {
+        const Word* const prefixes = kPrefixes.values.data();
+        std::size_t node           = 1;
+        while (node <= kStringsCount) {
+            if (!std::is_constant_evaluated()) {
+                // Address may be past the end of the table, prefetch does not fault
+                //  and the pointer is never dereferenced
+                const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(prefixes) +
+                                               (node << kPrefetchLevels) * sizeof(Word);
+#if defined(__GNUC__) || defined(__clang__)
+                __builtin_prefetch(reinterpret_cast<const void*>(address));
+#elif STRING_MAP_HAS_SSE2
+                _mm_prefetch(reinterpret_cast<const char*>(address), _MM_HINT_T0);
+#else
+                static_cast<void>(address);
+#endif
+            }
+            node = 2 * node + static_cast<std::size_t>(prefixes[node] < prefix);
+        }
+        // Path went right (node bit 1) after the lower bound: dropping these steps and the
+        //  last left one gives the lower bound, 0 if all prefixes are less than the prefix
+        node >>= CountTrailingOnes(node) + 1;
+        if (node == 0 || prefixes[node] != prefix) {
+            stats::RecordLookup<StringMapImplEytzinger>(stats::LookupExit::kMismatch, kLevels);
+            return kDefaultValue;
+        }
+        const std::size_t rank = kLayout.ranks[node];
+        const std::size_t end  = kLayout.group_ends[rank];
+        const std::string_view input(reinterpret_cast<const char*>(str), size);
+        const std::size_t found =
+            end - rank == 1 ? rank : SortedEntries::template bound<false>(rank, end, input);
+        if (found < end && SortedEntries::kEntries[found].key == input) {
+            stats::RecordLookup<StringMapImplEytzinger>(stats::LookupExit::kHit, kLevels);
+            return SortedEntries::kEntries[found].value;
+        }
+        stats::RecordLookup<StringMapImplEytzinger>(stats::LookupExit::kMismatch, kLevels);
+        return kDefaultValue;
+    }
+
+    template <class IsDelimiter>
+    [[nodiscard]] static constexpr MatchResult match_until_impl(
+        std::string_view buffer, IsDelimiter is_delimiter) noexcept {
+        const MatchResult result =
+            SortedEntries::template MatchUntil<kDefaultValue>(buffer, is_delimiter);
+        stats::RecordLookup<StringMapImplEytzinger>(result.value != kDefaultValue
+                                                        ? stats::LookupExit::kHit
+                                                        : stats::LookupExit::kMismatch,
+                                                    0);
+        return result;
+    }
+};
+
+template <StringMapBackend Backend, std::array MappedValues,
+          typename decltype(MappedValues)::value_type DefaultMapValue,
+          CompileTimeStringLiteral... Strings>
+STRING_MAP_CONSTEVAL auto SelectBackend() noexcept {
+    constexpr auto kParams = trie_tools::kTrieParams<Strings...>;
+    if constexpr (Backend == StringMapBackend::kAuto) {
+        constexpr bool kFewShortStrings =
+            sizeof...(Strings) <= 4 && kParams.max_tree_height <= 15;
+        return SelectBackend<kFewShortStrings ? StringMapBackend::kCompare
+                                              : StringMapBackend::kTrie,
+                             MappedValues, DefaultMapValue, Strings...>();
+    } else if constexpr (Backend == StringMapBackend::kCompare) {
+        return std::type_identity<
+            StringMapImplFewStrings<kParams, MappedValues, DefaultMapValue, Strings...>>{};
+    } else if constexpr (Backend == StringMapBackend::kTrie) {
+        return std::type_identity<
+            StringMapImplManyStrings<kParams, MappedValues, DefaultMapValue, Strings...>>{};
+    } else if constexpr (Backend == StringMapBackend::kArt) {
+        return std::type_identity<
+            StringMapImplArt<kParams, MappedValues, DefaultMapValue, Strings...>>{};
+    } else if constexpr (Backend == StringMapBackend::kDawg) {
+        return std::type_identity<
+            StringMapImplDawg<kParams, MappedValues, DefaultMapValue, Strings...>>{};
+    } else if constexpr (Backend == StringMapBackend::kPositions) {
+        return std::type_identity<
+            StringMapImplPositions<kParams, MappedValues, DefaultMapValue, Strings...>>{};
+    } else if constexpr (Backend == StringMapBackend::kPacked) {
+        return std::type_identity<
+            StringMapImplPacked<kParams, MappedValues, DefaultMapValue, Strings...>>{};
+    } else if constexpr (Backend == StringMapBackend::kFixedWork) {
+        return std::type_identity<
+            StringMapImplFixedWork<kParams, MappedValues, DefaultMapValue, Strings...>>{};
+    } else {
+        static_assert(Backend == StringMapBackend::kEytzinger, "unknown StringMapBackend");
+        return std::type_identity<
+            StringMapImplEytzinger<kParams, MappedValues, DefaultMapValue, Strings...>>{};
+    }
+}
+
+template <StringMapMergePolicy Policy, class MappedType, std::size_t N, class AllKeysList>
+class StringMapMergerImpl;
+
+template <StringMapMergePolicy Policy, class MappedType, std::size_t N,
+          CompileTimeStringLiteral... AllStrings>
+class StringMapMergerImpl<Policy, MappedType, N, KeysList<AllStrings...>> final {
+    static_assert(sizeof...(AllStrings) == N, "impl error");
+
+    static constexpr std::array<std::string_view, N> kAllStrings = {
+        std::string_view(AllStrings.value.data(), AllStrings.length)...,
+    };
+    static constexpr std::tuple<decltype(AllStrings)...> kAllStringsTuple{AllStrings...};
+
+    // kept_strings[i] is true if AllStrings...[i] is used in the merged map
+    STRING_MAP_CONSTEVAL static std::array<bool, N> KeptStrings() noexcept {
+        std::array<bool, N> kept_strings{};
+        for (std::size_t i = 0; i < N; i++) {
+            kept_strings[i] = true;
+            for (std::size_t j = 0; j < N; j++) {
+                if (i == j || kAllStrings[i] != kAllStrings[j]) {
+                    continue;
+                }
+                const bool is_overridden = Policy == StringMapMergePolicy::kLastWins ? j > i : j < i;
+                if (is_overridden) {
+                    kept_strings[i] = false;
+                }
+            }
+        }
+        return kept_strings;
+    }
+    static constexpr std::array<bool, N> kKeptStrings = KeptStrings();
+    static constexpr std::size_t kMergedSize =
+        static_cast<std::size_t>(std::count(kKeptStrings.begin(), kKeptStrings.end(), true));
+    static_assert(Policy != StringMapMergePolicy::kError || kMergedSize == N,
+                  "Same string was added to several merged StringMatch / StringMap");
+
+    STRING_MAP_CONSTEVAL static std::array<std::size_t, kMergedSize> KeptIndexes() noexcept {
+        std::array<std::size_t, kMergedSize> kept_indexes{};
+        for (std::size_t i = 0, j = 0; i < N; i++) {
+            if (kKeptStrings[i]) {
+                kept_indexes[j++] = i;
+            }
+        }
+        return kept_indexes;
+    }
+    static constexpr std::array<std::size_t, kMergedSize> kKeptIndexes = KeptIndexes();
+
+public:
+    // If RenumberValues is true, strings are mapped to their positions in the merged map
+    template <std::array AllMappedValues, MappedType DefaultMapValue, bool RenumberValues,
+              std::size_t... I>
+    static auto Merge(std::index_sequence<I...>) {
+        static_assert(AllMappedValues.size() == N, "impl error");
+        constexpr std::array<MappedType, kMergedSize> kMergedValues = [] {
+            if constexpr (RenumberValues) {
+                return std::array<MappedType, kMergedSize>{static_cast<MappedType>(I)...};
+            } else {
+                return std::array<MappedType, kMergedSize>{AllMappedValues[kKeptIndexes[I]]...};
+            }
+        }();
+        static_assert(((kMergedValues[I] != DefaultMapValue) && ...),
+                      "Value of the merged StringMap is equal to the default value, it would "
+                      "be indistinguishable from the missing string");
+        return std::type_identity<
+            typename decltype(SelectBackend<StringMapBackend::kAuto, kMergedValues,
+                                            DefaultMapValue,
+                                            std::get<kKeptIndexes[I]>(kAllStringsTuple)...>())::type>{};
+    }
+
+    static constexpr std::size_t kSize = kMergedSize;
+};
+
+template <CompileTimeStringLiteral... Strings1, CompileTimeStringLiteral... Strings2>
+auto ConcatKeysLists(KeysList<Strings1...>, KeysList<Strings2...>) -> KeysList<Strings1..., Strings2...>;
+
+template <class T, std::size_t N, std::size_t M>
+STRING_MAP_CONSTEVAL std::array<T, N + M> ConcatArrays(const std::array<T, N>& lhs,
+                                                      const std::array<T, M>& rhs) noexcept {
+    std::array<T, N + M> result{};
+    std::copy(lhs.begin(), lhs.end(), result.begin());
+    std::copy(rhs.begin(), rhs.end(), result.begin() + N);
+    return result;
+}
+
+// True if the Map maps the strings to their indexes and the rest to their number, like
+//  StringMatch does
+template <class Map>
+STRING_MAP_CONSTEVAL bool IsStringMatchLike() noexcept {
+    if constexpr (std::is_same_v<typename Map::MappedType, std::size_t>) {
+        for (std::size_t i = 0; i < Map::kMappedValues.size(); i++) {
+            if (Map::kMappedValues[i] != i) {
+                return false;
+            }
+        }
+        return Map::kDefaultValue == Map::kMappedValues.size();
+    } else {
+        return false;
+    }
+}
+
+template <StringMapMergePolicy Policy, class FirstMap, class... Maps>
+struct StringMapMerger final {
+    using MappedType = typename FirstMap::MappedType;
+    static_assert((std::is_same_v<MappedType, typename Maps::MappedType> && ...),
+                  "Merged StringMatch / StringMap should have the same mapped type");
+
+    // Indexes of the StringMatch are meaningless in the merged map, so they are
+    //  renumbered by the position of the string in the merged map
+    static constexpr bool kMergeStringMatches =
+        IsStringMatchLike<FirstMap>() && (IsStringMatchLike<Maps>() && ...);
+    static_assert(kMergeStringMatches ||
+                      ((Maps::kDefaultValue == FirstMap::kDefaultValue) && ...),
+                  "Merged StringMap should have the same default value");
+
+    static constexpr auto kAllMappedValues = [] {
+        if constexpr (sizeof...(Maps) == 0) {
+            return FirstMap::kMappedValues;
+        } else {
+            return ConcatArrays(FirstMap::kMappedValues,
+                                StringMapMerger<Policy, Maps...>::kAllMappedValues);
+        }
+    }();
+    using AllKeysType = decltype([] {
+        if constexpr (sizeof...(Maps) == 0) {
+            return typename FirstMap::KeysType{};
+        } else {
+            return ConcatKeysLists(typename FirstMap::KeysType{},
+                                   typename StringMapMerger<Policy, Maps...>::AllKeysType{});
+        }
+    }());
+
+    using MergerImpl =
+        StringMapMergerImpl<Policy, MappedType, kAllMappedValues.size(), AllKeysType>;
+    STRING_MAP_CONSTEVAL static MappedType MergedDefaultValue() noexcept {
+        if constexpr (kMergeStringMatches) {
+            return MergerImpl::kSize;
+        } else {
+            return FirstMap::kDefaultValue;
+        }
+    }
+
+    using type = typename decltype(MergerImpl::template Merge<kAllMappedValues,
+                                                              MergedDefaultValue(),
+                                                              kMergeStringMatches>(
+        std::make_index_sequence<MergerImpl::kSize>{}))::type;
+};
+
+/**
+ * Patterns with the wildcards compiled into one DFA: '?' matches one char, '*' matches
+ *  any run of chars within one segment and '**' matches any run of chars. Segments are
+ *  separated by the Separator, which is matched only by itself or by '**'.
+ *
+ * If several patterns match the string, the most specific one wins: patterns are compared
+ *  token by token and the first differing token decides, a literal char beats '?', which
+ *  beats '*', which beats '**', and the pattern which ends there beats all of them.
+ *  Patterns which are equal in this order (e.g. "a*" and "b*") are ordered as in the
+ *  Patterns... The winner is known for every DFA state at compile time, so the lookup
+ *  is one table load per char of the input whatever the number of patterns is.
+ */
+template <char Separator, std::array MappedValues,
+          typename decltype(MappedValues)::value_type DefaultMapValue,
+          CompileTimeStringLiteral... Patterns>
+class [[nodiscard]] StringGlobMapImpl final {
+    static_assert(sizeof...(Patterns) == std::size(MappedValues) && std::size(MappedValues) > 0,
+                  "internal error");
+
+public:
+    using MappedType = typename decltype(MappedValues)::value_type;
+    static_assert(std::is_copy_assignable_v<MappedType>);
+
+    static constexpr MappedType kDefaultValue = DefaultMapValue;
+    static constexpr char kSeparator          = Separator;
+    static constexpr bool kStatsEnabled       = STRING_MAP_ENABLE_STATS;
+    static constexpr auto kMappedValues       = MappedValues;
+
+    /**
+     * Lookup counters aggregated over all threads. Counters are shared by all
+     *  objects of the same map type. Always empty if STRING_MAP_ENABLE_STATS is 0.
+     */
+    [[nodiscard]] static stats::StringMapStats stats() {
+        return stats::GetLookupStats<StringGlobMapImpl>();
+    }
+    static void reset_stats() {
+        stats::ResetLookupStats<StringGlobMapImpl>();
+    }
+
+    STRING_MAP_CONSTEVAL StringGlobMapImpl() noexcept = default;
+
+    constexpr MappedType operator()(std::nullptr_t) const noexcept              = delete;
+    constexpr MappedType operator()(std::nullptr_t, std::size_t) const noexcept = delete;
+
+    // clang-format off
+    template <class CharType>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(std::basic_string_view<CharType> str) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size());
+    }
+    // clang-format off
+    template <class CharType>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(const std::basic_string<CharType>& str) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size());
+    }
+    // clang-format off
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    ATTRIBUTE_ACCESS(read_only, 2)
+    constexpr MappedType operator()(const char* str) const noexcept {
+        // clang-format on
+        if (str == nullptr) [[unlikely]] {
+            return kDefaultValue;
+        }
+        return operator()(str, std::char_traits<char>::length(str));
+    }
+    // clang-format off
+    template <class CharType>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    ATTRIBUTE_SIZED_ACCESS(read_only, 2, 3)
+    constexpr MappedType operator()(const CharType* str, std::size_t size) const noexcept {
+        // clang-format on
+        static_assert(sizeof(CharType) == sizeof(char));
+        std::size_t state = kStartState;
+        for (std::size_t i = 0; i < size; i++) {
+            state = kTransitions[state * kColumnsCount +
+                                 kColumns[static_cast<unsigned char>(str[i])]];
+            if (state == kDeadState) {
+                stats::RecordLookup<StringGlobMapImpl>(stats::LookupExit::kMismatch, i);
+                return kDefaultValue;
+            }
+        }
+        const MappedType returned_value = kStateValues[state];
+        stats::RecordLookup<StringGlobMapImpl>(returned_value != kDefaultValue
+                                                   ? stats::LookupExit::kHit
+                                                   : stats::LookupExit::kNonTerminalEnd,
+                                               size);
+        return returned_value;
+    }
+
+#if STRING_MAP_HAS_SPAN
+    // clang-format off
+    template <class CharType, std::size_t SpanExtent>
+    [[nodiscard]]
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(std::span<const CharType, SpanExtent> str) const noexcept {
+        // clang-format on
+        return operator()(str.data(), str.size());
+    }
+#endif
+
+private:
+    // In the order of the specificity, see the comment of the class
+    enum class TokenKind : std::uint8_t {
+        kEnd,
+        kLiteral,
+        kAnyChar,
+        kSegmentStar,
+        kAnyStar,
+    };
+
+    // Token of the pattern, the position of the NFA is the index of the token
+    struct Token final {
+        TokenKind kind{};
+        char chr{};
+        std::size_t pattern{};
+    };
+
+    static constexpr std::size_t kPatternsCount = sizeof...(Patterns);
+    static constexpr std::array<std::string_view, kPatternsCount> kPatterns = {
+        std::string_view(Patterns.value.data(), Patterns.length)...,
+    };
+
+    // Calls visitor(kind, chr) for every token of the pattern except the kEnd
+    template <class Visitor>
+    STRING_MAP_CONSTEVAL static void VisitTokens(std::string_view pattern, Visitor visitor) {
+        for (std::size_t i = 0; i < pattern.size(); i++) {
+            switch (pattern[i]) {
+                case '?':
+                    visitor(TokenKind::kAnyChar, '\0');
+                    break;
+                case '*': {
+                    std::size_t stars_end = i + 1;
+                    while (stars_end < pattern.size() && pattern[stars_end] == '*') {
+                        stars_end++;
+                    }
+                    visitor(stars_end - i == 1 ? TokenKind::kSegmentStar : TokenKind::kAnyStar,
+                            '\0');
+                    i = stars_end - 1;
+                    break;
+                }
+                default:
+                    visitor(TokenKind::kLiteral, pattern[i]);
+                    break;
+            }
+        }
+    }
+
+    STRING_MAP_CONSTEVAL static std::size_t TokensCount() noexcept {
+        std::size_t count = 0;
+        for (const std::string_view pattern : kPatterns) {
+            VisitTokens(pattern, [&count](TokenKind, char) constexpr noexcept { count++; });
+            count++;
+        }
+        return count;
+    }
+    static constexpr std::size_t kTokensCount = TokensCount();
+
+    STRING_MAP_CONSTEVAL static std::array<Token, kTokensCount> Tokens() noexcept {
+        std::array<Token, kTokensCount> tokens{};
+        std::size_t count = 0;
+        for (std::size_t pattern = 0; pattern < kPatternsCount; pattern++) {
+            VisitTokens(kPatterns[pattern], [&](TokenKind kind, char chr) constexpr noexcept {
+                tokens[count++] = {kind, chr, pattern};
+            });
+            tokens[count++] = {TokenKind::kEnd, '\0', pattern};
+        }
+        return tokens;
+    }
+    static constexpr std::array<Token, kTokensCount> kTokens = Tokens();
+
+    // Index of the first token of every pattern
+    STRING_MAP_CONSTEVAL static std::array<std::size_t, kPatternsCount> PatternsBegins() noexcept {
+        std::array<std::size_t, kPatternsCount> begins{};
+        for (std::size_t i = kTokensCount; i-- > 0;) {
+            begins[kTokens[i].pattern] = i;
+        }
+        return begins;
+    }
+    static constexpr std::array<std::size_t, kPatternsCount> kPatternsBegins = PatternsBegins();
+
+    // Less specific pattern gets the greater priority number
+    STRING_MAP_CONSTEVAL static bool MoreSpecific(std::size_t lhs, std::size_t rhs) noexcept {
+        for (std::size_t i = kPatternsBegins[lhs], j = kPatternsBegins[rhs];; i++, j++) {
+            if (kTokens[i].kind != kTokens[j].kind) {
+                return kTokens[i].kind < kTokens[j].kind;
+            }
+            if (kTokens[i].kind == TokenKind::kEnd) {
+                return lhs < rhs;
+            }
+        }
+    }
+    STRING_MAP_CONSTEVAL static std::array<std::size_t, kPatternsCount> Priorities() noexcept {
+        std::array<std::size_t, kPatternsCount> priorities{};
+        for (std::size_t i = 0; i < kPatternsCount; i++) {
+            for (std::size_t j = 0; j < kPatternsCount; j++) {
+                priorities[i] += j != i && MoreSpecific(j, i);
+            }
+        }
+        return priorities;
+    }
+    static constexpr std::array<std::size_t, kPatternsCount> kPriorities = Priorities();
+
+    // Every literal char and the separator get their own column, other chars share column 0
+    static constexpr std::size_t kOtherColumn = 0;
+
+    STRING_MAP_CONSTEVAL static std::array<std::size_t, 256> Columns() noexcept {
+        std::array<bool, 256> is_literal{};
+        is_literal[static_cast<unsigned char>(Separator)] = true;
+        for (const Token& token : kTokens) {
+            if (token.kind == TokenKind::kLiteral) {
+                is_literal[static_cast<unsigned char>(token.chr)] = true;
+            }
+        }
+        std::array<std::size_t, 256> columns{};
+        std::size_t columns_count = kOtherColumn + 1;
+        for (std::size_t chr = 0; chr < columns.size(); chr++) {
+            columns[chr] = is_literal[chr] ? columns_count++ : kOtherColumn;
+        }
+        return columns;
+    }
+    static constexpr std::array<std::size_t, 256> kWideColumns = Columns();
+    static constexpr std::size_t kColumnsCount =
+        *std::max_element(kWideColumns.begin(), kWideColumns.end()) + 1;
+
+    using Column = std::conditional_t<(kColumnsCount <= std::numeric_limits<std::uint8_t>::max()),
+                                      std::uint8_t, std::uint16_t>;
+
+    STRING_MAP_CONSTEVAL static std::array<Column, 256> NarrowColumns() noexcept {
+        std::array<Column, 256> columns{};
+        for (std::size_t chr = 0; chr < columns.size(); chr++) {
+            columns[chr] = static_cast<Column>(kWideColumns[chr]);
+        }
+        return columns;
+    }
+    static constexpr std::array<Column, 256> kColumns = NarrowColumns();
 
-        bool ordered = false;
-        DefaultConstructibleSentinelType max_value{};
-        DefaultConstructibleSentinelType min_value{};
-    };
+    // Some char of every column
+    STRING_MAP_CONSTEVAL static std::array<char, kColumnsCount> ColumnsChars() noexcept {
+        std::array<char, kColumnsCount> chars{};
+        for (std::size_t chr = 256; chr-- > 0;) {
+            chars[kWideColumns[chr]] = static_cast<char>(chr);
+        }
+        return chars;
+    }
+    static constexpr std::array<char, kColumnsCount> kColumnsChars = ColumnsChars();
 
-    STRING_MAP_CONSTEVAL static TMappedTypesInfo get_mapped_values_info() noexcept {
-        TMappedTypesInfo info{};
+    static constexpr std::size_t kMaxStates = 1024;
+    static constexpr std::size_t kDeadState  = 0;
+    static constexpr std::size_t kStartState = 1;
 
-        // TODO: Add support for pointers (ub gets very tricky there)
-        if constexpr (TMappedTypesInfo::kMaybeOrdered) {
-            if constexpr (std::is_floating_point_v<MappedType>) {
-                auto bad_float = [](MappedType x) constexpr noexcept -> bool {
-                    return x != x || x >= std::numeric_limits<MappedType>::infinity() ||
-                           x <= -std::numeric_limits<MappedType>::infinity() ||
-                           x == std::numeric_limits<MappedType>::quiet_NaN() ||
-                           x == std::numeric_limits<MappedType>::signaling_NaN();
-                };
-#if defined(__cpp_lib_constexpr_algorithms) && __cpp_lib_constexpr_algorithms >= 201806L && \
-    !defined(_GLIBCXX_DEBUG) && !defined(_LIBCPP_ENABLE_ASSERTIONS)
-                if (std::any_of(MappedValues.begin(), MappedValues.end(), bad_float)) {
-                    return info;
+    using TokensSet = std::array<std::uint64_t, (kTokensCount + 63) / 64>;
+
+    STRING_MAP_CONSTEVAL static bool Contains(const TokensSet& set, std::size_t token) noexcept {
+        return ((set[token / 64] >> (token % 64)) & 1) != 0;
+    }
+    STRING_MAP_CONSTEVAL static void Insert(TokensSet& set, std::size_t token) noexcept {
+        set[token / 64] |= std::uint64_t{1} << (token % 64);
+    }
+
+    // Stars may match the empty run, so the tokens after them are reachable as well
+    STRING_MAP_CONSTEVAL static TokensSet Closure(TokensSet set) noexcept {
+        for (std::size_t token = 0; token < kTokensCount; token++) {
+            if (Contains(set, token) && (kTokens[token].kind == TokenKind::kSegmentStar ||
+                                         kTokens[token].kind == TokenKind::kAnyStar)) {
+                Insert(set, token + 1);
+            }
+        }
+        return set;
+    }
+
+    STRING_MAP_CONSTEVAL static TokensSet Step(const TokensSet& set, char chr) noexcept {
+        TokensSet next{};
+        for (std::size_t token = 0; token < kTokensCount; token++) {
+            if (!Contains(set, token)) {
+                continue;
+            }
+            switch (kTokens[token].kind) {
+                case TokenKind::kLiteral:
+                    if (kTokens[token].chr == chr) {
+                        Insert(next, token + 1);
+                    }
+                    break;
+                case TokenKind::kAnyChar:
+                    if (chr != Separator) {
+                        Insert(next, token + 1);
+                    }
+                    break;
+                case TokenKind::kSegmentStar:
+                    if (chr != Separator) {
+                        Insert(next, token);
+                    }
+                    break;
+                case TokenKind::kAnyStar:
+                    Insert(next, token);
+                    break;
+                case TokenKind::kEnd:
+                default:
+                    break;
+            }
+        }
+        return Closure(next);
+    }
+
+    struct Dfa final {
+        std::array<TokensSet, kMaxStates> states{};
+        std::array<std::size_t, kMaxStates * kColumnsCount> transitions{};
+        std::size_t states_count{};
+    };
+
+    // Subset construction, states are numbered in the BFS order
+    STRING_MAP_CONSTEVAL static Dfa BuildDfa() noexcept {
+        Dfa dfa{};
+        TokensSet start{};
+        for (const std::size_t begin : kPatternsBegins) {
+            Insert(start, begin);
+        }
+        dfa.states[kStartState] = Closure(start);
+        dfa.states_count        = kStartState + 1;
+        for (std::size_t state = kStartState; state < dfa.states_count; state++) {
+            for (std::size_t column = 0; column < kColumnsCount; column++) {
+                const TokensSet next = Step(dfa.states[state], kColumnsChars[column]);
+                std::size_t next_state = 0;
+                while (next_state < dfa.states_count && dfa.states[next_state] != next) {
+                    next_state++;
                 }
-#else
-                for (const auto x : MappedValues) {
-                    if (bad_float(x)) {
-                        return info;
+                if (next_state == dfa.states_count) {
+                    if (dfa.states_count == kMaxStates) {
+                        // Reported by the static_assert below
+                        dfa.states_count = kMaxStates + 1;
+                        return dfa;
                     }
+                    dfa.states[dfa.states_count++] = next;
                 }
-#endif
+                dfa.transitions[state * kColumnsCount + column] = next_state;
             }
+        }
+        return dfa;
+    }
+    static constexpr Dfa kDfa = BuildDfa();
+    static_assert(kDfa.states_count <= kMaxStates,
+                  "Patterns of the StringGlobMap produce too many DFA states, split the map");
 
-            info.ordered = true;
-#if !defined(_GLIBCXX_DEBUG) && !defined(_LIBCPP_ENABLE_ASSERTIONS)
-            const auto [min_iter, max_iter] =
-                std::minmax_element(MappedValues.begin(), MappedValues.end());
-            info.min_value = *min_iter;
-            info.max_value = *max_iter;
-#else
-            info.min_value = MappedValues.front();
-            info.max_value = MappedValues.front();
-            for (const auto value : MappedValues) {
-                info.min_value = std::min(info.min_value, value);
-                info.max_value = std::max(info.max_value, value);
-            }
-#endif
+public:
+    // Number of the DFA states including the dead one
+    static constexpr std::size_t kStatesCount = kDfa.states_count;
+
+private:
+    using State = std::conditional_t<(kStatesCount <= std::numeric_limits<std::uint8_t>::max()),
+                                     std::uint8_t, std::uint16_t>;
+
+    STRING_MAP_CONSTEVAL static std::array<State, kStatesCount * kColumnsCount>
+    Transitions() noexcept {
+        std::array<State, kStatesCount * kColumnsCount> transitions{};
+        for (std::size_t i = 0; i < transitions.size(); i++) {
+            transitions[i] = static_cast<State>(kDfa.transitions[i]);
         }
+        return transitions;
+    }
+    static constexpr std::array<State, kStatesCount * kColumnsCount> kTransitions = Transitions();
 
-        return info;
+    STRING_MAP_CONSTEVAL static std::array<MappedType, kStatesCount> StateValues() noexcept {
+        std::array<MappedType, kStatesCount> values{};
+        for (std::size_t state = 0; state < kStatesCount; state++) {
+            std::size_t winner = kPatternsCount;
+            for (std::size_t token = 0; token < kTokensCount; token++) {
+                if (kTokens[token].kind == TokenKind::kEnd &&
+                    Contains(kDfa.states[state], token) &&
+                    (winner == kPatternsCount ||
+                     kPriorities[kTokens[token].pattern] < kPriorities[winner])) {
+                    winner = kTokens[token].pattern;
+                }
+            }
+            values[state] = winner != kPatternsCount ? MappedValues[winner] : kDefaultValue;
+        }
+        return values;
     }
+    static constexpr std::array<MappedType, kStatesCount> kStateValues = StateValues();
 
-    static constexpr TMappedTypesInfo kMappedTypesInfo = get_mapped_values_info();
+public:
+    static constexpr std::size_t kTableBytes = sizeof(kTransitions) + sizeof(kColumns) +
+                                               sizeof(kStateValues);
+
+    // Lookup length is not bounded by the patterns (*, **), so max_depth is 0
+    static constexpr StringMapFootprint kFootprint = {
+        .backend        = StringMapBackend::kAuto,
+        .strings_count  = kPatternsCount,
+        .nodes_count    = kStatesCount,
+        .alphabet_size  = kColumnsCount,
+        .bytes_per_node = kColumnsCount * sizeof(State) + sizeof(MappedType),
+        .table_bytes    = kTableBytes,
+        .max_depth      = 0,
+    };
 };
 
-template <trie_tools::TrieParamsType TrieParams, std::array MappedValues,
-          typename decltype(MappedValues)::value_type DefaultMapValue, CompileTimeStringLiteral... Strings>
-class [[nodiscard]] StringMapImplFewStrings final {
-    static_assert(0 < TrieParams.min_char && TrieParams.min_char <= TrieParams.max_char &&
-                      TrieParams.max_char <= std::numeric_limits<std::uint8_t>::max(),
-                  "Empty string was passed in StringMatch / StringMap");
-    static_assert(sizeof...(Strings) == std::size(MappedValues) && std::size(MappedValues) > 0,
+/**
+ * Keys split into the segments by the Separator ("service.region.metric", "/v1/users/list")
+ *  and stored as the tree of the segments: every node has its own compile time map from the
+ *  segments of the keys with the same leading segments to the child nodes. Lookup resolves
+ *  one segment of the input per level, so the shared segments are stored once and partial
+ *  matches (which namespace the string is in) stop at the level they need.
+ *
+ * Empty segments (leading separator, "a..b") are the edges as well, they are kept out of
+ *  the sub-maps and looked up by the node index.
+ */
+template <char Separator, std::array MappedValues,
+          typename decltype(MappedValues)::value_type DefaultMapValue,
+          CompileTimeStringLiteral... Keys>
+class [[nodiscard]] SegmentedStringMapImpl final {
+    static_assert(sizeof...(Keys) == std::size(MappedValues) && std::size(MappedValues) > 0,
                   "internal error");
 
 public:
@@ -719,35 +5102,47 @@ public:
     static_assert(std::is_copy_assignable_v<MappedType>);
 
     static constexpr MappedType kDefaultValue = DefaultMapValue;
-    static constexpr char kMinChar            = static_cast<char>(TrieParams.min_char);
-    static constexpr char kMaxChar            = static_cast<char>(TrieParams.max_char);
+    static constexpr char kSeparator          = Separator;
+    static constexpr bool kStatsEnabled       = STRING_MAP_ENABLE_STATS;
+    static constexpr auto kMappedValues       = MappedValues;
+    using KeysType                            = KeysList<Keys...>;
 
-    STRING_MAP_CONSTEVAL StringMapImplFewStrings() noexcept = default;
+    /**
+     * Lookup counters aggregated over all threads. Counters are shared by all
+     *  objects of the same map type. Always empty if STRING_MAP_ENABLE_STATS is 0.
+     *  Depth of the lookup is the number of the resolved segments.
+     */
+    [[nodiscard]] static stats::StringMapStats stats() {
+        return stats::GetLookupStats<SegmentedStringMapImpl>();
+    }
+    static void reset_stats() {
+        stats::ResetLookupStats<SegmentedStringMapImpl>();
+    }
+
+    STRING_MAP_CONSTEVAL SegmentedStringMapImpl() noexcept = default;
 
     constexpr MappedType operator()(std::nullptr_t) const noexcept              = delete;
     constexpr MappedType operator()(std::nullptr_t, std::size_t) const noexcept = delete;
 
     // clang-format off
-    template <class CharType>
     [[nodiscard]]
-    ATTRIBUTE_PURE
+    ATTRIBUTE_LOOKUP_PURE
     ATTRIBUTE_ALWAYS_INLINE
-    constexpr MappedType operator()(std::basic_string_view<CharType> str) const noexcept {
+    constexpr MappedType operator()(std::string_view str) const noexcept {
         // clang-format on
         return operator()(str.data(), str.size());
     }
     // clang-format off
-    template <class CharType>
     [[nodiscard]]
-    ATTRIBUTE_PURE
-    ATTRIBUTE_ALWAYS_INLINE    
-    constexpr MappedType operator()(const std::basic_string<CharType>& str) const noexcept {
+    ATTRIBUTE_LOOKUP_PURE
+    ATTRIBUTE_ALWAYS_INLINE
+    constexpr MappedType operator()(const std::string& str) const noexcept {
         // clang-format on
         return operator()(str.data(), str.size());
     }
     // clang-format off
     [[nodiscard]]
-    ATTRIBUTE_PURE
+    ATTRIBUTE_LOOKUP_PURE
     ATTRIBUTE_ALWAYS_INLINE
     ATTRIBUTE_ACCESS(read_only, 2)
     constexpr MappedType operator()(const char* str) const noexcept {
@@ -758,45 +5153,303 @@ public:
         return operator()(str, std::char_traits<char>::length(str));
     }
     // clang-format off
-    template <class CharType>
     [[nodiscard]]
-    ATTRIBUTE_PURE
-    ATTRIBUTE_ALWAYS_INLINE
+    ATTRIBUTE_LOOKUP_PURE
     ATTRIBUTE_SIZED_ACCESS(read_only, 2, 3)
-    constexpr MappedType operator()(const CharType* str, std::size_t size) const noexcept {
+    constexpr MappedType operator()(const char* str, std::size_t size) const noexcept {
         // clang-format on
-        return operator_call_impl<CharType, 0, Strings...>(str, size);
+        const Walk walk = Descend<false>(str, size);
+        const MappedType returned_value =
+            walk.complete ? kNodeValues[walk.node] : kDefaultValue;
+        stats::RecordLookup<SegmentedStringMapImpl>(
+            !walk.complete                     ? stats::LookupExit::kMissingEdge
+            : returned_value != kDefaultValue ? stats::LookupExit::kHit
+                                               : stats::LookupExit::kNonTerminalEnd,
+            walk.segments);
+        return returned_value;
     }
 
-#if STRING_MAP_HAS_SPAN
-    // clang-format off
-    template <class CharType, std::size_t SpanExtent>
-    [[nodiscard]]
-    ATTRIBUTE_PURE
-    ATTRIBUTE_ALWAYS_INLINE
-    constexpr MappedType operator()(std::span<const CharType, SpanExtent> str) const noexcept {
-        // clang-format on
-        return operator()(str.data(), str.size());
+    using MatchResult = StringMapMatchResult<MappedType>;
+
+    /**
+     * Longest key which is equal to the first segments of the str: its value and the
+     *  position where it ends in the str (the separator or the end of the str).
+     * Default value and position 0 if no key is a prefix of the str in this sense, e.g.
+     *  with the keys "api" and "api.v1.users" the str "api.v2.users" gives {value of "api", 3}.
+     */
+    [[nodiscard]] static constexpr MatchResult longest_prefix(std::string_view str) noexcept {
+        const Walk walk = Descend<true>(str.data(), str.size());
+        return {
+            .value    = kNodeValues[walk.prefix_node],
+            .position = walk.prefix_end,
+        };
+    }
+
+    /**
+     * Number of the leading segments of the str which are the leading segments of some
+     *  key, e.g. 1 if only the top level namespace of the str is known to the map.
+     */
+    [[nodiscard]] static constexpr std::size_t matched_segments(std::string_view str) noexcept {
+        return Descend<false>(str.data(), str.size()).segments;
     }
-#endif
 
 private:
-    // clang-format off
-    template <class CharType, std::size_t Index, CompileTimeStringLiteral CompString, CompileTimeStringLiteral... CompStrings>
-    [[nodiscard]]
-    ATTRIBUTE_PURE
-    ATTRIBUTE_ALWAYS_INLINE
-    ATTRIBUTE_SIZED_ACCESS(read_only, 1, 2)
-    static constexpr MappedType operator_call_impl(const CharType* str, std::size_t size) noexcept {
-        // clang-format on
-        if (CompString == std::basic_string_view<CharType>(str, size)) {
-            static_assert(Index < std::size(MappedValues));
-            return MappedValues[Index];
+    static constexpr std::size_t kKeysCount = sizeof...(Keys);
+    static constexpr std::array<std::string_view, kKeysCount> kKeys = {
+        std::string_view(Keys.value.data(), Keys.length)...,
+    };
+
+    // Upper bound of the number of the tree nodes: root and one node per segment of every key
+    STRING_MAP_CONSTEVAL static std::size_t MaxNodesCount() noexcept {
+        std::size_t count = 1;
+        for (const std::string_view key : kKeys) {
+            count += static_cast<std::size_t>(std::count(key.begin(), key.end(), Separator)) + 1;
         }
-        if constexpr (sizeof...(CompStrings) >= 1) {
-            return operator_call_impl<CharType, Index + 1, CompStrings...>(str, size);
+        return count;
+    }
+    static constexpr std::size_t kMaxNodesCount = MaxNodesCount();
+
+    // Max number of the segments in one key, i.e. max number of the sub-map lookups
+    STRING_MAP_CONSTEVAL static std::size_t MaxSegmentsCount() noexcept {
+        std::size_t max_count = 0;
+        for (const std::string_view key : kKeys) {
+            max_count = std::max(
+                max_count,
+                static_cast<std::size_t>(std::count(key.begin(), key.end(), Separator)) + 1);
+        }
+        return max_count;
+    }
+
+    struct Tree final {
+        // Nodes are numbered in the BFS order, so the children of every node are
+        //  contiguous: [first_child, first_child + children_count), empty segment goes last
+        std::array<std::string_view, kMaxNodesCount> segments{};
+        std::array<std::size_t, kMaxNodesCount> first_child{};
+        std::array<std::size_t, kMaxNodesCount> children_count{};
+        std::array<bool, kMaxNodesCount> has_empty_child{};
+        // Index of the key which ends at the node, kKeysCount if none
+        std::array<std::size_t, kMaxNodesCount> key_index{};
+        std::size_t nodes_count{};
+        bool has_duplicates{};
+    };
+
+    STRING_MAP_CONSTEVAL static Tree BuildTree() noexcept {
+        // Tree in the order of the insertion first
+        std::array<std::string_view, kMaxNodesCount> segments{};
+        std::array<std::size_t, kMaxNodesCount> parents{};
+        std::array<std::size_t, kMaxNodesCount> key_indexes{};
+        key_indexes.fill(kKeysCount);
+        std::size_t nodes_count = 1;
+        bool has_duplicates     = false;
+        for (std::size_t key = 0; key < kKeysCount; key++) {
+            std::size_t node = 0;
+            for (std::size_t begin = 0;;) {
+                const std::size_t end     = std::min(kKeys[key].find(Separator, begin),
+                                                     kKeys[key].size());
+                const std::string_view segment = kKeys[key].substr(begin, end - begin);
+                std::size_t child = 1;
+                while (child < nodes_count &&
+                       (parents[child] != node || segments[child] != segment)) {
+                    child++;
+                }
+                if (child == nodes_count) {
+                    segments[child] = segment;
+                    parents[child]  = node;
+                    nodes_count++;
+                }
+                node = child;
+                if (end == kKeys[key].size()) {
+                    break;
+                }
+                begin = end + 1;
+            }
+            has_duplicates |= key_indexes[node] != kKeysCount;
+            key_indexes[node] = key;
+        }
+
+        // Renumbering in the BFS order
+        Tree tree{};
+        std::array<std::size_t, kMaxNodesCount> order{};
+        std::size_t ordered = 1;
+        for (std::size_t i = 0; i < ordered; i++) {
+            const std::size_t old_node = order[i];
+            tree.first_child[i]        = ordered;
+            for (const bool empty_segment : {false, true}) {
+                for (std::size_t child = 1; child < nodes_count; child++) {
+                    if (parents[child] == old_node && segments[child].empty() == empty_segment) {
+                        tree.segments[ordered] = segments[child];
+                        order[ordered++]       = child;
+                        tree.has_empty_child[i] |= empty_segment;
+                    }
+                }
+            }
+            tree.children_count[i] = ordered - tree.first_child[i];
+            tree.key_index[i]      = key_indexes[old_node];
+        }
+        tree.nodes_count    = nodes_count;
+        tree.has_duplicates = has_duplicates;
+        return tree;
+    }
+    static constexpr Tree kTree = BuildTree();
+    static_assert(!kTree.has_duplicates, "Same key was passed to the SegmentedStringMap twice");
+
+public:
+    static constexpr std::size_t kNodesCount = kTree.nodes_count;
+
+private:
+    using NodeIndex = std::conditional_t<(kNodesCount < std::numeric_limits<std::uint16_t>::max()),
+                                         std::uint16_t, std::uint32_t>;
+    static constexpr NodeIndex kNoNode = std::numeric_limits<NodeIndex>::max();
+
+    // Sub-map of the node: non-empty segments of its children to the child indexes
+    template <std::size_t Node, std::size_t... I>
+    STRING_MAP_CONSTEVAL static auto SelectChildrenMap(std::index_sequence<I...>) noexcept {
+        constexpr std::size_t kFirstChild = kTree.first_child[Node];
+        constexpr std::array<NodeIndex, sizeof...(I)> kChildren = {
+            static_cast<NodeIndex>(kFirstChild + I)...,
+        };
+        return SelectBackend<StringMapBackend::kAuto, kChildren, kNoNode,
+                             CompileTimeStringLiteral(kTree.segments[kFirstChild + I])...>();
+    }
+
+    template <std::size_t Node>
+    static constexpr std::size_t kNonEmptyChildrenCount =
+        kTree.children_count[Node] - static_cast<std::size_t>(kTree.has_empty_child[Node]);
+
+    template <std::size_t Node>
+    using ChildrenMap = typename decltype(SelectChildrenMap<Node>(
+        std::make_index_sequence<kNonEmptyChildrenCount<Node>>{}))::type;
+
+    using ChildMatch = StringMapMatchResult<NodeIndex>;
+
+    // Child of the node and the length of the segment at the start of the rest in one pass
+    template <std::size_t Node>
+    [[nodiscard]] ATTRIBUTE_ALWAYS_INLINE static constexpr ChildMatch MatchChild(
+        std::string_view rest) noexcept {
+        if constexpr (kNonEmptyChildrenCount<Node> == 0) {
+            return {kNoNode, 0};
+        } else {
+            return ChildrenMap<Node>{}.template match_until<Separator>(rest);
+        }
+    }
+
+    // Switch over the node index, so every sub-map is inlined into the walk
+    template <std::size_t... Nodes>
+    [[nodiscard]] ATTRIBUTE_LOOKUP_PURE static constexpr ChildMatch MatchChild(
+        std::size_t node, std::string_view rest, std::index_sequence<Nodes...>) noexcept {
+        ChildMatch match{kNoNode, 0};
+        static_cast<void>(((node == Nodes && (match = MatchChild<Nodes>(rest), true)) || ...));
+        return match;
+    }
+
+    STRING_MAP_CONSTEVAL static std::array<NodeIndex, kNodesCount> EmptyChildren() noexcept {
+        std::array<NodeIndex, kNodesCount> children{};
+        for (std::size_t node = 0; node < kNodesCount; node++) {
+            children[node] = kTree.has_empty_child[node]
+                                 ? static_cast<NodeIndex>(kTree.first_child[node] +
+                                                          kTree.children_count[node] - 1)
+                                 : kNoNode;
+        }
+        return children;
+    }
+    static constexpr std::array<NodeIndex, kNodesCount> kEmptyChildren = EmptyChildren();
+
+    STRING_MAP_CONSTEVAL static std::array<MappedType, kNodesCount> NodeValues() noexcept {
+        std::array<MappedType, kNodesCount> values{};
+        for (std::size_t node = 0; node < kNodesCount; node++) {
+            values[node] = kTree.key_index[node] != kKeysCount
+                               ? MappedValues[kTree.key_index[node]]
+                               : kDefaultValue;
+        }
+        return values;
+    }
+    static constexpr std::array<MappedType, kNodesCount> kNodeValues = NodeValues();
+
+    STRING_MAP_CONSTEVAL static std::array<bool, kNodesCount> NodeIsKey() noexcept {
+        std::array<bool, kNodesCount> is_key{};
+        for (std::size_t node = 0; node < kNodesCount; node++) {
+            is_key[node] = kTree.key_index[node] != kKeysCount;
+        }
+        return is_key;
+    }
+    static constexpr std::array<bool, kNodesCount> kNodeIsKey = NodeIsKey();
+
+    template <std::size_t... Nodes>
+    STRING_MAP_CONSTEVAL static std::size_t ChildrenMapsBytes(
+        std::index_sequence<Nodes...>) noexcept {
+        const auto node_bytes = []<std::size_t Node>() constexpr noexcept -> std::size_t {
+            if constexpr (kNonEmptyChildrenCount<Node> == 0) {
+                return 0;
+            } else {
+                return ChildrenMap<Node>::kFootprint.table_bytes;
+            }
+        };
+        return (node_bytes.template operator()<Nodes>() + ...);
+    }
+
+public:
+    // Tables of all sub-maps and of the tree itself
+    static constexpr std::size_t kTableBytes =
+        ChildrenMapsBytes(std::make_index_sequence<kNodesCount>{}) + sizeof(kEmptyChildren) +
+        sizeof(kNodeValues) + sizeof(kNodeIsKey);
+
+    // Steps are the segments, bytes per node do not include the sub-maps
+    static constexpr StringMapFootprint kFootprint = {
+        .backend        = StringMapBackend::kAuto,
+        .strings_count  = kKeysCount,
+        .nodes_count    = kNodesCount,
+        .alphabet_size  = 0,
+        .bytes_per_node = sizeof(NodeIndex) + sizeof(MappedType) + sizeof(bool),
+        .table_bytes    = kTableBytes,
+        .max_depth      = MaxSegmentsCount(),
+    };
+
+private:
+    struct Walk final {
+        // Node of the last resolved segment
+        std::size_t node;
+        std::size_t segments;
+        // All segments of the input were resolved
+        bool complete;
+        // Deepest visited node which is a key (root, which is never a key, if none)
+        std::size_t prefix_node;
+        std::size_t prefix_end;
+    };
+
+    template <bool TrackPrefix>
+    [[nodiscard]] ATTRIBUTE_LOOKUP_PURE static constexpr Walk Descend(const char* str,
+                                                                      std::size_t size) noexcept {
+        Walk walk{};
+        for (std::size_t begin = 0;;) {
+            const std::string_view rest(str + begin, size - begin);
+            NodeIndex child = kNoNode;
+            std::size_t end = begin;
+            if (rest.empty() || rest.front() == Separator) {
+                child = kEmptyChildren[walk.node];
+            } else {
+                // Sub-map stops at the separator, so the segment is scanned once
+                const ChildMatch match =
+                    MatchChild(walk.node, rest, std::make_index_sequence<kNodesCount>{});
+                child = match.value;
+                end += match.position;
+            }
+            if (child == kNoNode) {
+                return walk;
+            }
+            walk.node = child;
+            walk.segments++;
+            if constexpr (TrackPrefix) {
+                if (kNodeIsKey[child]) {
+                    walk.prefix_node = child;
+                    walk.prefix_end  = end;
+                }
+            }
+            if (end == size) {
+                walk.complete = true;
+                return walk;
+            }
+            begin = end + 1;
         }
-        return kDefaultValue;
     }
 };
 
@@ -816,11 +5469,52 @@ STRING_MAP_CONSTEVAL std::array<std::size_t, N> make_index_array() noexcept {
     return index_array;
 }
 
+template <class Result, class HandlersTuple, bool HasDefaultHandler, class Strings>
+struct StringSwitchImpl;
+
+template <class Result, class HandlersTuple, bool HasDefaultHandler,
+          CompileTimeStringLiteral... Strings>
+struct StringSwitchImpl<Result, HandlersTuple, HasDefaultHandler, KeysList<Strings...>> final {
+    using MatchType = typename decltype(string_map_impl::SelectBackend<
+                                        StringMapBackend::kAuto,
+                                        make_index_array<sizeof...(Strings)>(),
+                                        sizeof...(Strings), Strings...>())::type;
+
+    static constexpr MatchType kMatch{};
+    static_assert(kMatch.kDefaultValue == sizeof...(Strings), "impl error");
+
+    /**
+     * Invokes the handler with the index returned by the kMatch, the default one goes last.
+     *  Chain of the compares with the constants compiles to the switch over the index,
+     *  so the handlers are inlined at the call site (no table of the function pointers).
+     */
+    template <std::size_t Index = 0>
+    ATTRIBUTE_ALWAYS_INLINE static constexpr Result Dispatch(
+        [[maybe_unused]] std::size_t index, [[maybe_unused]] HandlersTuple& handlers) {
+        if constexpr (Index == sizeof...(Strings)) {
+            if constexpr (HasDefaultHandler) {
+                return static_cast<Result>(std::invoke(std::get<Index>(handlers)));
+            } else if constexpr (!std::is_void_v<Result>) {
+                return Result{};
+            }
+        } else {
+            if (index == Index) {
+                return static_cast<Result>(std::invoke(std::get<Index>(handlers)));
+            }
+            return Dispatch<Index + 1>(index, handlers);
+        }
+    }
+};
+
 }  // namespace string_map_detail
 
 #undef STRING_MAP_CONSTEVAL
 #undef STRING_MAP_HAS_BIT
+#undef STRING_MAP_HAS_SSE2
+#undef STRING_MAP_HAS_BMI2
+#undef STRING_MAP_HAS_CPU_DISPATCH
 #undef STRING_MAP_HAS_SPAN
+#undef ATTRIBUTE_LOOKUP_PURE
 #undef ATTRIBUTE_SIZED_ACCESS
 #undef ATTRIBUTE_ACCESS
 #undef ATTRIBUTE_ALWAYS_INLINE
@@ -833,18 +5527,184 @@ STRING_MAP_CONSTEVAL std::array<std::size_t, N> make_index_array() noexcept {
 #undef CONFIG_HAS_INCLUDE
 #undef CONFIG_HAS_AT_LEAST_CXX_23
 
+using StringMapBackend = string_map_detail::StringMapBackend;
+
+template <StringMapBackend Backend, std::array MappedValues,
+          typename decltype(MappedValues)::value_type DefaultMapValue,
+          string_map_detail::CompileTimeStringLiteral... Strings>
+    requires(sizeof...(Strings) == std::size(MappedValues) && std::size(MappedValues) > 0)
+using StringMapWithBackend =
+    typename decltype(string_map_detail::string_map_impl::SelectBackend<
+                      Backend, MappedValues, DefaultMapValue, Strings...>())::type;
+
 template <std::array MappedValues, typename decltype(MappedValues)::value_type DefaultMapValue,
           string_map_detail::CompileTimeStringLiteral... Strings>
     requires(sizeof...(Strings) == std::size(MappedValues) && std::size(MappedValues) > 0)
 using StringMap =
-    std::conditional_t<(sizeof...(Strings) <= 4 && string_map_detail::trie_tools::kTrieParams<Strings...>.max_tree_height <= 15),
-                       typename string_map_detail::string_map_impl::StringMapImplFewStrings<
-                           string_map_detail::trie_tools::kTrieParams<Strings...>, MappedValues,
-                           DefaultMapValue, Strings...>,
-                       typename string_map_detail::string_map_impl::StringMapImplManyStrings<
-                           string_map_detail::trie_tools::kTrieParams<Strings...>, MappedValues,
-                           DefaultMapValue, Strings...>>;
+    StringMapWithBackend<StringMapBackend::kAuto, MappedValues, DefaultMapValue, Strings...>;
+
+using StringMapStats = string_map_detail::stats::StringMapStats;
+
+using StringMapFootprint = string_map_detail::StringMapFootprint;
+
+using StringMapCpuFeatures = string_map_detail::cpu::CpuFeatures;
+
+/**
+ * Extensions of the host detected on the first use (or enabled at compile time) which
+ *  the lookups use, e.g. pext of StringMapBackend::kPositions.
+ */
+[[nodiscard]] inline const StringMapCpuFeatures& StringMapHostCpuFeatures() noexcept {
+    return string_map_detail::cpu::GetCpuFeatures();
+}
+
+template <class MappedType>
+using StringMapEntry = string_map_detail::StringMapEntry<MappedType>;
+
+template <class MappedType>
+using StringMapMatchResult = string_map_detail::StringMapMatchResult<MappedType>;
+
+/**
+ * MapType itself if its tables (MapType::kFootprint.table_bytes) fit in
+ *  BytesBudget bytes (e.g. L1d size), compile time error otherwise.
+ */
+template <std::size_t BytesBudget, class MapType>
+using StringMapWithinBudget = typename string_map_detail::BudgetCheckedMap<BytesBudget, MapType>::type;
+
+/**
+ * Adds kFootprint of the map type to the list reported by the tests/footprint_report
+ *  (and by ForEachRegisteredStringMapFootprint), e.g. next to the map definition:
+ *
+ *  using Keywords = StringMatch<"if", "else", "while">;
+ *  STRING_MAP_REGISTER_FOOTPRINT("keywords", Keywords);
+ *
+ * Should be used at the namespace scope. Map type goes last, so it may contain commas.
+ */
+#if defined(__COUNTER__)
+// Unique within the translation unit, unlike the __LINE__ of the different headers
+#define STRING_MAP_REGISTER_FOOTPRINT(name, ...) \
+    STRING_MAP_REGISTER_FOOTPRINT_WITH_ID(__COUNTER__, name, __VA_ARGS__)
+#else
+#define STRING_MAP_REGISTER_FOOTPRINT(name, ...) \
+    STRING_MAP_REGISTER_FOOTPRINT_WITH_ID(__LINE__, name, __VA_ARGS__)
+#endif
+#define STRING_MAP_REGISTER_FOOTPRINT_WITH_ID(id, name, ...) \
+    STRING_MAP_REGISTER_FOOTPRINT_IMPL(id, name, __VA_ARGS__)
+#define STRING_MAP_REGISTER_FOOTPRINT_IMPL(id, name, ...)              \
+    [[maybe_unused]] static ::string_map_detail::FootprintRegistrar \
+        string_map_footprint_registrar_##id(name, __VA_ARGS__::kFootprint)
+
+// Calls callback(name, footprint) for every map registered by STRING_MAP_REGISTER_FOOTPRINT
+template <class Callback>
+void ForEachRegisteredStringMapFootprint(Callback&& callback) {
+    string_map_detail::FootprintRegistrar::ForEach(std::forward<Callback>(callback));
+}
+
+template <std::size_t Padding>
+using PaddedInput = string_map_detail::PaddedInput<Padding>;
+
+using StringMapMergePolicy = string_map_detail::StringMapMergePolicy;
+
+/**
+ * Single StringMap with strings and values of all Maps. Strings which were
+ *  added to several maps are resolved according to the Policy.
+ * All Maps should have the same MappedType and the same default value, which no value
+ *  of the merged map may be equal to. If all Maps are StringMatch, the merged one is
+ *  the StringMatch over the merged strings: strings are mapped to their positions in it.
+ */
+template <StringMapMergePolicy Policy, class... Maps>
+    requires(sizeof...(Maps) > 0)
+using MergedStringMap =
+    typename string_map_detail::string_map_impl::StringMapMerger<Policy, Maps...>::type;
+
+/**
+ * Map from the patterns with the wildcards ('?', '*' within one segment, '**' any run)
+ *  to the values, see string_map_impl::StringGlobMapImpl for the precedence rules.
+ * Lookup is one pass over the string with the DFA built at compile time.
+ */
+template <char Separator, std::array MappedValues,
+          typename decltype(MappedValues)::value_type DefaultMapValue,
+          string_map_detail::CompileTimeStringLiteral... Patterns>
+    requires(sizeof...(Patterns) == std::size(MappedValues) && std::size(MappedValues) > 0)
+using StringGlobMapWithSeparator =
+    string_map_detail::string_map_impl::StringGlobMapImpl<Separator, MappedValues,
+                                                          DefaultMapValue, Patterns...>;
+
+template <std::array MappedValues, typename decltype(MappedValues)::value_type DefaultMapValue,
+          string_map_detail::CompileTimeStringLiteral... Patterns>
+    requires(sizeof...(Patterns) == std::size(MappedValues) && std::size(MappedValues) > 0)
+using StringGlobMap =
+    StringGlobMapWithSeparator<'/', MappedValues, DefaultMapValue, Patterns...>;
+
+template <char Separator, string_map_detail::CompileTimeStringLiteral... Patterns>
+using StringGlobMatchWithSeparator =
+    StringGlobMapWithSeparator<Separator,
+                               string_map_detail::make_index_array<sizeof...(Patterns)>(),
+                               sizeof...(Patterns), Patterns...>;
+
+template <string_map_detail::CompileTimeStringLiteral... Patterns>
+using StringGlobMatch = StringGlobMatchWithSeparator<'/', Patterns...>;
+
+/**
+ * Map from the keys made of the segments separated by the Separator ("service.region.metric",
+ *  "/v1/users/list") to the values. Every level of the segments tree has its own compile time
+ *  map, see string_map_impl::SegmentedStringMapImpl.
+ */
+template <char Separator, std::array MappedValues,
+          typename decltype(MappedValues)::value_type DefaultMapValue,
+          string_map_detail::CompileTimeStringLiteral... Keys>
+    requires(sizeof...(Keys) == std::size(MappedValues) && std::size(MappedValues) > 0)
+using SegmentedStringMapWithSeparator =
+    string_map_detail::string_map_impl::SegmentedStringMapImpl<Separator, MappedValues,
+                                                               DefaultMapValue, Keys...>;
+
+template <std::array MappedValues, typename decltype(MappedValues)::value_type DefaultMapValue,
+          string_map_detail::CompileTimeStringLiteral... Keys>
+    requires(sizeof...(Keys) == std::size(MappedValues) && std::size(MappedValues) > 0)
+using SegmentedStringMap =
+    SegmentedStringMapWithSeparator<'.', MappedValues, DefaultMapValue, Keys...>;
+
+template <char Separator, string_map_detail::CompileTimeStringLiteral... Keys>
+using SegmentedStringMatchWithSeparator =
+    SegmentedStringMapWithSeparator<Separator,
+                                    string_map_detail::make_index_array<sizeof...(Keys)>(),
+                                    sizeof...(Keys), Keys...>;
+
+template <string_map_detail::CompileTimeStringLiteral... Keys>
+using SegmentedStringMatch = SegmentedStringMatchWithSeparator<'.', Keys...>;
 
 template <string_map_detail::CompileTimeStringLiteral... Strings>
 using StringMatch = StringMap<string_map_detail::make_index_array<sizeof...(Strings)>(),
                               sizeof...(Strings), Strings...>;
+
+template <StringMapBackend Backend, string_map_detail::CompileTimeStringLiteral... Strings>
+using StringMatchWithBackend =
+    StringMapWithBackend<Backend, string_map_detail::make_index_array<sizeof...(Strings)>(),
+                         sizeof...(Strings), Strings...>;
+
+/**
+ * Fused lookup and dispatch: invokes handlers...[i] if str is equal to Strings...[i].
+ * If one more handler than strings is passed, it is invoked for the string not
+ *  in the Strings..., otherwise value initialized result is returned.
+ * Lookup yields the index of the handler and the dispatch is the switch over it,
+ *  so the handlers may be inlined like the cases of the hand written switch.
+ *
+ *  const int code = StringSwitch<"GET", "PUT">(
+ *      method, [&] { return HandleGet(request); }, [&] { return HandlePut(request); },
+ *      [] { return 405; });
+ */
+template <string_map_detail::CompileTimeStringLiteral... Strings, class StringType,
+          class... Handlers>
+    requires(sizeof...(Strings) > 0 && (sizeof...(Handlers) == sizeof...(Strings) ||
+                                        sizeof...(Handlers) == sizeof...(Strings) + 1))
+constexpr decltype(auto) StringSwitch(const StringType& str, Handlers&&... handlers) {
+    using Result        = std::common_type_t<std::invoke_result_t<Handlers&>...>;
+    using HandlersTuple = std::tuple<Handlers&...>;
+
+    using SwitchImpl =
+        string_map_detail::StringSwitchImpl<Result, HandlersTuple,
+                                            sizeof...(Handlers) != sizeof...(Strings),
+                                            string_map_detail::KeysList<Strings...>>;
+
+    HandlersTuple handlers_tuple{handlers...};
+    return SwitchImpl::Dispatch(SwitchImpl::kMatch(str), handlers_tuple);
+}
@@ -0,0 +1,412 @@
+/**
+ * End-to-end benchmark: memory-mapped log file is split into lines and fields, one field
+ *  of every line is classified with the compile-time StringMatch and the counts per key
+ *  are aggregated.
+ *
+ * Usage:
+ *   log_classifier generate <path> <megabytes>
+ *   log_classifier classify <path> [threads] [backend] [field] [delimiter]
+ *   log_classifier selftest <path>
+ *
+ * generate writes the deterministic log with lines like
+ *   2024-05-17T12:34:56.789Z host-07 INFO http.server request 12 ms
+ *  classify counts the log levels in the field 2 (0-based, ' ' delimited by default) with the
+ *  backend (trie by default) and prints the counts and the GB/s. File is split into chunks
+ *  which the threads take one by one, every thread counts into its own array and the arrays
+ *  are merged at the end. selftest generates a small file and checks that every backend and
+ *  number of threads give the counts written by the generator.
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#error "Platform is not supported"
+#endif
+
+#include "StringMap.hpp"
+
+namespace {
+
+inline constexpr std::string_view kLevels[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL"};
+// Index of the lines whose field is not a level (or which have no such field)
+inline constexpr std::size_t kUnknown    = std::size(kLevels);
+inline constexpr std::size_t kLevelField = 2;
+
+template <StringMapBackend Backend>
+using LevelMatch = StringMatchWithBackend<Backend, kLevels[0], kLevels[1], kLevels[2],
+                                          kLevels[3], kLevels[4], kLevels[5]>;
+
+using Counts = std::array<std::uint64_t, kUnknown + 1>;
+
+// Bytes of the file taken by the thread at once, the lines are assigned to the chunk
+//  where they start
+inline constexpr std::size_t kChunkSize = std::size_t{1} << 22;
+
+struct ClassifyOptions final {
+    std::size_t threads_count = std::max(1u, std::thread::hardware_concurrency());
+    std::size_t field         = kLevelField;
+    char delimiter            = ' ';
+};
+
+/**
+ * Counts of the lines starting in [chunk_begin, chunk_end) of the text.
+ */
+template <class Map>
+void ClassifyChunk(const Map& map, std::string_view text, std::size_t chunk_begin,
+                   std::size_t chunk_end, const ClassifyOptions& options, Counts& counts) noexcept {
+    const char* const text_end = text.data() + text.size();
+    const char* line           = text.data() + chunk_begin;
+    if (chunk_begin != 0 && line[-1] != '\n') {
+        // Line which starts in the previous chunk belongs to it
+        const void* const newline =
+            std::memchr(line, '\n', static_cast<std::size_t>(text_end - line));
+        line = newline != nullptr ? static_cast<const char*>(newline) + 1 : text_end;
+    }
+
+    const char* const last_line_begin = text.data() + chunk_end;
+    while (line < last_line_begin) {
+        const void* const newline =
+            std::memchr(line, '\n', static_cast<std::size_t>(text_end - line));
+        const char* const line_end =
+            newline != nullptr ? static_cast<const char*>(newline) : text_end;
+
+        const char* field = line;
+        std::size_t index = 0;
+        for (; index < options.field && field != nullptr; index++) {
+            const void* const delimiter =
+                std::memchr(field, options.delimiter, static_cast<std::size_t>(line_end - field));
+            field = delimiter != nullptr ? static_cast<const char*>(delimiter) + 1 : nullptr;
+        }
+        std::size_t key = kUnknown;
+        if (field != nullptr) {
+            const void* const delimiter =
+                std::memchr(field, options.delimiter, static_cast<std::size_t>(line_end - field));
+            const char* const field_end =
+                delimiter != nullptr ? static_cast<const char*>(delimiter) : line_end;
+            key = map(field, static_cast<std::size_t>(field_end - field));
+        }
+        counts[key]++;
+
+        if (newline == nullptr) {
+            break;
+        }
+        line = line_end + 1;
+    }
+}
+
+template <class Map>
+Counts Classify(const Map& map, std::string_view text, const ClassifyOptions& options) {
+    const std::size_t chunks_count = (text.size() + kChunkSize - 1) / kChunkSize;
+    const std::size_t threads_count =
+        std::max(std::size_t{1}, std::min(options.threads_count, chunks_count));
+
+    std::vector<Counts> thread_counts(threads_count, Counts{});
+    std::atomic<std::size_t> next_chunk{0};
+    const auto run_thread = [&](const std::size_t thread_index) noexcept {
+        Counts counts{};
+        for (std::size_t chunk = next_chunk.fetch_add(1, std::memory_order_relaxed);
+             chunk < chunks_count; chunk = next_chunk.fetch_add(1, std::memory_order_relaxed)) {
+            const std::size_t chunk_begin = chunk * kChunkSize;
+            ClassifyChunk(map, text, chunk_begin, std::min(chunk_begin + kChunkSize, text.size()),
+                          options, counts);
+        }
+        thread_counts[thread_index] = counts;
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(threads_count - 1);
+    for (std::size_t i = 1; i < threads_count; i++) {
+        threads.emplace_back(run_thread, i);
+    }
+    run_thread(0);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    Counts total{};
+    for (const Counts& counts : thread_counts) {
+        for (std::size_t i = 0; i < total.size(); i++) {
+            total[i] += counts[i];
+        }
+    }
+    return total;
+}
+
+inline constexpr std::string_view kBackendNames[] = {
+    "compare", "trie", "art", "dawg", "positions", "packed", "fixed", "eytzinger",
+};
+
+// Calls Classify with the map of the backend with the name backend_name
+bool ClassifyWithBackend(std::string_view backend_name, std::string_view text,
+                         const ClassifyOptions& options, Counts& counts) {
+    const auto run = [&]<StringMapBackend Backend>() {
+        static constexpr LevelMatch<Backend> kMatch{};
+        counts = Classify(kMatch, text, options);
+        return true;
+    };
+    if (backend_name == "compare") {
+        return run.template operator()<StringMapBackend::kCompare>();
+    } else if (backend_name == "trie") {
+        return run.template operator()<StringMapBackend::kTrie>();
+    } else if (backend_name == "art") {
+        return run.template operator()<StringMapBackend::kArt>();
+    } else if (backend_name == "dawg") {
+        return run.template operator()<StringMapBackend::kDawg>();
+    } else if (backend_name == "positions") {
+        return run.template operator()<StringMapBackend::kPositions>();
+    } else if (backend_name == "packed") {
+        return run.template operator()<StringMapBackend::kPacked>();
+    } else if (backend_name == "fixed") {
+        return run.template operator()<StringMapBackend::kFixedWork>();
+    } else if (backend_name == "eytzinger") {
+        return run.template operator()<StringMapBackend::kEytzinger>();
+    }
+    return false;
+}
+
+/**
+ * Read-only private mapping of the whole file, empty for the empty file.
+ */
+class MappedFile final {
+public:
+    explicit MappedFile(const char* path) noexcept {
+        const int fd = ::open(path, O_RDONLY);
+        if (fd == -1) {
+            return;
+        }
+        struct stat file_stat {};
+        if (::fstat(fd, &file_stat) == 0) {
+            size_ = static_cast<std::size_t>(file_stat.st_size);
+            if (size_ == 0) {
+                is_open_ = true;
+            } else if (void* const data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                       data != MAP_FAILED) {
+                data_    = data;
+                is_open_ = true;
+#if defined(POSIX_MADV_SEQUENTIAL)
+                ::posix_madvise(data_, size_, POSIX_MADV_SEQUENTIAL);
+#endif
+            }
+        }
+        ::close(fd);
+    }
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() {
+        if (data_ != nullptr) {
+            ::munmap(data_, size_);
+        }
+    }
+
+    [[nodiscard]] bool is_open() const noexcept {
+        return is_open_;
+    }
+    [[nodiscard]] std::string_view text() const noexcept {
+        return data_ != nullptr ? std::string_view(static_cast<const char*>(data_), size_)
+                                : std::string_view{};
+    }
+
+private:
+    void* data_       = nullptr;
+    std::size_t size_ = 0;
+    bool is_open_     = false;
+};
+
+// Writes about megabytes MiB of the log and returns the expected counts of the level field
+bool GenerateLog(const char* path, std::size_t megabytes, Counts& counts) {
+    constexpr std::string_view kHosts[]      = {"host-01", "host-02", "host-07", "db-primary"};
+    constexpr std::string_view kComponents[] = {"http.server", "db.pool", "cache", "auth"};
+    constexpr std::string_view kMessages[]   = {
+        "request handled in",  "connection acquired after", "miss, loaded in",
+        "token refreshed in", "slow query took",           "retrying after",
+    };
+    // Not the levels: wrong case, prefixes, syslog names
+    constexpr std::string_view kNoise[] = {"info", "WARNING", "ERR", "NOTICE", "-", "INFO:"};
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+    counts = Counts{};
+    std::mt19937 rnd(2024);
+    const std::size_t target_size = megabytes << 20;
+    std::size_t size              = 0;
+    std::string line;
+    while (size < target_size) {
+        std::string_view level;
+        std::size_t key;
+        // Mostly INFO and DEBUG like the real logs
+        if (const auto dice = rnd() % 100; dice < 3) {
+            level = kNoise[rnd() % std::size(kNoise)];
+            key   = kUnknown;
+        } else {
+            key   = dice < 50   ? 2
+                    : dice < 80 ? 1
+                    : dice < 88 ? 0
+                    : dice < 95 ? 3
+                    : dice < 99 ? 4
+                                : 5;
+            level = kLevels[key];
+        }
+
+        char timestamp[32];
+        std::snprintf(timestamp, sizeof(timestamp), "2024-05-17T%02u:%02u:%02u.%03uZ",
+                      static_cast<unsigned>(rnd() % 24), static_cast<unsigned>(rnd() % 60),
+                      static_cast<unsigned>(rnd() % 60), static_cast<unsigned>(rnd() % 1000));
+        line.assign(timestamp);
+        line += ' ';
+        line += kHosts[rnd() % std::size(kHosts)];
+        line += ' ';
+        line += level;
+        line += ' ';
+        line += kComponents[rnd() % std::size(kComponents)];
+        line += ' ';
+        line += kMessages[rnd() % std::size(kMessages)];
+        line += ' ';
+        line += std::to_string(rnd() % 5000);
+        line += " ms\n";
+        out << line;
+        size += line.size();
+        counts[key]++;
+    }
+    return static_cast<bool>(out.flush());
+}
+
+void PrintCounts(const Counts& counts) {
+    for (std::size_t i = 0; i < std::size(kLevels); i++) {
+        std::printf("%-8.*s %12" PRIu64 "\n", static_cast<int>(kLevels[i].size()),
+                    kLevels[i].data(), counts[i]);
+    }
+    std::printf("%-8s %12" PRIu64 "\n", "unknown", counts[kUnknown]);
+}
+
+int RunClassify(int argc, char* argv[]) {
+    if (argc < 3) {
+        return EXIT_FAILURE;
+    }
+    ClassifyOptions options;
+    std::string_view backend_name = "trie";
+    if (argc > 3) {
+        options.threads_count =
+            std::max(std::size_t{1}, std::size_t{std::strtoull(argv[3], nullptr, 10)});
+    }
+    if (argc > 4) {
+        backend_name = argv[4];
+    }
+    if (argc > 5) {
+        options.field = std::size_t{std::strtoull(argv[5], nullptr, 10)};
+    }
+    if (argc > 6 && argv[6][0] != '\0') {
+        options.delimiter = argv[6][0];
+    }
+
+    const MappedFile file(argv[2]);
+    if (!file.is_open()) {
+        std::fprintf(stderr, "Could not map the file %s\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+
+    Counts counts{};
+    const auto start = std::chrono::steady_clock::now();
+    if (!ClassifyWithBackend(backend_name, file.text(), options, counts)) {
+        std::fprintf(stderr, "Unknown backend %s\n", argv[4]);
+        return EXIT_FAILURE;
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    const auto nanoseconds = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+    PrintCounts(counts);
+    std::printf("%-9.*s threads: %3zu | %8.2f MiB | %7.3f GB/s\n",
+                static_cast<int>(backend_name.size()), backend_name.data(), options.threads_count,
+                static_cast<double>(file.text().size()) / (1 << 20),
+                static_cast<double>(file.text().size()) / nanoseconds);
+    return EXIT_SUCCESS;
+}
+
+int RunSelfTest(const char* path) {
+    Counts expected{};
+    // Several chunks, so the lines crossing the chunk boundaries are checked
+    if (!GenerateLog(path, 3 * kChunkSize >> 20, expected)) {
+        std::fprintf(stderr, "Could not write the file %s\n", path);
+        return EXIT_FAILURE;
+    }
+    const MappedFile file(path);
+    if (!file.is_open()) {
+        std::fprintf(stderr, "Could not map the file %s\n", path);
+        return EXIT_FAILURE;
+    }
+
+    bool ok = true;
+    for (const std::string_view backend_name : kBackendNames) {
+        for (const std::size_t threads_count : {std::size_t{1}, std::size_t{4}}) {
+            Counts counts{};
+            ClassifyWithBackend(backend_name, file.text(),
+                                ClassifyOptions{.threads_count = threads_count}, counts);
+            if (counts != expected) {
+                std::fprintf(stderr, "Wrong counts of %.*s with %zu threads\n",
+                             static_cast<int>(backend_name.size()), backend_name.data(),
+                             threads_count);
+                ok = false;
+            }
+        }
+    }
+
+    // Last line without the trailing newline, lines without the level field
+    constexpr std::string_view kText = "a b WARN\nc d\n\na b ERROR";
+    Counts counts{};
+    ClassifyChunk(LevelMatch<StringMapBackend::kTrie>{}, kText, 0, kText.size(), ClassifyOptions{},
+                  counts);
+    if (counts != Counts{0, 0, 0, 1, 1, 0, 2}) {
+        std::fprintf(stderr, "Wrong counts of the lines without the level field\n");
+        ok = false;
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const std::string_view mode = argc > 1 ? argv[1] : "";
+    if (mode == "generate" && argc > 3) {
+        Counts counts{};
+        if (!GenerateLog(argv[2], std::size_t{std::strtoull(argv[3], nullptr, 10)}, counts)) {
+            std::fprintf(stderr, "Could not write the file %s\n", argv[2]);
+            return EXIT_FAILURE;
+        }
+        PrintCounts(counts);
+        return EXIT_SUCCESS;
+    }
+    if (mode == "classify" && argc > 2) {
+        return RunClassify(argc, argv);
+    }
+    if (mode == "selftest" && argc > 2) {
+        return RunSelfTest(argv[2]);
+    }
+    std::fprintf(stderr,
+                 "Usage:\n"
+                 "  %s generate <path> <megabytes>\n"
+                 "  %s classify <path> [threads] [backend] [field] [delimiter]\n"
+                 "  %s selftest <path>\n",
+                 argv[0], argv[0], argv[0]);
+    return EXIT_FAILURE;
+}
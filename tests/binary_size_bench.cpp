@@ -0,0 +1,80 @@
+/**
+ * Binary size check: the same trie map is used by the functions of two translation
+ *  units (see binary_size_bench_units.cpp).
+ *
+ * Usage: binary_size_bench [path to this executable]
+ *
+ * Map objects are empty handles and the trie is the static data member of the map type,
+ *  so the executable has one copy of the table instead of one per function. Prints the
+ *  size of the table, the size of the handle and, on Linux, the sizes of the .rodata and
+ *  .text sections of the executable read from its ELF header.
+ */
+
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <elf.h>
+#endif
+
+#include "binary_size_bench.hpp"
+
+std::size_t ParseHeaderInFirstUnit(std::string_view header) noexcept {
+    static constexpr auto kHeaders = HttpHeadersMatch();
+    return kHeaders(header);
+}
+
+namespace {
+
+#if defined(__linux__)
+void PrintSectionSizes(const char* path) {
+    std::ifstream file(path, std::ios::binary);
+    const std::vector<char> bytes((std::istreambuf_iterator<char>(file)),
+                                  std::istreambuf_iterator<char>());
+    if (bytes.size() < sizeof(Elf64_Ehdr) || std::memcmp(bytes.data(), ELFMAG, SELFMAG) != 0 ||
+        bytes[EI_CLASS] != ELFCLASS64) {
+        std::printf("can't read 64-bit ELF file %s\n", path);
+        return;
+    }
+    Elf64_Ehdr header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    const auto section_at = [&bytes, &header](std::size_t index) {
+        Elf64_Shdr section;
+        std::memcpy(&section, bytes.data() + header.e_shoff + index * header.e_shentsize,
+                    sizeof(section));
+        return section;
+    };
+    const Elf64_Shdr names_section = section_at(header.e_shstrndx);
+    for (std::size_t i = 0; i < header.e_shnum; i++) {
+        const Elf64_Shdr section = section_at(i);
+        const std::string name(bytes.data() + names_section.sh_offset + section.sh_name);
+        if (name == ".rodata" || name == ".text") {
+            std::printf("%-8s %10" PRIu64 " bytes\n", name.c_str(),
+                        static_cast<std::uint64_t>(section.sh_size));
+        }
+    }
+}
+#endif
+
+}  // namespace
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[]) {
+    constexpr std::string_view kHeader = "X-Forwarded-For";
+    const std::size_t first            = ParseHeaderInFirstUnit(kHeader);
+    if (first != ParseHeaderInSecondUnit(kHeader) || first != ParseHeaderInThirdUnit(kHeader)) {
+        std::printf("lookups in the translation units disagree\n");
+        return 1;
+    }
+
+    std::printf("table    %10zu bytes (used by 3 functions in 2 translation units)\n",
+                HttpHeadersMatch::kFootprint.table_bytes);
+    std::printf("handle   %10zu bytes\n", sizeof(HttpHeadersMatch));
+#if defined(__linux__)
+    PrintSectionSizes(argc > 1 ? argv[1] : "/proc/self/exe");
+#endif
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+#include "../StringMap.hpp"
+
+// clang-format off
+// Same key set used by several functions in several translation units
+using HttpHeadersMatch = StringMatch<
+    "Accept", "Accept-Charset", "Accept-Encoding", "Accept-Language", "Authorization",
+    "Cache-Control", "Connection", "Content-Encoding", "Content-Length", "Content-Type",
+    "Cookie", "Date", "ETag", "Expect", "Host", "If-Match", "If-Modified-Since",
+    "If-None-Match", "Origin", "Pragma", "Range", "Referer", "Transfer-Encoding",
+    "Upgrade", "User-Agent", "Via", "X-Forwarded-For", "X-Request-Id">;
+// clang-format on
+
+std::size_t ParseHeaderInFirstUnit(std::string_view header) noexcept;
+std::size_t ParseHeaderInSecondUnit(std::string_view header) noexcept;
+std::size_t ParseHeaderInThirdUnit(std::string_view header) noexcept;
@@ -0,0 +1,13 @@
+// Each function keeps its own `static constexpr` map object like in the README examples
+
+#include "binary_size_bench.hpp"
+
+std::size_t ParseHeaderInSecondUnit(std::string_view header) noexcept {
+    static constexpr auto kHeaders = HttpHeadersMatch();
+    return kHeaders(header);
+}
+
+std::size_t ParseHeaderInThirdUnit(std::string_view header) noexcept {
+    static constexpr auto kHeaders = HttpHeadersMatch();
+    return kHeaders(header);
+}
@@ -0,0 +1,121 @@
+/**
+ * Dictionary encoding benchmark: Arrow-style string columns of the growing size are
+ *  encoded by the pools of 1...N threads.
+ *
+ * Usage: column_encode_bench [max_threads] [max_rows]
+ *
+ * Prints rows per second and rows per second per thread for every column size, so the
+ *  drop of the per core throughput shows where the column stops fitting in the caches
+ *  or the chunks become too few to keep all threads busy.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "../StringColumnEncoder.hpp"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define NOOPT(x) asm("" ::"r,i"(x))
+#else
+#error "Compiler is not supported"
+#endif
+
+namespace {
+
+// clang-format off
+inline constexpr std::string_view kCurrencies[] = {
+    "USD", "EUR", "JPY", "GBP", "CHF", "CNY", "AUD", "CAD", "HKD", "SGD", "SEK", "KRW",
+    "NOK", "NZD", "INR", "MXN",
+};
+// clang-format on
+
+inline constexpr std::string_view kMisses[] = {"", "US", "usd", "EURO", "XXX", "N/A"};
+
+template <StringMapBackend Backend>
+using CurrencyMatch = StringMatchWithBackend<
+    Backend, kCurrencies[0], kCurrencies[1], kCurrencies[2], kCurrencies[3], kCurrencies[4],
+    kCurrencies[5], kCurrencies[6], kCurrencies[7], kCurrencies[8], kCurrencies[9],
+    kCurrencies[10], kCurrencies[11], kCurrencies[12], kCurrencies[13], kCurrencies[14],
+    kCurrencies[15]>;
+
+inline constexpr auto kTrieMatch      = CurrencyMatch<StringMapBackend::kTrie>();
+inline constexpr auto kPositionsMatch = CurrencyMatch<StringMapBackend::kPositions>();
+inline constexpr auto kPackedMatch    = CurrencyMatch<StringMapBackend::kPacked>();
+
+struct Column final {
+    std::vector<std::int32_t> offsets{0};
+    std::string data;
+};
+
+Column MakeColumn(std::size_t rows) {
+    std::mt19937 rnd(42);
+    Column column;
+    column.offsets.reserve(rows + 1);
+    column.data.reserve(rows * 3);
+    for (std::size_t i = 0; i < rows; i++) {
+        // 15/16 hits and 1/16 misses
+        column.data += rnd() % 16 != 0 ? kCurrencies[rnd() % std::size(kCurrencies)]
+                                       : kMisses[rnd() % std::size(kMisses)];
+        column.offsets.push_back(static_cast<std::int32_t>(column.data.size()));
+    }
+    return column;
+}
+
+template <class MapType>
+void RunBackend(const char* backend_name, const MapType& map, std::size_t max_threads,
+                std::size_t max_rows) {
+    for (std::size_t threads_count = 1; threads_count <= max_threads; threads_count *= 2) {
+        DictionaryEncoderPool pool(threads_count);
+        for (std::size_t rows = 1 << 12; rows <= max_rows; rows *= 4) {
+            const Column column = MakeColumn(rows);
+            const StringColumnView<std::int32_t> view{.offsets = column.offsets,
+                                                      .data    = column.data};
+            std::vector<std::uint8_t> codes(rows);
+            // At least ~16M rows in total, so the small columns are not dominated by the timer
+            const std::size_t repeats = std::max(std::size_t{1}, (std::size_t{1} << 24) / rows);
+
+            const auto start = std::chrono::steady_clock::now();
+            for (std::size_t i = 0; i < repeats; i++) {
+                const bool encoded = pool.encode(map, view, std::span(codes));
+                NOOPT(encoded);
+            }
+            const auto end = std::chrono::steady_clock::now();
+            NOOPT(codes[rows / 2]);
+
+            const auto nanoseconds = static_cast<double>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+            const double rows_per_second =
+                static_cast<double>(rows) * static_cast<double>(repeats) * 1e9 / nanoseconds;
+            std::printf("%-9s threads: %3zu | rows: %9zu | %9.2f Mrows/s | %8.2f Mrows/s per "
+                        "thread\n",
+                        backend_name, threads_count, rows, rows_per_second / 1e6,
+                        rows_per_second / 1e6 / static_cast<double>(threads_count));
+        }
+    }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    std::size_t max_rows    = std::size_t{1} << 24;
+    if (argc > 1) {
+        max_threads = std::max(std::size_t{1}, std::size_t{std::strtoull(argv[1], nullptr, 10)});
+    }
+    if (argc > 2) {
+        max_rows = std::max(std::size_t{1}, std::size_t{std::strtoull(argv[2], nullptr, 10)});
+    }
+
+    RunBackend("trie", kTrieMatch, max_threads, max_rows);
+    RunBackend("positions", kPositionsMatch, max_threads, max_rows);
+    RunBackend("packed", kPackedMatch, max_threads, max_rows);
+}
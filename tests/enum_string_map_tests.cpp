@@ -0,0 +1,82 @@
+#include <cassert>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#include "../EnumStringMap.hpp"
+
+namespace {
+
+enum class Color {
+    kRed,
+    kGreen,
+    kBlue,
+    kLightGoldenrodYellow,
+};
+
+enum class HttpStatus : std::uint16_t {
+    kOk                  = 200,
+    kNotFound            = 404,
+    kInternalServerError = 500,
+};
+
+enum Unscoped : std::int8_t {
+    MINUS_ONE    = -1,
+    ZERO         = 0,
+    HTTPServer   = 3,
+    ALIAS_OF_ONE = 3,
+};
+
+}  // namespace
+
+int main() {
+    {
+        using ColorNames = EnumStringMap<Color>;
+        static_assert(ColorNames::kCount == 4);
+        static_assert(ColorNames::kIsContiguous);
+        static_assert(ColorNames::kNames[0] == "kRed");
+        static_assert(ColorNames::name(Color::kBlue) == "kBlue");
+        static_assert(ColorNames::name(static_cast<Color>(4)).empty());
+        static_assert(ColorNames::parse("kGreen") == Color::kGreen);
+        static_assert(ColorNames::parse("green") == std::nullopt);
+
+        using SnakeNames = EnumStringMap<Color, EnumNameCase::kSnake, "k">;
+        static_assert(SnakeNames::name(Color::kLightGoldenrodYellow) == "light_goldenrod_yellow");
+        static_assert(SnakeNames::parse("red") == Color::kRed);
+        static_assert(SnakeNames::parse("kRed") == std::nullopt);
+
+        using KebabNames = EnumStringMap<Color, EnumNameCase::kKebab, "k">;
+        static_assert(KebabNames::name(Color::kLightGoldenrodYellow) == "light-goldenrod-yellow");
+        using UpperNames = EnumStringMap<Color, EnumNameCase::kUpperSnake, "k">;
+        static_assert(UpperNames::name(Color::kGreen) == "GREEN");
+        static_assert(UpperNames::parse("LIGHT_GOLDENROD_YELLOW") == Color::kLightGoldenrodYellow);
+        using LowerNames = EnumStringMap<Color, EnumNameCase::kLower, "k">;
+        static_assert(LowerNames::name(Color::kLightGoldenrodYellow) == "lightgoldenrodyellow");
+
+        for (std::size_t i = 0; i < SnakeNames::kCount; i++) {
+            const Color color = SnakeNames::kValues[i];
+            assert(SnakeNames::parse(SnakeNames::name(color)) == color);
+        }
+    }
+    {
+        // Sparse values out of the default range
+        using StatusNames = EnumStringMap<HttpStatus, EnumNameCase::kSnake, "k", 0, 600>;
+        static_assert(StatusNames::kCount == 3);
+        static_assert(!StatusNames::kIsContiguous);
+        static_assert(StatusNames::name(HttpStatus::kNotFound) == "not_found");
+        static_assert(StatusNames::name(static_cast<HttpStatus>(403)).empty());
+        static_assert(StatusNames::name(static_cast<HttpStatus>(600)).empty());
+        static_assert(StatusNames::parse("internal_server_error") == HttpStatus::kInternalServerError);
+        assert(StatusNames::parse(std::string_view("ok")) == HttpStatus::kOk);
+        assert(StatusNames::parse("") == std::nullopt);
+    }
+    {
+        // Negative values, aliases, acronyms
+        using UnscopedNames = EnumStringMap<Unscoped, EnumNameCase::kSnake, "", -8, 8>;
+        static_assert(UnscopedNames::kCount == 3);
+        static_assert(UnscopedNames::kValues[0] == MINUS_ONE);
+        static_assert(UnscopedNames::name(MINUS_ONE) == "minus_one");
+        static_assert(UnscopedNames::name(ALIAS_OF_ONE) == "http_server");
+        static_assert(UnscopedNames::parse("zero") == ZERO);
+    }
+}
@@ -0,0 +1,114 @@
+/**
+ * Prints the compile time footprint (StringMapFootprint) of the maps.
+ *
+ * Usage: footprint_report [l1d_bytes]
+ *
+ * Reports every map registered with STRING_MAP_REGISTER_FOOTPRINT in the translation units
+ *  linked into the tool: the sample maps below and the maps of the headers and sources
+ *  added to the footprint_report target. Maps whose tables do not fit in l1d_bytes
+ *  (32 KiB by default) are marked, use StringMapWithinBudget to turn such mark into
+ *  the compile time error.
+ */
+
+#include <cinttypes>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+
+#include "../StringMap.hpp"
+
+namespace {
+
+// clang-format off
+inline constexpr std::string_view kHttpKeywords[] = {
+    "GET", "HEAD", "POST", "PUT", "DELETE", "CONNECT", "OPTIONS", "TRACE", "PATCH",
+    "Host", "Accept", "Accept-Encoding", "Connection", "Content-Length", "Content-Type",
+    "User-Agent",
+};
+// clang-format on
+
+template <StringMapBackend Backend>
+using HttpKeywordsMatch = StringMatchWithBackend<
+    Backend, kHttpKeywords[0], kHttpKeywords[1], kHttpKeywords[2], kHttpKeywords[3],
+    kHttpKeywords[4], kHttpKeywords[5], kHttpKeywords[6], kHttpKeywords[7], kHttpKeywords[8],
+    kHttpKeywords[9], kHttpKeywords[10], kHttpKeywords[11], kHttpKeywords[12],
+    kHttpKeywords[13], kHttpKeywords[14], kHttpKeywords[15]>;
+
+using BoolMatch         = StringMatch<"true", "false", "on", "off", "yes", "no">;
+using LogLevelMatch     = StringMatch<"trace", "debug", "info", "warn", "error", "fatal">;
+using WideAlphabetMatch = StringMatch<" ", "~", "!important", "Z-index", "z-index">;
+using MetricsGlobMatch  = StringGlobMatchWithSeparator<'.', "cpu.*", "mem.**", "*.errors">;
+using MetricsTreeMatch  = SegmentedStringMatch<"cpu.user", "cpu.system", "mem.used", "mem.swap.in">;
+
+STRING_MAP_REGISTER_FOOTPRINT("http_keywords (compare)",
+                              HttpKeywordsMatch<StringMapBackend::kCompare>);
+STRING_MAP_REGISTER_FOOTPRINT("http_keywords (trie)", HttpKeywordsMatch<StringMapBackend::kTrie>);
+STRING_MAP_REGISTER_FOOTPRINT("http_keywords (art)", HttpKeywordsMatch<StringMapBackend::kArt>);
+STRING_MAP_REGISTER_FOOTPRINT("http_keywords (dawg)", HttpKeywordsMatch<StringMapBackend::kDawg>);
+STRING_MAP_REGISTER_FOOTPRINT("http_keywords (positions)",
+                              HttpKeywordsMatch<StringMapBackend::kPositions>);
+STRING_MAP_REGISTER_FOOTPRINT("http_keywords (packed)",
+                              HttpKeywordsMatch<StringMapBackend::kPacked>);
+STRING_MAP_REGISTER_FOOTPRINT("http_keywords (fixed)",
+                              HttpKeywordsMatch<StringMapBackend::kFixedWork>);
+STRING_MAP_REGISTER_FOOTPRINT("http_keywords (eytzinger)",
+                              HttpKeywordsMatch<StringMapBackend::kEytzinger>);
+STRING_MAP_REGISTER_FOOTPRINT("bool", BoolMatch);
+STRING_MAP_REGISTER_FOOTPRINT("log_level", LogLevelMatch);
+STRING_MAP_REGISTER_FOOTPRINT("wide_alphabet", WideAlphabetMatch);
+STRING_MAP_REGISTER_FOOTPRINT("wide_alphabet (art)",
+                              StringMatchWithBackend<StringMapBackend::kArt, " ", "~",
+                                                     "!important", "Z-index", "z-index">);
+STRING_MAP_REGISTER_FOOTPRINT("metrics (glob)", MetricsGlobMatch);
+STRING_MAP_REGISTER_FOOTPRINT("metrics (segmented)", MetricsTreeMatch);
+
+constexpr const char* BackendName(StringMapBackend backend) noexcept {
+    switch (backend) {
+        case StringMapBackend::kCompare:
+            return "compare";
+        case StringMapBackend::kTrie:
+            return "trie";
+        case StringMapBackend::kArt:
+            return "art";
+        case StringMapBackend::kDawg:
+            return "dawg";
+        case StringMapBackend::kPositions:
+            return "positions";
+        case StringMapBackend::kPacked:
+            return "packed";
+        case StringMapBackend::kFixedWork:
+            return "fixed";
+        case StringMapBackend::kEytzinger:
+            return "eytzinger";
+        case StringMapBackend::kAuto:
+            // StringGlobMap and SegmentedStringMap are not built by a backend
+            return "other";
+    }
+    return "?";
+}
+
+void PrintFootprint(std::string_view name, const StringMapFootprint& footprint,
+                    std::size_t l1d_bytes) {
+    std::printf("%-28.*s %-9s %8zu %8zu %9zu %10zu %12zu %6zu %s\n",
+                static_cast<int>(name.size()), name.data(), BackendName(footprint.backend),
+                footprint.strings_count, footprint.nodes_count, footprint.alphabet_size,
+                footprint.bytes_per_node, footprint.table_bytes, footprint.max_depth,
+                footprint.table_bytes > l1d_bytes ? "exceeds L1d" : "");
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::size_t l1d_bytes = 32 * 1024;
+    if (argc > 1) {
+        l1d_bytes = std::size_t{std::strtoull(argv[1], nullptr, 10)};
+    }
+
+    std::printf("%-28s %-9s %8s %8s %9s %10s %12s %6s\n", "map", "backend", "strings", "nodes",
+                "alphabet", "node_bytes", "table_bytes", "depth");
+    ForEachRegisteredStringMapFootprint(
+        [l1d_bytes](std::string_view name, const StringMapFootprint& footprint) {
+            PrintFootprint(name, footprint, l1d_bytes);
+        });
+}
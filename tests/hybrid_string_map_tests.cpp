@@ -0,0 +1,123 @@
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../HybridStringMap.hpp"
+
+int main() {
+    {
+        enum class Command {
+            kGet,
+            kSet,
+            kDelete,
+            kList,
+            kNone,
+        };
+        using enum Command;
+        using StaticCommands = StringMap<std::array{kGet, kSet, kDelete}, kNone, "get", "set", "delete">;
+
+        HybridStringMap<StaticCommands> map;
+        assert(map("get") == kGet);
+        assert(map("del") == kNone);
+        assert(map.overlay_size() == 0);
+
+        // Strings from the static map can't be overridden
+        assert(!map.insert_or_assign("get", kList));
+        assert(map("get") == kGet);
+
+        assert(map.insert_or_assign("del", kDelete));
+        assert(map.insert_or_assign("ls", kList));
+        assert(map.insert_or_assign("fetch", kGet));
+        assert(map.overlay_size() == 3);
+        assert(map("del") == kDelete);
+        assert(map("ls") == kList);
+        assert(map("fetch") == kGet);
+        assert(map("delete") == kDelete);
+        assert(map("l") == kNone);
+        assert(map(static_cast<const char*>(nullptr)) == kNone);
+
+        assert(map.insert_or_assign("fetch", kSet));
+        assert(map("fetch") == kSet);
+        assert(map.overlay_size() == 3);
+
+        assert(map.erase("ls"));
+        assert(!map.erase("ls"));
+        assert(!map.erase("get"));
+        assert(map("ls") == kNone);
+        assert(map.overlay_size() == 2);
+
+        // Without the concurrent readers every update frees the snapshots before the previous one
+        assert(map.retired_snapshots_count() == 1);
+        assert(map.reclaim_retired_snapshots() == 1);
+        assert(map.reclaim_retired_snapshots() == 0);
+
+        const std::vector<std::pair<std::string, Command>> aliases = {
+            {"ls", kList}, {"rm", kDelete}, {"get", kList}, {"put", kSet}};
+        assert(map.insert_or_assign_range(aliases) == 3);
+        assert(map.retired_snapshots_count() == 1);
+        assert(map.overlay_size() == 5);
+        assert(map("ls") == kList);
+        assert(map("rm") == kDelete);
+        assert(map("put") == kSet);
+        assert(map("get") == kGet);
+
+        const std::string_view erased[] = {"rm", "put", "get", "unknown"};
+        assert(map.erase_range(erased) == 2);
+        assert(map.retired_snapshots_count() == 1);
+        assert(map.overlay_size() == 3);
+        assert(map("rm") == kNone);
+        assert(map("put") == kNone);
+        assert(map("ls") == kList);
+        assert(map.erase_range(erased) == 0);
+        assert(map.retired_snapshots_count() == 1);
+
+        map.clear();
+        assert(map.overlay_size() == 0);
+        assert(map("del") == kNone);
+        assert(map("set") == kSet);
+    }
+    {
+        // Readers run concurrently with the writer
+        using StaticMatch = StringMatch<"alpha", "beta", "gamma">;
+        HybridStringMap<StaticMatch> map;
+        constexpr std::size_t kAliases = 200;
+        std::vector<std::string> aliases;
+        for (std::size_t i = 0; i < kAliases; i++) {
+            aliases.push_back("alias_" + std::to_string(i));
+        }
+
+        std::atomic<bool> writer_done{false};
+        std::vector<std::thread> readers;
+        for (std::size_t thread_index = 0; thread_index < 3; thread_index++) {
+            readers.emplace_back([&map, &aliases, &writer_done]() {
+                while (!writer_done.load(std::memory_order_acquire)) {
+                    assert(map("beta") == 1);
+                    for (const std::string& alias : aliases) {
+                        const auto value = map(alias);
+                        // Either not published yet or published with the final value
+                        assert(value == map.kDefaultValue || value == 1);
+                    }
+                }
+            });
+        }
+        for (const std::string& alias : aliases) {
+            map.insert_or_assign(alias, 1);
+        }
+        writer_done.store(true, std::memory_order_release);
+        for (std::thread& reader : readers) {
+            reader.join();
+        }
+        map.reclaim_retired_snapshots();
+        assert(map.retired_snapshots_count() == 0);
+
+        for (const std::string& alias : aliases) {
+            assert(map(alias) == 1);
+        }
+        assert(map.overlay_size() == kAliases);
+    }
+}
@@ -0,0 +1,133 @@
+#include <cassert>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "../JsonObjectDecoder.hpp"
+
+namespace {
+
+struct Event final {
+    std::string name;
+    std::uint64_t user_id{};
+    double latency{};
+    bool cached{};
+    std::optional<std::int32_t> status;
+};
+
+using EventFields =
+    StructFieldMap<Event, StructField<"name", &Event::name>,
+                   StructField<"user_id", &Event::user_id>,
+                   StructField<"latency", &Event::latency>, StructField<"cached", &Event::cached>,
+                   StructField<"status", &Event::status>>;
+
+}  // namespace
+
+int main() {
+    {
+        static_assert(EventFields::kFieldsCount == 5);
+        static_assert(EventFields::index_of("latency") == 2);
+        static_assert(EventFields::index_of("latenc") == EventFields::kNotFound);
+        static_assert(EventFields::kNames[1] == "user_id");
+
+        Event event;
+        assert(EventFields::visit(event, "user_id", [](auto& field) {
+            if constexpr (std::is_same_v<std::remove_cvref_t<decltype(field)>, std::uint64_t>) {
+                field = 42;
+            }
+        }));
+        assert(event.user_id == 42);
+        assert(!EventFields::visit(event, "unknown", [](auto&) { return true; }));
+    }
+    {
+        constexpr std::string_view kJson = R"({
+            "name": "checkout",
+            "ignored": {"nested": [1, 2.5e3, "x", {"a": null}], "flag": true},
+            "user_id": 18446744073709551615,
+            "latency": -12.5e-1,
+            "cached": true,
+            "status": 404,
+            "tags": []
+        } trailing)";
+        Event event;
+        const JsonDecodeResult result = DecodeJsonObject<EventFields>(kJson, event);
+        assert(result.ok());
+        assert(kJson.substr(result.position) == " trailing");
+        assert(event.name == "checkout");
+        assert(event.user_id == 18446744073709551615ULL);
+        assert(event.latency == -1.25);
+        assert(event.cached);
+        assert(event.status == 404);
+
+        // Absent fields are left untouched, null resets the optional, last duplicate wins
+        assert(DecodeJsonObject<EventFields>(R"({"status":null,"cached":false,"cached":true})",
+                                             event)
+                   .ok());
+        assert(!event.status.has_value());
+        assert(event.cached);
+        assert(event.name == "checkout");
+
+        assert(DecodeJsonObject<EventFields>("{}", event).ok());
+        assert(DecodeJsonObject<EventFields>(" \n{ }", event).ok());
+    }
+    {
+        // Escapes in the keys and values
+        Event event;
+        const JsonDecodeResult result = DecodeJsonObject<EventFields>(
+            R"({"name": "a\"b\\c\né😀", "user_id": 7})", event);
+        assert(result.ok());
+        assert(event.name == "a\"b\\c\n\xC3\xA9\xF0\x9F\x98\x80");
+        assert(event.user_id == 7);
+    }
+    {
+        Event event;
+        const auto error = [&event](std::string_view json) {
+            return DecodeJsonObject<EventFields>(json, event).error;
+        };
+        assert(error("") == JsonDecodeError::kUnexpectedEnd);
+        assert(error("[]") == JsonDecodeError::kUnexpectedChar);
+        assert(error(R"({"name" "x"})") == JsonDecodeError::kUnexpectedChar);
+        assert(error(R"({"name": "x")") == JsonDecodeError::kUnexpectedEnd);
+        assert(error(R"({"name": "x",})") == JsonDecodeError::kUnexpectedChar);
+        assert(error(R"({"name": 1})") == JsonDecodeError::kTypeMismatch);
+        assert(error(R"({"user_id": "1"})") == JsonDecodeError::kTypeMismatch);
+        event.user_id = 77;
+        assert(error(R"({"user_id": 1.5})") == JsonDecodeError::kTypeMismatch);
+        assert(event.user_id == 77);
+        assert(error(R"({"user_id": -1})") == JsonDecodeError::kTypeMismatch);
+        assert(event.user_id == 77);
+        assert(error(R"({"user_id": 3e2})") == JsonDecodeError::kTypeMismatch);
+        assert(event.user_id == 77);
+        assert(error(R"({"user_id": 18446744073709551616})") == JsonDecodeError::kInvalidNumber);
+        assert(event.user_id == 77);
+        assert(error(R"({"latency": 01})") == JsonDecodeError::kInvalidNumber);
+        assert(error(R"({"latency": 1.})") == JsonDecodeError::kInvalidNumber);
+        assert(error(R"({"cached": 1})") == JsonDecodeError::kTypeMismatch);
+        assert(error(R"({"name": "\x"})") == JsonDecodeError::kInvalidString);
+        assert(error(R"({"name": "\udc00"})") == JsonDecodeError::kInvalidString);
+        assert(error("{\"name\": \"a\nb\"}") == JsonDecodeError::kInvalidString);
+        assert(error(R"({"other": tru})") == JsonDecodeError::kUnexpectedChar);
+
+        // Field is not overwritten by the string which fails in the middle of the escapes
+        event.name = "kept";
+        assert(error(R"({"name": "new\\value\x"})") == JsonDecodeError::kInvalidString);
+        assert(event.name == "kept");
+        assert(error(R"({"name": "new\\value)") == JsonDecodeError::kUnexpectedEnd);
+        assert(event.name == "kept");
+        assert(DecodeJsonObject<EventFields>(R"({"name": "new\\value"})", event).ok());
+        assert(event.name == "new\\value");
+        assert(DecodeJsonObject<EventFields>(R"({"name": "\tvalue"})", event).ok());
+        assert(event.name == "\tvalue");
+
+        std::string deep = R"({"other": )";
+        deep.append(100, '[');
+        deep.append(100, ']');
+        deep.push_back('}');
+        assert(error(deep) == JsonDecodeError::kTooDeep);
+
+        const JsonDecodeResult result = DecodeJsonObject<EventFields>(R"({"cached": nope})", event);
+        assert(result.error == JsonDecodeError::kTypeMismatch);
+        assert(result.position == 11);
+    }
+}
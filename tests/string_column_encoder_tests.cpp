@@ -0,0 +1,131 @@
+#include <cassert>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../StringColumnEncoder.hpp"
+
+namespace {
+
+inline constexpr std::string_view kCurrencies[] = {"USD", "EUR", "JPY", "GBP", "CHF", "CNY"};
+
+template <StringMapBackend Backend>
+using CurrencyMatch =
+    StringMatchWithBackend<Backend, kCurrencies[0], kCurrencies[1], kCurrencies[2],
+                           kCurrencies[3], kCurrencies[4], kCurrencies[5]>;
+
+template <class Offset>
+struct Column final {
+    std::vector<Offset> offsets{0};
+    std::string data;
+
+    void push_back(std::string_view value) {
+        data += value;
+        offsets.push_back(static_cast<Offset>(data.size()));
+    }
+
+    [[nodiscard]] StringColumnView<Offset> view() const noexcept {
+        return {.offsets = offsets, .data = data};
+    }
+
+    [[nodiscard]] std::string_view row(std::size_t i) const noexcept {
+        return std::string_view(data).substr(static_cast<std::size_t>(offsets[i]),
+                                             static_cast<std::size_t>(offsets[i + 1] - offsets[i]));
+    }
+};
+
+template <class Offset>
+Column<Offset> MakeColumn(std::size_t rows, std::uint32_t seed) {
+    constexpr std::string_view kMisses[] = {"", "US", "USDX", "usd", "Swiss franc", "EU"};
+    std::mt19937 rnd(seed);
+    Column<Offset> column;
+    for (std::size_t i = 0; i < rows; i++) {
+        column.push_back(rnd() % 4 != 0 ? kCurrencies[rnd() % std::size(kCurrencies)]
+                                        : kMisses[rnd() % std::size(kMisses)]);
+    }
+    return column;
+}
+
+template <class Map, class Offset>
+void CheckEncoding(const Map& map, DictionaryEncoderPool& pool, const Column<Offset>& column) {
+    const std::size_t rows = column.offsets.size() - 1;
+    std::vector<std::uint8_t> codes(rows, 0xFF);
+    assert(DictionaryEncodeColumn(map, column.view(), std::span(codes)));
+    for (std::size_t i = 0; i < rows; i++) {
+        assert(codes[i] == map(column.row(i)));
+    }
+
+    std::vector<std::int32_t> pool_codes(rows, -1);
+    assert(pool.encode(map, column.view(), std::span(pool_codes)));
+    for (std::size_t i = 0; i < rows; i++) {
+        assert(pool_codes[i] == static_cast<std::int32_t>(codes[i]));
+    }
+}
+
+template <class Map>
+void CheckMap(DictionaryEncoderPool& pool) {
+    constexpr Map map{};
+    constexpr std::size_t kRows[] = {0, 1, 7, 100, 3 * DictionaryEncoderPool::kRowsPerChunk + 5};
+    for (const std::size_t rows : kRows) {
+        CheckEncoding(map, pool, MakeColumn<std::int32_t>(rows, static_cast<std::uint32_t>(rows)));
+        CheckEncoding(map, pool, MakeColumn<std::int64_t>(rows, static_cast<std::uint32_t>(rows)));
+    }
+}
+
+}  // namespace
+
+int main() {
+    DictionaryEncoderPool pool(4);
+    assert(pool.threads_count() == 4);
+    CheckMap<CurrencyMatch<StringMapBackend::kTrie>>(pool);
+    CheckMap<CurrencyMatch<StringMapBackend::kPacked>>(pool);
+    CheckMap<CurrencyMatch<StringMapBackend::kEytzinger>>(pool);
+    CheckMap<CurrencyMatch<StringMapBackend::kCompare>>(pool);
+
+    DictionaryEncoderPool single_thread_pool(1);
+    assert(single_thread_pool.threads_count() == 1);
+    CheckMap<CurrencyMatch<StringMapBackend::kAuto>>(single_thread_pool);
+
+    {
+        // Last values are shorter than the padding of the lookup, padding of the buffer is
+        //  taken into account
+        constexpr CurrencyMatch<StringMapBackend::kTrie> map{};
+        Column<std::int32_t> column;
+        column.push_back("EUR");
+        column.push_back("USD");
+        column.push_back("");
+        column.data.append(64, '\0');
+        StringColumnView<std::int32_t> view = column.view();
+        view.data                           = view.data.first(6);
+        view.padding                        = 64;
+        std::vector<std::uint8_t> codes(3);
+        assert(DictionaryEncodeColumn(map, view, std::span(codes)));
+        assert(codes[0] == 1 && codes[1] == 0 && codes[2] == map.kDefaultValue);
+    }
+    {
+        // Shape of the column does not match the codes
+        constexpr CurrencyMatch<StringMapBackend::kTrie> map{};
+        const Column<std::int32_t> column = MakeColumn<std::int32_t>(10, 1);
+        std::vector<std::uint8_t> codes(9, 0xFF);
+        assert(!DictionaryEncodeColumn(map, column.view(), std::span(codes)));
+        assert(!pool.encode(map, column.view(), std::span(codes)));
+        assert(codes[0] == 0xFF);
+
+        codes.resize(10);
+        StringColumnView<std::int32_t> truncated = column.view();
+        truncated.data = truncated.data.first(truncated.data.size() - 1);
+        assert(truncated.data.size() < static_cast<std::size_t>(column.offsets.back()));
+        assert(!DictionaryEncodeColumn(map, truncated, std::span(codes)));
+
+        const std::vector<std::int32_t> negative_offsets = {-1, 0};
+        codes.resize(1);
+        assert(!DictionaryEncodeColumn(map, StringColumnView<std::int32_t>{negative_offsets, {}},
+                                       std::span(codes)));
+
+        codes.clear();
+        assert(DictionaryEncodeColumn(map, StringColumnView<std::int32_t>{}, std::span(codes)));
+    }
+}
@@ -0,0 +1,95 @@
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "../StringKeyedArray.hpp"
+
+int main() {
+    {
+        StringKeyedArray<std::uint64_t, "GET", "PUT", "POST", "DELETE"> requests;
+        static_assert(requests.kKeysCount == 4);
+        static_assert(requests.index_of("PUT") == 1);
+        static_assert(requests.index_of("PATCH") == requests.kNotFound);
+        static_assert(requests.index_of<"DELETE">() == 3);
+        static_assert(requests.kKeys[2] == "POST");
+        static_assert(alignof(decltype(requests)) >= 64);
+
+        assert(requests.add("GET"));
+        assert(requests.add("GET", 2));
+        assert(requests.add("DELETE"));
+        assert(!requests.add("PATCH"));
+        requests.add_at(requests.index_of<"POST">(), 5);
+        assert(requests.load("GET") == 3);
+        assert(requests.load("PUT") == 0);
+        assert(requests.load("POST") == 5);
+        assert(requests.load("PATCH") == 0);
+        assert((requests.snapshot() == std::array<std::uint64_t, 4>{3, 0, 5, 1}));
+
+        assert((requests.take_snapshot() == std::array<std::uint64_t, 4>{3, 0, 5, 1}));
+        assert((requests.snapshot() == std::array<std::uint64_t, 4>{}));
+        requests.add("PUT");
+        assert((requests.take_snapshot() == std::array<std::uint64_t, 4>{0, 1, 0, 0}));
+
+        requests.merge({1, 2, 3, 4});
+        StringKeyedArray<std::uint64_t, "GET", "PUT", "POST", "DELETE"> other;
+        other.add("GET", 10);
+        requests.merge(other);
+        assert((requests.snapshot() == std::array<std::uint64_t, 4>{11, 2, 3, 4}));
+        requests.reset();
+        assert(requests.load("GET") == 0);
+    }
+    {
+        // Latency sums, one shard
+        StringKeyedArrayWithShards<double, 1, "db", "cache"> latency_sums;
+        static_assert(latency_sums.kShardsCount == 1);
+        latency_sums.add("db", 1.5);
+        latency_sums.add("db", 0.25);
+        latency_sums.add("cache", 0.125);
+        assert(latency_sums.load("db") == 1.75);
+        assert(latency_sums.load("cache") == 0.125);
+    }
+    {
+        // Concurrent updates of the same keys are not lost
+        using ErrorCounters = StringKeyedArrayWithShards<std::uint64_t, 4, "timeout", "refused",
+                                                         "reset", "unreachable">;
+        ErrorCounters errors;
+        constexpr std::size_t kThreads   = 8;
+        constexpr std::uint64_t kUpdates = 20000;
+        constexpr std::string_view kNames[] = {"timeout", "refused", "reset", "unreachable",
+                                               "unknown"};
+
+        std::vector<std::uint64_t> interval_totals(ErrorCounters::kKeysCount);
+        std::vector<std::thread> threads;
+        for (std::size_t thread_index = 0; thread_index < kThreads; thread_index++) {
+            threads.emplace_back([&errors, &kNames, thread_index]() {
+                for (std::uint64_t i = 0; i < kUpdates; i++) {
+                    errors.add(kNames[(thread_index + i) % std::size(kNames)]);
+                }
+            });
+        }
+        // Intervals taken while the writers run lose nothing
+        for (std::size_t interval = 0; interval < 10; interval++) {
+            const ErrorCounters::Values values = errors.take_snapshot();
+            for (std::size_t i = 0; i < values.size(); i++) {
+                interval_totals[i] += values[i];
+            }
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        const ErrorCounters::Values values = errors.take_snapshot();
+        std::uint64_t total = 0;
+        for (std::size_t i = 0; i < values.size(); i++) {
+            interval_totals[i] += values[i];
+            total += interval_totals[i];
+        }
+        // Every fifth update is for the unknown key
+        assert(total == kThreads * kUpdates / std::size(kNames) * (std::size(kNames) - 1));
+        for (std::size_t i = 0; i < ErrorCounters::kKeysCount; i++) {
+            assert(interval_totals[i] == kThreads * kUpdates / std::size(kNames));
+        }
+    }
+}
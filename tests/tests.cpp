@@ -1,10 +1,13 @@
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cinttypes>
 #include <cstdint>
 #include <ctime>
 #include <random>
 #include <ranges>
+#include <thread>
+#include <vector>
 
 #include "../StringMap.hpp"
 
@@ -92,6 +95,62 @@ inline constexpr std::string_view kStrings[] = {
 };
 // clang-format on
 
+// Chosen so that the adaptive radix tree has nodes of all kinds
+// clang-format off
+inline constexpr std::string_view kArtStrings[] = {
+    "w0", "w1", "z0", "z1", "z2", "z3", "z4", "z5", "z6", "z7", "z8", "z9", "y0", "y1", "y2",
+    "y3", "y4", "y5", "y6", "y7", "y8", "y9", "ya", "yb", "yc", "yd", "ye", "yf", "yg", "yh",
+    "yi", "yj", "x0", "x1", "x2", "x3", "x4", "x5", "x6", "x7", "x8", "x9", "xa", "xb", "xc",
+    "xd", "xe", "xf", "xg", "xh", "xi", "xj", "xk", "xl", "xm", "xn", "xo", "xp", "xq", "xr",
+    "xs", "xt", "xu", "xv", "xw", "xx", "xy", "xz", "xA", "xB", "xC", "xD", "xE", "xF", "xG",
+    "xH", "xI", "xJ", "xK", "xL", "xM", "xN", "xO", "xP", "xQ", "xR", "xS", "xT", "xU", "xV",
+    "xW", "xX", "xY", "xZ", "xylophone", "x", "zz-top", "w0w0w0",
+};
+// clang-format on
+
+template <StringMapBackend Backend, std::size_t... Indexes>
+constexpr auto MakeArtStringsMatch(std::index_sequence<Indexes...>) noexcept {
+    return StringMatchWithBackend<Backend, kArtStrings[Indexes]...>();
+}
+
+template <StringMapBackend Backend, std::size_t... Indexes>
+constexpr auto MakeStringsMatch(std::index_sequence<Indexes...>) noexcept {
+    return StringMatchWithBackend<Backend, kStrings[Indexes]...>();
+}
+
+// Reference backtracking matcher for the StringGlobMap tests
+constexpr bool GlobMatches(std::string_view pattern, std::string_view str, char separator) noexcept {
+    if (pattern.empty()) {
+        return str.empty();
+    }
+    if (pattern.starts_with("**")) {
+        const std::string_view rest = pattern.substr(std::min(pattern.find_first_not_of('*'),
+                                                              pattern.size()));
+        for (std::size_t skipped = 0; skipped <= str.size(); skipped++) {
+            if (GlobMatches(rest, str.substr(skipped), separator)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    if (pattern[0] == '*') {
+        for (std::size_t skipped = 0; skipped <= str.size(); skipped++) {
+            if (GlobMatches(pattern.substr(1), str.substr(skipped), separator)) {
+                return true;
+            }
+            if (skipped < str.size() && str[skipped] == separator) {
+                break;
+            }
+        }
+        return false;
+    }
+    if (str.empty()) {
+        return false;
+    }
+    const bool char_matches = pattern[0] == '?' ? str[0] != separator : pattern[0] == str[0];
+    return char_matches && GlobMatches(pattern.substr(1), str.substr(1), separator);
+}
+
 constexpr uint64_t operator-(const timespec& t2, const timespec& t1) noexcept {
     const auto sec_passed        = static_cast<uint64_t>(t2.tv_sec - t1.tv_sec);
     auto nanoseconds_passed      = sec_passed * 1'000'000'000;
@@ -265,6 +324,950 @@ int main() {
         assert(map(kMyConstants[3]) == MyTrivialType(0, 0, 0));
         assert(map.kDefaultValue == MyTrivialType(0, 0, 0));
     }
+    {
+        enum class Keyword {
+            kIf,
+            kElse,
+            kWhile,
+            kYield,
+            kAwait,
+            kTenantElse,
+            kTenantFoo,
+            kNone,
+        };
+        using enum Keyword;
+        using CoreMap = StringMap<std::array{kIf, kElse, kWhile}, kNone, "if", "else", "while">;
+        using PluginMap =
+            StringMap<std::array{kYield, kAwait, kElse}, kNone, "yield", "await", "else">;
+        using TenantMap = StringMap<std::array{kTenantElse, kTenantFoo}, kNone, "else", "foo">;
+
+        static constexpr auto first_wins =
+            MergedStringMap<StringMapMergePolicy::kFirstWins, CoreMap, PluginMap, TenantMap>();
+        static_assert(first_wins("if") == kIf);
+        static_assert(first_wins("else") == kElse);
+        static_assert(first_wins("while") == kWhile);
+        static_assert(first_wins("yield") == kYield);
+        static_assert(first_wins("await") == kAwait);
+        static_assert(first_wins("foo") == kTenantFoo);
+        static_assert(first_wins("bar") == kNone);
+        static_assert(first_wins.kDefaultValue == kNone);
+        static_assert(first_wins.kMappedValues.size() == 6);
+
+        static constexpr auto last_wins =
+            MergedStringMap<StringMapMergePolicy::kLastWins, CoreMap, PluginMap, TenantMap>();
+        static_assert(last_wins("else") == kTenantElse);
+        static_assert(last_wins("if") == kIf);
+        static_assert(last_wins("foo") == kTenantFoo);
+
+        using AsyncMap = StringMap<std::array{kYield, kAwait}, kNone, "yield", "await">;
+        static constexpr auto no_collisions =
+            MergedStringMap<StringMapMergePolicy::kError, CoreMap, AsyncMap>();
+        static_assert(no_collisions("else") == kElse);
+        static_assert(no_collisions("await") == kAwait);
+        static_assert(no_collisions("foo") == kNone);
+
+        assert(first_wins("else") == kElse);
+        assert(first_wins("yield") == kYield);
+        assert(first_wins("foo") == kTenantFoo);
+        assert(first_wins("fo") == kNone);
+        assert(last_wins("else") == kTenantElse);
+        assert(no_collisions("while") == kWhile);
+
+        // Indexes of the StringMatch are renumbered by the position in the merged map
+        static constexpr auto merged_matches =
+            MergedStringMap<StringMapMergePolicy::kError, StringMatch<"a", "b">,
+                            StringMatch<"c", "d", "e">>();
+        static_assert(merged_matches.kDefaultValue == 5);
+        static_assert(merged_matches("a") == 0);
+        static_assert(merged_matches("b") == 1);
+        static_assert(merged_matches("c") == 2);
+        static_assert(merged_matches("e") == 4);
+        static_assert(merged_matches("f") == 5);
+        assert(merged_matches("d") == 3);
+        assert(merged_matches("x") == merged_matches.kDefaultValue);
+
+        static constexpr auto merged_first_wins =
+            MergedStringMap<StringMapMergePolicy::kFirstWins, StringMatch<"a", "b">,
+                            StringMatch<"b", "c">>();
+        static_assert(merged_first_wins.kDefaultValue == 3);
+        static_assert(merged_first_wins("a") == 0 && merged_first_wins("b") == 1);
+        static_assert(merged_first_wins("c") == 2);
+    }
+    {
+        static constexpr auto sw = StringMatch<"abc", "def", "ghij", "foo", "bar", "baz", "qux",
+                                               "abacaba", "ring", "ideal", "GLn(F)",
+                                               "abcdefghijklmnopqrstuvwxyz0123456789">();
+        static constexpr auto few_sw = StringMatch<"on", "off", "abcdefghijk">();
+        static_assert(sw(std::string_view("abacaba"), PaddedInput<32>{}) == 7);
+        static_assert(few_sw(std::string_view("off"), PaddedInput<32>{}) == 1);
+
+        // Tokens in the buffer with at least 32 readable bytes after the end of every token
+        std::string buffer =
+            "abc def ghij foo bar baz qux abacaba ring ideal GLn(F) "
+            "abcdefghijklmnopqrstuvwxyz0123456789 ab abcd abacab abacabad abcdefghijklmnopqrstuvwxyz012345678 "
+            "on off of abcdefghijk abcdefghij abcdefghijkl";
+        const std::size_t tokens_end = buffer.size();
+        buffer.append(32, '\0');
+        const std::string_view tokens(buffer.data(), tokens_end);
+
+        std::size_t token_index = 0;
+        for (std::size_t pos = 0; pos < tokens.size(); token_index++) {
+            const std::size_t end        = std::min(tokens.find(' ', pos), tokens.size());
+            const std::string_view token = tokens.substr(pos, end - pos);
+            assert(sw(token, PaddedInput<32>{}) == sw(token));
+            assert(few_sw(token, PaddedInput<32>{}) == few_sw(token));
+            const auto* const utoken = reinterpret_cast<const unsigned char*>(token.data());
+            assert(sw(utoken, token.size(), PaddedInput<32>{}) == sw(token));
+            if (token_index < 12) {
+                assert(sw(token, PaddedInput<32>{}) == token_index);
+            }
+            pos = end + 1;
+        }
+        assert(token_index == 23);
+    }
+    {
+        constexpr auto dispatch = [](std::string_view command) constexpr {
+            int calls = 0;
+            const int code = StringSwitch<"GET", "PUT", "DELETE", "PATCH", "OPTIONS">(
+                command, [&] { return calls += 1, 200; }, [&] { return calls += 1, 201; },
+                [&] { return calls += 1, 204; }, [&] { return calls += 1, 202; },
+                [&] { return calls += 1, 203; }, [&] { return calls += 1, 405; });
+            return code * 10 + calls;
+        };
+        static_assert(dispatch("GET") == 2001);
+        static_assert(dispatch("PUT") == 2011);
+        static_assert(dispatch("DELETE") == 2041);
+        static_assert(dispatch("PATCH") == 2021);
+        static_assert(dispatch("OPTIONS") == 2031);
+        static_assert(dispatch("POST") == 4051);
+        static_assert(dispatch("") == 4051);
+
+        assert(dispatch("GET") == 2001);
+        assert(dispatch("OPTIONS") == 2031);
+        assert(dispatch("GETS") == 4051);
+
+        // Without default handler
+        int last_handler = -1;
+        const std::string input = "bar";
+        StringSwitch<"foo", "bar">(
+            input, [&] { last_handler = 0; }, [&] { last_handler = 1; });
+        assert(last_handler == 1);
+        StringSwitch<"foo", "bar">(
+            "baz", [&] { last_handler = 0; }, [&] { last_handler = 1; });
+        assert(last_handler == 1);
+        assert((StringSwitch<"foo", "bar">("qux", [] { return 1; }, [] { return 2; }) == 0));
+        assert((StringSwitch<"foo", "bar">("foo", [] { return 1; }, [] { return 2; }) == 1));
+    }
+    {
+        static constexpr auto sw = StringMatch<"abc", "abd", "xyz", "abcd", "qwerty">();
+        static constexpr auto few_sw = StringMatch<"on", "off">();
+        static_assert(sw.kStatsEnabled == STRING_MAP_ENABLE_STATS);
+        static_assert(few_sw.kStatsEnabled == STRING_MAP_ENABLE_STATS);
+        sw.reset_stats();
+        few_sw.reset_stats();
+
+        assert(sw("abc") == 0);
+        assert(sw("ab") == sw.kDefaultValue);
+        assert(sw("abz") == sw.kDefaultValue);
+        assert(sw("a~") == sw.kDefaultValue);
+        assert(few_sw("on") == 0);
+        assert(few_sw("of") == few_sw.kDefaultValue);
+
+        const StringMapStats stats     = sw.stats();
+        const StringMapStats few_stats = few_sw.stats();
+#if STRING_MAP_ENABLE_STATS
+        assert(stats.lookups == 4);
+        assert(stats.hits == 1);
+        assert(stats.misses == 3);
+        assert(stats.total_depth == 3 + 2 + 2 + 1);
+        assert(stats.max_depth == 3);
+        assert(stats.average_depth() == 2.0);
+        assert(stats.out_of_alphabet_exits == 1);
+        assert(stats.missing_edge_exits == 1);
+        assert(stats.non_terminal_exits == 1);
+        assert(few_stats.lookups == 2);
+        assert(few_stats.hits == 1);
+        assert(few_stats.misses == 1);
+
+        sw.reset_stats();
+        assert(sw.stats().lookups == 0);
+
+        // Reset while another thread is doing lookups: lookups finished before the reset are
+        //  never counted and the hits never exceed the lookups
+        for (std::size_t round = 0; round < 20; round++) {
+            std::atomic<std::uint64_t> done{0};
+            std::atomic<bool> stop{false};
+            std::atomic<bool> paused{false};
+            std::atomic<bool> exit{false};
+            std::thread worker([&] {
+                while (!stop.load(std::memory_order_acquire)) {
+                    NOOPT(sw("abc"));
+                    done.fetch_add(1, std::memory_order_release);
+                }
+                paused.store(true, std::memory_order_release);
+                while (!exit.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+            });
+            while (done.load(std::memory_order_acquire) < 1000) {
+                std::this_thread::yield();
+            }
+            const std::uint64_t done_before_reset = done.load(std::memory_order_acquire);
+            sw.reset_stats();
+            const StringMapStats concurrent_stats = sw.stats();
+            assert(concurrent_stats.misses == 0);
+            assert(concurrent_stats.hits <= concurrent_stats.lookups + 1);
+            stop.store(true, std::memory_order_release);
+            while (!paused.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            const StringMapStats paused_stats = sw.stats();
+            assert(paused_stats.lookups <= done.load() - done_before_reset);
+            assert(paused_stats.hits == paused_stats.lookups);
+            assert(paused_stats.misses == 0);
+            sw.reset_stats();
+            assert(sw.stats().lookups == 0);
+            exit.store(true, std::memory_order_release);
+            worker.join();
+        }
+#else
+        assert(stats.lookups == 0);
+        assert(few_stats.lookups == 0);
+#endif
+    }
+    {
+        using TrieMatch = StringMatchWithBackend<StringMapBackend::kTrie, "abc", "abd", "xyz",
+                                                 "abcd", "qwerty">;
+        constexpr StringMapFootprint kTrieFootprint = TrieMatch::kFootprint;
+        static_assert(kTrieFootprint.backend == StringMapBackend::kTrie);
+        static_assert(kTrieFootprint.strings_count == 5);
+        static_assert(kTrieFootprint.nodes_count == 1 + 5 + 3 + 6);
+        static_assert(kTrieFootprint.alphabet_size == 'z' - 'a' + 1);
+        static_assert(kTrieFootprint.bytes_per_node >= 26 * sizeof(std::uint32_t));
+        static_assert(kTrieFootprint.table_bytes ==
+                      kTrieFootprint.nodes_count * kTrieFootprint.bytes_per_node);
+        // Map object is a handle, the table is shared by all objects of the type
+        static_assert(std::is_empty_v<TrieMatch>);
+        static_assert(kTrieFootprint.max_depth == 6);
+
+        using CompareMatch = StringMatchWithBackend<StringMapBackend::kCompare, "on", "off">;
+        constexpr StringMapFootprint kCompareFootprint = CompareMatch::kFootprint;
+        static_assert(kCompareFootprint.backend == StringMapBackend::kCompare);
+        static_assert(kCompareFootprint.strings_count == 2);
+        static_assert(kCompareFootprint.nodes_count == 0);
+        static_assert(kCompareFootprint.table_bytes < kTrieFootprint.table_bytes);
+        static_assert(kCompareFootprint.max_depth == 3);
+
+        static_assert(std::is_same_v<StringMapWithinBudget<32 * 1024, TrieMatch>, TrieMatch>);
+        static_assert(std::is_same_v<StringMapWithinBudget<kTrieFootprint.table_bytes, TrieMatch>,
+                                     TrieMatch>);
+        // StringMapWithinBudget<kTrieFootprint.table_bytes - 1, TrieMatch> does not compile
+
+        static constexpr auto sw = StringMapWithinBudget<4096, CompareMatch>();
+        static_assert(sw("off") == 1);
+        assert(sw("on") == 0);
+    }
+    {
+        // Same keys with both backends, compared with the binary search over the sorted keys
+        constexpr auto kCheckOrderedQueries = [](const auto& map) {
+            const std::string_view sorted_keys[] = {
+                "cpu",           "cpu.idle", "cpu.system", "cpu.user", "cpuset",
+                "disk.read",     "disk.write", "mem", "mem.free", "mem.used",
+                "net.rx~dropped",
+            };
+            assert(map.entries().size() == std::size(sorted_keys));
+            for (std::size_t i = 0; i < std::size(sorted_keys); i++) {
+                assert(map.entries()[i].key == sorted_keys[i]);
+                assert(map.entries()[i].value == map(sorted_keys[i]));
+            }
+
+            const std::string_view queries[] = {
+                "",        "c",     "cpu",   "cpu.", "cpu.s", "cpu.zzz", "cpus",     "cpuset",
+                "cpusets", "d",     "disk.", "e",    "mem",   "mem.",    "mem.used", "net.rx",
+                "net.rx~", "net.~", "zzz",   "A",    "~",     "cpu\x7f", "mem.f",
+            };
+            for (const std::string_view query : queries) {
+                const std::size_t expected_lower = static_cast<std::size_t>(
+                    std::ranges::lower_bound(sorted_keys, query) - std::begin(sorted_keys));
+                const std::size_t expected_upper = static_cast<std::size_t>(
+                    std::ranges::upper_bound(sorted_keys, query) - std::begin(sorted_keys));
+                assert(map.lower_bound(query) == map.entries().begin() + expected_lower);
+                assert(map.upper_bound(query) == map.entries().begin() + expected_upper);
+
+                const auto range = map.prefix_range(query);
+                std::size_t expected_size = 0;
+                for (const std::string_view key : sorted_keys) {
+                    expected_size += key.starts_with(query);
+                }
+                assert(range.size() == expected_size);
+                assert(range.begin() == map.entries().begin() + expected_lower);
+                for (const auto& entry : range) {
+                    assert(entry.key.starts_with(query));
+                }
+            }
+        };
+
+        static constexpr auto trie_sw = StringMatchWithBackend<
+            StringMapBackend::kTrie, "mem", "cpu.user", "disk.write", "cpu", "net.rx~dropped",
+            "cpu.system", "mem.used", "disk.read", "cpuset", "cpu.idle", "mem.free">();
+        static constexpr auto compare_sw = StringMatchWithBackend<
+            StringMapBackend::kCompare, "mem", "cpu.user", "disk.write", "cpu", "net.rx~dropped",
+            "cpu.system", "mem.used", "disk.read", "cpuset", "cpu.idle", "mem.free">();
+        kCheckOrderedQueries(trie_sw);
+        kCheckOrderedQueries(compare_sw);
+
+        static_assert(trie_sw.prefix_range("cpu.").size() == 3);
+        static_assert(trie_sw.prefix_range("cpu.")[0].key == "cpu.idle");
+        static_assert(trie_sw.prefix_range("cpu.")[0].value == 9);
+        static_assert(trie_sw.prefix_range("cpu.")[2].key == "cpu.user");
+        static_assert(trie_sw.prefix_range("mem.x").empty());
+        static_assert(trie_sw.lower_bound("d")->key == "disk.read");
+        static_assert(trie_sw.upper_bound("net.rx~dropped") == trie_sw.entries().end());
+        static_assert(compare_sw.prefix_range("disk").size() == 2);
+        static_assert(compare_sw.lower_bound("cpu.t")->key == "cpu.user");
+
+        // Values are mapped through the sorted entries too
+        enum class Metric { kNone, kCpu, kMem, kDisk };
+        static constexpr auto metrics =
+            StringMap<std::array{Metric::kMem, Metric::kCpu, Metric::kDisk}, Metric::kNone,
+                      "mem", "cpu", "disk">();
+        static_assert(metrics.entries()[0].key == "cpu");
+        static_assert(metrics.entries()[0].value == Metric::kCpu);
+        static_assert(metrics.entries()[2].value == Metric::kMem);
+    }
+    {
+        constexpr auto kCheckMatchUntil = [](const auto& map) {
+            using Result = decltype(map.template match_until<'='>(""));
+            constexpr auto kDefault = map.kDefaultValue;
+            const auto check = [](const Result result, std::size_t value, std::size_t position) {
+                assert(result.value == value);
+                assert(result.position == position);
+            };
+            check(map.template match_until<'='>("key=value"), 0, 3);
+            check(map.template match_until<'='>("key2=value2"), 1, 4);
+            check(map.template match_until<'='>("key"), 0, 3);
+            check(map.template match_until<'='>("ke=value"), kDefault, 2);
+            check(map.template match_until<'='>("kex=value"), kDefault, 2);
+            check(map.template match_until<'='>("key3=value"), kDefault, 3);
+            check(map.template match_until<'='>("=value"), kDefault, 0);
+            check(map.template match_until<'='>(""), kDefault, 0);
+            check(map.template match_until<'=', ';'>("key;key2"), 0, 3);
+            // Delimiter which is a char of some key stops the match
+            check(map.template match_until<'-'>("a-b: c"), kDefault, 1);
+            check(map.template match_until<':'>("a-b: c"), 2, 3);
+            check(map.template match_until<':', ' '>("a-b c"), 2, 3);
+            check(map.match_until("a-b: c", ":"), 2, 3);
+            check(map.match_until("a-b: c", "-:"), kDefault, 1);
+            check(map.match_until("key2;", ";="), 1, 4);
+            check(map.match_until("key2", ""), 1, 4);
+            check(map.match_until("key2;", ""), kDefault, 4);
+        };
+
+        static constexpr auto trie_sw =
+            StringMatchWithBackend<StringMapBackend::kTrie, "key", "key2", "a-b">();
+        static constexpr auto compare_sw =
+            StringMatchWithBackend<StringMapBackend::kCompare, "key", "key2", "a-b">();
+        kCheckMatchUntil(trie_sw);
+        kCheckMatchUntil(compare_sw);
+        // Sorted entries narrowing and the edges table walk
+        kCheckMatchUntil(
+            StringMatchWithBackend<StringMapBackend::kPacked, "key", "key2", "a-b">());
+        kCheckMatchUntil(
+            StringMatchWithBackend<StringMapBackend::kEytzinger, "key", "key2", "a-b">());
+        kCheckMatchUntil(
+            StringMatchWithBackend<StringMapBackend::kFixedWork, "key", "key2", "a-b">());
+        static_assert(trie_sw.match_until<'='>("key2=").value == 1);
+        static_assert(trie_sw.match_until<'='>("key2=").position == 4);
+        static_assert(compare_sw.match_until("a-b: c", ": ").value == 2);
+
+        // One pass tokenizer of the "key=value;..." list
+        enum class Option { kNone, kHost, kPort, kUser };
+        static constexpr auto options =
+            StringMap<std::array{Option::kHost, Option::kPort, Option::kUser}, Option::kNone,
+                      "host", "port", "user">();
+        std::string_view input = "host=example.com;port=80;password=;user=root";
+        std::size_t known_options = 0;
+        std::string_view port;
+        while (!input.empty()) {
+            const auto [option, position] = options.match_until<'=', ';'>(input);
+            const std::size_t value_begin = input.find('=', position);
+            const std::size_t value_end   = std::min(input.find(';', position), input.size());
+            const std::string_view value  = input.substr(value_begin + 1, value_end - value_begin - 1);
+            known_options += option != Option::kNone;
+            if (option == Option::kPort) {
+                port = value;
+            }
+            input.remove_prefix(std::min(value_end + 1, input.size()));
+        }
+        assert(known_options == 3);
+        assert(port == "80");
+    }
+    {
+        constexpr auto kLevenshteinDistance = [](std::string_view a, std::string_view b) {
+            std::vector<std::size_t> prev(b.size() + 1);
+            std::vector<std::size_t> cur(b.size() + 1);
+            for (std::size_t j = 0; j <= b.size(); j++) {
+                prev[j] = j;
+            }
+            for (std::size_t i = 1; i <= a.size(); i++) {
+                cur[0] = i;
+                for (std::size_t j = 1; j <= b.size(); j++) {
+                    cur[j] = std::min({prev[j] + 1, cur[j - 1] + 1,
+                                       prev[j - 1] + (a[i - 1] != b[j - 1] ? 1 : 0)});
+                }
+                std::swap(prev, cur);
+            }
+            return prev[b.size()];
+        };
+
+        const auto check_within_distance = [&](const auto& map) {
+            const std::string_view queries[] = {
+                "",        "s",      "stat",    "status",   "stats",  "sttaus", "commit",
+                "comit",   "comitt", "cmomit",  "checkout", "chekout", "chckot", "x",
+                "pushh",   "pul",    "rebase~", "zzzzzzz",  "stash",  "sta",    "branchh",
+                "branches", "cherry-pick", "cherrypick", "ccherry-pic", "log", "lg",
+            };
+            for (const std::string_view query : queries) {
+                for (std::size_t max_distance = 0; max_distance <= 3; max_distance++) {
+                    std::size_t prev_rank      = 0;
+                    std::size_t reported_count = 0;
+                    map.for_each_within_distance(
+                        query, max_distance, [&](const auto& entry, std::size_t distance) {
+                            const auto rank =
+                                static_cast<std::size_t>(&entry - map.entries().begin());
+                            assert(reported_count == 0 || prev_rank < rank);
+                            assert(distance == kLevenshteinDistance(entry.key, query));
+                            assert(distance <= max_distance);
+                            prev_rank = rank;
+                            reported_count++;
+                        });
+
+                    std::size_t expected_count = 0;
+                    std::size_t best_distance  = max_distance + 1;
+                    const typename std::remove_cvref_t<decltype(map)>::Entry* best_entry = nullptr;
+                    for (const auto& entry : map.entries()) {
+                        const std::size_t distance = kLevenshteinDistance(entry.key, query);
+                        if (distance <= max_distance) {
+                            expected_count++;
+                            if (distance < best_distance) {
+                                best_distance = distance;
+                                best_entry    = &entry;
+                            }
+                        }
+                    }
+                    assert(reported_count == expected_count);
+
+                    const auto [entry, distance] = map.find_within_distance(query, max_distance);
+                    assert(entry == best_entry);
+                    assert(entry == nullptr || distance == best_distance);
+                }
+            }
+        };
+
+        static constexpr auto trie_sw = StringMatchWithBackend<
+            StringMapBackend::kTrie, "status", "stash", "commit", "checkout", "cherry-pick",
+            "push", "pull", "rebase", "branch", "log", "st", "stage">();
+        static constexpr auto compare_sw = StringMatchWithBackend<
+            StringMapBackend::kCompare, "status", "stash", "commit", "checkout", "cherry-pick",
+            "push", "pull", "rebase", "branch", "log", "st", "stage">();
+        check_within_distance(trie_sw);
+        check_within_distance(compare_sw);
+
+        static_assert(trie_sw.find_within_distance("comitt", 2).entry->key == "commit");
+        static_assert(trie_sw.find_within_distance("comitt", 2).distance == 2);
+        static_assert(trie_sw.find_within_distance("comitt", 1).entry == nullptr);
+        static_assert(trie_sw.find_within_distance("stauts", 2).entry->value == 0);
+        static_assert(compare_sw.find_within_distance("pul", 1).entry->key == "pull");
+        static_assert(compare_sw.find_within_distance("pul", 100).distance == 1);
+    }
+    {
+        constexpr auto kIndexes = std::make_index_sequence<std::size(kArtStrings)>{};
+        static constexpr auto art_sw  = MakeArtStringsMatch<StringMapBackend::kArt>(kIndexes);
+        static constexpr auto trie_sw = MakeArtStringsMatch<StringMapBackend::kTrie>(kIndexes);
+        static_assert(art_sw.kBackend == StringMapBackend::kArt);
+        // Node4, Node16, Node48, Node256
+        static_assert(art_sw.kNodeKindCounts[0] > 0);
+        static_assert(art_sw.kNodeKindCounts[1] == 1);
+        static_assert(art_sw.kNodeKindCounts[2] == 1);
+        static_assert(art_sw.kNodeKindCounts[3] == 1);
+        static_assert(art_sw.kFootprint.nodes_count == trie_sw.kFootprint.nodes_count);
+        static_assert(art_sw.kFootprint.table_bytes < trie_sw.kFootprint.table_bytes);
+
+        static_assert(art_sw("w0") == 0);
+        static_assert(art_sw("xylophone") == std::size(kArtStrings) - 4);
+        static_assert(art_sw("x") == std::size(kArtStrings) - 3);
+        static_assert(art_sw("xy") == 2 + 10 + 20 + 10 + 24);
+        static_assert(art_sw("xyl") == art_sw.kDefaultValue);
+        static_assert(art_sw("") == art_sw.kDefaultValue);
+
+        for (std::size_t i = 0; i < std::size(kArtStrings); i++) {
+            const std::string_view key = kArtStrings[i];
+            assert(art_sw(key) == i);
+            assert(art_sw(std::string(key)) == i);
+            assert(art_sw(std::string(key).c_str()) == i);
+            for (std::size_t len = 0; len < key.size(); len++) {
+                assert(art_sw(key.substr(0, len)) == trie_sw(key.substr(0, len)));
+            }
+            std::string extended(key);
+            for (const char chr : {'\0', '0', 'z', '~', '\x80', '\xff'}) {
+                extended.push_back(chr);
+                assert(art_sw(extended) == trie_sw(extended));
+                extended.back() = 'w';
+                assert(art_sw(extended) == trie_sw(extended));
+                extended.pop_back();
+            }
+        }
+        for (const std::string_view str : {"a", "w", "w2", "z~", "x\x80", "yz", "w0w0", "zz-to"}) {
+            assert(art_sw(str) == art_sw.kDefaultValue);
+            assert(trie_sw(str) == trie_sw.kDefaultValue);
+        }
+        assert(art_sw.match_until<'='>("xylophone=1").value == std::size(kArtStrings) - 4);
+        assert(art_sw.match_until<'='>("xylophone=1").position == 9);
+        assert(art_sw.prefix_range("y").size() == 20);
+        assert(art_sw.find_within_distance("xylofone", 2).entry->key == "xylophone");
+    }
+    {
+        constexpr auto kIndexes = std::make_index_sequence<std::size(kStrings)>{};
+        static constexpr auto dawg_sw = MakeStringsMatch<StringMapBackend::kDawg>(kIndexes);
+        static constexpr auto trie_sw = MakeStringsMatch<StringMapBackend::kTrie>(kIndexes);
+        static_assert(dawg_sw.kBackend == StringMapBackend::kDawg);
+        // Every key ends with one of the 10 suffixes of "abc...z"
+        static_assert(dawg_sw.kFootprint.nodes_count * 5 < trie_sw.kFootprint.nodes_count);
+        static_assert(dawg_sw.kFootprint.table_bytes * 5 < trie_sw.kFootprint.table_bytes);
+
+        static_assert(dawg_sw(kStrings[0]) == 0);
+        static_assert(dawg_sw(kStrings[59]) == 59);
+        static_assert(dawg_sw("abcdefghijklmnopqrstuvwxy") == dawg_sw.kDefaultValue);
+        static_assert(dawg_sw("") == dawg_sw.kDefaultValue);
+
+        for (std::size_t i = 0; i < std::size(kStrings); i++) {
+            const std::string_view key = kStrings[i];
+            assert(dawg_sw(key) == i);
+            assert(dawg_sw(std::string(key)) == i);
+            assert(dawg_sw(std::string(key).c_str()) == i);
+            for (std::size_t len = 0; len < key.size(); len++) {
+                assert(dawg_sw(key.substr(0, len)) == trie_sw(key.substr(0, len)));
+                assert(dawg_sw(key.substr(len)) == trie_sw(key.substr(len)));
+            }
+            std::string extended(key);
+            for (const char chr : {'\0', 'a', 'z', '~', '\xff'}) {
+                extended.push_back(chr);
+                assert(dawg_sw(extended) == trie_sw(extended));
+                extended.pop_back();
+            }
+            assert(dawg_sw.match_until<' '>(extended + " tail").value == i);
+            assert(dawg_sw.match_until<' '>(extended + " tail").position == key.size());
+        }
+        assert(dawg_sw.prefix_range("abcdefghijklmnopqrstuvwxyzabc").size() == 41);
+        assert(dawg_sw.lower_bound("b")->value == 1);
+
+        // Values are not ranks of the keys
+        static constexpr auto dawg_map = StringMapWithBackend<
+            StringMapBackend::kDawg, std::array{70, 20, 40, 10, 30}, 0, "get_total", "put_total",
+            "get", "put", "total">();
+        static_assert(dawg_map("get_total") == 70);
+        static_assert(dawg_map("put_total") == 20);
+        static_assert(dawg_map("get") == 40);
+        static_assert(dawg_map("put") == 10);
+        static_assert(dawg_map("total") == 30);
+        static_assert(dawg_map("get_") == 0);
+        static_assert(dawg_map("_total") == 0);
+        // "_total" suffixes and "get" / "put" nodes are shared
+        static_assert(dawg_map.kFootprint.nodes_count == 11);
+    }
+    {
+        static constexpr auto http_sw = StringMatchWithBackend<
+            StringMapBackend::kPositions, "GET", "HEAD", "POST", "PUT", "DELETE", "CONNECT",
+            "OPTIONS", "TRACE", "PATCH", "Host", "Accept", "Accept-Encoding", "Connection",
+            "Content-Length", "Content-Type", "User-Agent">();
+        static_assert(http_sw.kBackend == StringMapBackend::kPositions);
+        static_assert(http_sw.kPositionsCount <= 3);
+        static_assert(http_sw.kIndexBits <= 8);
+        static_assert(http_sw("GET") == 0);
+        static_assert(http_sw("User-Agent") == 15);
+        static_assert(http_sw("Content-Type") == 14);
+        static_assert(http_sw("Content-Typo") == http_sw.kDefaultValue);
+        static_assert(http_sw("") == http_sw.kDefaultValue);
+        static_assert(http_sw.match_until<':'>("Host: example.com").value == 9);
+
+        static constexpr std::string_view kHttpKeys[] = {
+            "GET",    "HEAD",       "POST",           "PUT",        "DELETE",
+            "CONNECT", "OPTIONS",   "TRACE",          "PATCH",      "Host",
+            "Accept", "Accept-Encoding", "Connection", "Content-Length", "Content-Type",
+            "User-Agent",
+        };
+        for (std::size_t i = 0; i < std::size(kHttpKeys); i++) {
+            const std::string_view key = kHttpKeys[i];
+            assert(http_sw(key) == i);
+            assert(http_sw(std::string(key).c_str()) == i);
+            std::string padded(key);
+            padded.append(PaddedInput<7>::kPadding, '\0');
+            assert(http_sw(std::string_view(padded.data(), key.size()), PaddedInput<7>{}) == i);
+            for (std::size_t len = 0; len < key.size(); len++) {
+                const auto prefix_iter = std::find(std::begin(kHttpKeys), std::end(kHttpKeys),
+                                                   key.substr(0, len));
+                assert(http_sw(key.substr(0, len)) ==
+                       static_cast<std::size_t>(prefix_iter - std::begin(kHttpKeys)));
+            }
+            std::string changed(key);
+            for (std::size_t position = 0; position < changed.size(); position++) {
+                changed[position] ^= 0x20;
+                assert(http_sw(changed) == http_sw.kDefaultValue);
+                changed[position] ^= 0x20;
+            }
+        }
+
+        // Lengths of kStrings are all different
+        static constexpr auto strings_sw = MakeStringsMatch<StringMapBackend::kPositions>(
+            std::make_index_sequence<std::size(kStrings)>{});
+        static_assert(strings_sw.kPositionsCount == 0);
+        for (std::size_t i = 0; i < std::size(kStrings); i++) {
+            assert(strings_sw(kStrings[i]) == i);
+            assert(strings_sw(kStrings[i].substr(1)) == (i < 9 ? i + 1 : strings_sw.kDefaultValue));
+        }
+        // Same length as kStrings[0]
+        static_assert(strings_sw("bcdefghijklmnopqrstuvwxyza") == strings_sw.kDefaultValue);
+
+        static constexpr auto art_strings_sw = MakeArtStringsMatch<StringMapBackend::kPositions>(
+            std::make_index_sequence<std::size(kArtStrings)>{});
+        static_assert(art_strings_sw.kPositionsCount == 2);
+        for (std::size_t i = 0; i < std::size(kArtStrings); i++) {
+            assert(art_strings_sw(kArtStrings[i]) == i);
+        }
+        assert(art_strings_sw("x~") == art_strings_sw.kDefaultValue);
+        assert(art_strings_sw("w2") == art_strings_sw.kDefaultValue);
+
+        // Runtime lookups above use pext if the host has the fast one, static_asserts never do
+        const StringMapCpuFeatures& cpu_features = StringMapHostCpuFeatures();
+        assert(!cpu_features.fast_pext || cpu_features.bmi2);
+    }
+    {
+        static constexpr auto methods_sw =
+            StringMatchWithBackend<StringMapBackend::kPacked, "GET", "HEAD", "POST", "PUT",
+                                   "DELETE", "CONNECT", "OPTIONS", "TRACE", "PATCH">();
+        static_assert(methods_sw.kBackend == StringMapBackend::kPacked);
+        static_assert(methods_sw.kWordsPerKey == 1);
+        static_assert(methods_sw("GET") == 0);
+        static_assert(methods_sw("PATCH") == 8);
+        static_assert(methods_sw("OPTIONS") == 6);
+        static_assert(methods_sw("GE") == methods_sw.kDefaultValue);
+        static_assert(methods_sw("GETS") == methods_sw.kDefaultValue);
+        static_assert(methods_sw("OPTIONS!") == methods_sw.kDefaultValue);
+        static_assert(methods_sw("") == methods_sw.kDefaultValue);
+        assert(methods_sw(std::string_view("GET\0", 4)) == methods_sw.kDefaultValue);
+        assert(methods_sw(std::string_view("PUT", 3)) == 3);
+        assert(methods_sw.match_until<' '>("POST /index.html").value == 2);
+
+        static constexpr std::string_view kHeaders[] = {
+            "Host",       "Accept",         "Accept-Encoding", "Connection",
+            "Content-Length", "Content-Type", "User-Agent",     "X",
+            "Cookie",     "Set-Cookie",     "ETag",            "If-None-Match",
+            "Vary",       "Via",            "Age",             "Accept-Language",
+        };
+        static constexpr auto headers_sw = StringMatchWithBackend<
+            StringMapBackend::kPacked, kHeaders[0], kHeaders[1], kHeaders[2], kHeaders[3],
+            kHeaders[4], kHeaders[5], kHeaders[6], kHeaders[7], kHeaders[8], kHeaders[9],
+            kHeaders[10], kHeaders[11], kHeaders[12], kHeaders[13], kHeaders[14], kHeaders[15]>();
+        static constexpr auto headers_compare_sw = StringMatchWithBackend<
+            StringMapBackend::kCompare, kHeaders[0], kHeaders[1], kHeaders[2], kHeaders[3],
+            kHeaders[4], kHeaders[5], kHeaders[6], kHeaders[7], kHeaders[8], kHeaders[9],
+            kHeaders[10], kHeaders[11], kHeaders[12], kHeaders[13], kHeaders[14], kHeaders[15]>();
+        static_assert(headers_sw.kWordsPerKey == 2);
+        static_assert(headers_sw("Accept-Language") == 15);
+        static_assert(headers_sw("Accept-Encodinh") == headers_sw.kDefaultValue);
+        for (std::size_t i = 0; i < std::size(kHeaders); i++) {
+            const std::string_view key = kHeaders[i];
+            assert(headers_sw(key) == i);
+            assert(headers_sw(std::string(key).c_str()) == i);
+            std::string padded(key);
+            padded.append(PaddedInput<15>::kPadding, '\xff');
+            assert(headers_sw(std::string_view(padded.data(), key.size()), PaddedInput<15>{}) ==
+                   i);
+            for (std::size_t from = 0; from < key.size(); from++) {
+                for (std::size_t len = 0; from + len <= key.size(); len++) {
+                    const std::string_view part = key.substr(from, len);
+                    assert(headers_sw(part) == headers_compare_sw(part));
+                    assert(headers_sw(std::string_view(padded).substr(from, len),
+                                      PaddedInput<15>{}) == headers_compare_sw(part));
+                }
+            }
+            std::string changed(key);
+            changed.back() ^= 1;
+            assert(headers_sw(changed) == headers_compare_sw(changed));
+            changed.push_back('\0');
+            assert(headers_sw(changed) == headers_compare_sw(changed));
+        }
+    }
+    {
+        constexpr auto kIndexes = std::make_index_sequence<std::size(kArtStrings)>{};
+        static constexpr auto fixed_sw =
+            MakeArtStringsMatch<StringMapBackend::kFixedWork>(kIndexes);
+        static constexpr auto trie_sw = MakeArtStringsMatch<StringMapBackend::kTrie>(kIndexes);
+        static constexpr auto sorted_sw =
+            MakeArtStringsMatch<StringMapBackend::kEytzinger>(kIndexes);
+        static_assert(fixed_sw.kBackend == StringMapBackend::kFixedWork);
+        static_assert(fixed_sw.kSteps == std::string_view("xylophone").size());
+        static_assert(fixed_sw("w0") == 0);
+        static_assert(fixed_sw("xylophone") == std::size(kArtStrings) - 4);
+        static_assert(fixed_sw("xylophone!") == fixed_sw.kDefaultValue);
+        static_assert(fixed_sw("xylophones") == fixed_sw.kDefaultValue);
+        static_assert(fixed_sw("") == fixed_sw.kDefaultValue);
+
+        for (std::size_t i = 0; i < std::size(kArtStrings); i++) {
+            const std::string_view key = kArtStrings[i];
+            assert(fixed_sw(key) == i);
+            assert(fixed_sw(std::string(key).c_str()) == i);
+            for (std::size_t len = 0; len < key.size(); len++) {
+                assert(fixed_sw(key.substr(0, len)) == trie_sw(key.substr(0, len)));
+            }
+        }
+        assert(fixed_sw(std::string_view{}) == fixed_sw.kDefaultValue);
+        assert(fixed_sw(std::string_view("xylophone\0", 10)) == fixed_sw.kDefaultValue);
+        assert(fixed_sw(std::string(100, 'x')) == fixed_sw.kDefaultValue);
+
+        // Random strings over the alphabet of the keys plus some chars out of it
+        std::mt19937 rnd(42);
+        constexpr std::string_view kChars = "wxyz0123456789abcdeflophnAZ-~\x80";
+        std::string str;
+        for (std::size_t iteration = 0; iteration < 20000; iteration++) {
+            str.resize(rnd() % (fixed_sw.kSteps + 3));
+            for (char& chr : str) {
+                chr = kChars[rnd() % kChars.size()];
+            }
+            assert(fixed_sw(str) == trie_sw(str));
+            // Walk of the edges table and the narrowing of the sorted entries
+            //  stop at the same char as the trie
+            const auto fixed_match = fixed_sw.match_until<'-', '~'>(str);
+            const auto trie_match  = trie_sw.match_until<'-', '~'>(str);
+            assert(fixed_match.value == trie_match.value);
+            assert(fixed_match.position == trie_match.position);
+            const auto sorted_match = sorted_sw.match_until<'-', '~'>(str);
+            assert(sorted_match.value == trie_match.value);
+            assert(sorted_match.position == trie_match.position);
+        }
+    }
+    {
+        constexpr auto kArtIndexes = std::make_index_sequence<std::size(kArtStrings)>{};
+        static constexpr auto eytzinger_sw =
+            MakeArtStringsMatch<StringMapBackend::kEytzinger>(kArtIndexes);
+        static constexpr auto trie_sw = MakeArtStringsMatch<StringMapBackend::kTrie>(kArtIndexes);
+        static_assert(eytzinger_sw.kBackend == StringMapBackend::kEytzinger);
+        static_assert(eytzinger_sw.kLevels == 7);
+        static_assert(eytzinger_sw("w0") == 0);
+        static_assert(eytzinger_sw("w0w0w0") == std::size(kArtStrings) - 1);
+        static_assert(eytzinger_sw("xylophone") == std::size(kArtStrings) - 4);
+        static_assert(eytzinger_sw("xylophon") == eytzinger_sw.kDefaultValue);
+        static_assert(eytzinger_sw("w") == eytzinger_sw.kDefaultValue);
+        static_assert(eytzinger_sw("~") == eytzinger_sw.kDefaultValue);
+        static_assert(eytzinger_sw("") == eytzinger_sw.kDefaultValue);
+
+        // All keys share the first 8 chars, so only the full key comparison tells them apart
+        constexpr auto kIndexes = std::make_index_sequence<std::size(kStrings)>{};
+        static constexpr auto long_eytzinger_sw =
+            MakeStringsMatch<StringMapBackend::kEytzinger>(kIndexes);
+        static constexpr auto long_trie_sw = MakeStringsMatch<StringMapBackend::kTrie>(kIndexes);
+
+        const auto check_keys = [](const auto& eytzinger, const auto& trie, const auto& keys) {
+            for (std::size_t i = 0; i < std::size(keys); i++) {
+                const std::string_view key = keys[i];
+                assert(eytzinger(key) == i);
+                assert(eytzinger(std::string(key).c_str()) == i);
+                for (std::size_t len = 0; len < key.size(); len++) {
+                    assert(eytzinger(key.substr(0, len)) == trie(key.substr(0, len)));
+                }
+                std::string changed(key);
+                changed.back() ^= 1;
+                assert(eytzinger(changed) == trie(changed));
+                changed.push_back('\0');
+                assert(eytzinger(changed) == trie(changed));
+            }
+        };
+        check_keys(eytzinger_sw, trie_sw, kArtStrings);
+        check_keys(long_eytzinger_sw, long_trie_sw, kStrings);
+        assert(eytzinger_sw(std::string_view("x\0", 2)) == eytzinger_sw.kDefaultValue);
+        assert(eytzinger_sw(std::string(100, 'x')) == eytzinger_sw.kDefaultValue);
+
+        std::mt19937 rnd(42);
+        constexpr std::string_view kChars = "wxyz0123456789abcdeflophnAZ-~\x80";
+        std::string str;
+        for (std::size_t iteration = 0; iteration < 20000; iteration++) {
+            str.resize(rnd() % 12);
+            for (char& chr : str) {
+                chr = kChars[rnd() % kChars.size()];
+            }
+            assert(eytzinger_sw(str) == trie_sw(str));
+            // Garbage after the end of the string is masked out of the prefix
+            std::string padded = str;
+            padded.append(PaddedInput<7>::kPadding, 'w');
+            const std::string_view padded_str(padded.data(), str.size());
+            assert(eytzinger_sw(padded_str, PaddedInput<7>{}) == trie_sw(str));
+            assert(eytzinger_sw(padded_str, PaddedInput<3>{}) == trie_sw(str));
+        }
+        static_assert(eytzinger_sw(std::string_view("w0"), PaddedInput<32>{}) == 0);
+    }
+    {
+        enum class Route {
+            kStatus,
+            kV1Any,
+            kApiAny,
+            kHealth,
+            kNone,
+        };
+        using enum Route;
+        static constexpr auto routes =
+            StringGlobMap<std::array{kStatus, kV1Any, kApiAny, kHealth}, kNone, "/api/*/status",
+                          "/api/v1/*", "/api/**", "/health?">();
+        static_assert(routes("/api/v2/status") == kStatus);
+        // Literal "v1" beats '*', '*' beats '**'
+        static_assert(routes("/api/v1/status") == kV1Any);
+        static_assert(routes("/api/v1/users") == kV1Any);
+        static_assert(routes("/api//status") == kStatus);
+        // '*' does not cross the separator, '**' does
+        static_assert(routes("/api/v1/users/42") == kApiAny);
+        static_assert(routes("/api/") == kApiAny);
+        static_assert(routes("/api") == kNone);
+        static_assert(routes("/healthz") == kHealth);
+        static_assert(routes("/health") == kNone);
+        static_assert(routes("/health/") == kNone);
+        static_assert(routes("") == kNone);
+        assert(routes(std::string("/api/v3/status")) == kStatus);
+        assert(routes("/api/v1/") == kV1Any);
+        assert(routes(static_cast<const char*>(nullptr)) == kNone);
+
+        static constexpr auto metrics = StringGlobMatchWithSeparator<
+            '.', "metrics.cpu.*", "metrics.cpu.user", "metrics.**", "*.count", "?">();
+        static_assert(metrics("metrics.cpu.user") == 1);
+        static_assert(metrics("metrics.cpu.system") == 0);
+        static_assert(metrics("metrics.cpu.user.total") == 2);
+        static_assert(metrics("requests.count") == 3);
+        // 'm' beats '*'
+        static_assert(metrics("metrics.count") == 2);
+        static_assert(metrics("a.b.count") == metrics.kDefaultValue);
+        static_assert(metrics("x") == 4);
+        static_assert(metrics(".") == metrics.kDefaultValue);
+
+        // Result always matches and nothing is missed
+        constexpr std::string_view kPatterns[] = {
+            "a*b", "a?b", "*", "**b", "a.**.c", "a.*.c", "?.?", "ab", "*.b*", "**.**",
+        };
+        static constexpr auto glob_sw =
+            StringGlobMatchWithSeparator<'.', "a*b", "a?b", "*", "**b", "a.**.c", "a.*.c", "?.?",
+                                         "ab", "*.b*", "**.**">();
+        static_assert(glob_sw.kStatesCount > 2);
+        static_assert(glob_sw.kFootprint.strings_count == std::size(kPatterns));
+        static_assert(glob_sw.kFootprint.nodes_count == glob_sw.kStatesCount);
+        static_assert(glob_sw.kFootprint.table_bytes == glob_sw.kTableBytes);
+        using GlobWithinBudget = StringMapWithinBudget<4096, std::remove_cv_t<decltype(glob_sw)>>;
+        static_assert(GlobWithinBudget::kFootprint.backend == StringMapBackend::kAuto);
+        std::mt19937 rnd(43);
+        constexpr std::string_view kChars = "ab.cx";
+        std::string str;
+        for (std::size_t iteration = 0; iteration < 20000; iteration++) {
+            str.resize(rnd() % 8);
+            for (char& chr : str) {
+                chr = kChars[rnd() % kChars.size()];
+            }
+            const std::size_t index = glob_sw(str);
+            const bool any_matches  = std::any_of(
+                std::begin(kPatterns), std::end(kPatterns),
+                [&str](std::string_view pattern) { return GlobMatches(pattern, str, '.'); });
+            assert(any_matches == (index != glob_sw.kDefaultValue));
+            assert(!any_matches || GlobMatches(kPatterns[index], str, '.'));
+        }
+    }
+    {
+        static constexpr auto metrics =
+            SegmentedStringMatch<"cpu.user", "cpu.system", "mem.used", "cpu", "mem.swap.in",
+                                 "net..drops", "disk">();
+        // Root, cpu, mem, net, disk, user, system, used, swap, net's empty segment, in, drops
+        static_assert(metrics.kNodesCount == 12);
+        static_assert(metrics("cpu.user") == 0);
+        static_assert(metrics("cpu.system") == 1);
+        static_assert(metrics("mem.used") == 2);
+        static_assert(metrics("cpu") == 3);
+        static_assert(metrics("mem.swap.in") == 4);
+        static_assert(metrics("net..drops") == 5);
+        static_assert(metrics("disk") == 6);
+        static_assert(metrics("mem") == metrics.kDefaultValue);
+        static_assert(metrics("mem.swap") == metrics.kDefaultValue);
+        static_assert(metrics("cpu.") == metrics.kDefaultValue);
+        static_assert(metrics("cpu.user.") == metrics.kDefaultValue);
+        static_assert(metrics("cpu.idle") == metrics.kDefaultValue);
+        static_assert(metrics("net.drops") == metrics.kDefaultValue);
+        static_assert(metrics(".cpu") == metrics.kDefaultValue);
+        static_assert(metrics("") == metrics.kDefaultValue);
+        static_assert(metrics(".") == metrics.kDefaultValue);
+
+        static_assert(metrics.matched_segments("cpu.idle") == 1);
+        static_assert(metrics.matched_segments("mem.swap.out") == 2);
+        static_assert(metrics.matched_segments("mem.swap.in") == 3);
+        static_assert(metrics.matched_segments("gpu.load") == 0);
+        static_assert(metrics.longest_prefix("cpu.idle").value == 3);
+        static_assert(metrics.longest_prefix("cpu.idle").position == 3);
+        static_assert(metrics.longest_prefix("cpu.user.total").value == 0);
+        static_assert(metrics.longest_prefix("cpu.user.total").position == 8);
+        static_assert(metrics.longest_prefix("cpu").position == 3);
+        static_assert(metrics.longest_prefix("mem.swap.out").value == metrics.kDefaultValue);
+        static_assert(metrics.longest_prefix("mem.swap.out").position == 0);
+        static_assert(metrics.longest_prefix("disk.sda.reads").value == 6);
+
+        assert(metrics(std::string("mem.swap.in")) == 4);
+        assert(metrics(static_cast<const char*>(nullptr)) == metrics.kDefaultValue);
+
+        enum class Handler {
+            kListUsers,
+            kGetUser,
+            kHealth,
+            kRoot,
+            kNone,
+        };
+        using enum Handler;
+        static constexpr auto routes =
+            SegmentedStringMapWithSeparator<'/', std::array{kListUsers, kGetUser, kHealth, kRoot},
+                                            kNone, "/v1/users/list", "/v1/users/get",
+                                            "/health", "/">();
+        static_assert(routes("/v1/users/list") == kListUsers);
+        static_assert(routes("/v1/users/get") == kGetUser);
+        static_assert(routes("/health") == kHealth);
+        static_assert(routes("/") == kRoot);
+        static_assert(routes("/v1/users") == kNone);
+        static_assert(routes("v1/users/list") == kNone);
+        static_assert(routes("/v1/users/list/") == kNone);
+        static_assert(routes.matched_segments("/v1/orders/list") == 2);
+        static_assert(routes.longest_prefix("/health/live").value == kHealth);
+        static_assert(routes.longest_prefix("/health/live").position == 7);
+        static_assert(routes.kTableBytes > 0);
+        static_assert(routes.kFootprint.strings_count == 4);
+        static_assert(routes.kFootprint.nodes_count == routes.kNodesCount);
+        static_assert(routes.kFootprint.table_bytes == routes.kTableBytes);
+        static_assert(routes.kFootprint.max_depth == 4);
+        static_assert(metrics.kFootprint.max_depth == 3);
+        using RoutesWithinBudget = StringMapWithinBudget<4096, std::remove_cv_t<decltype(routes)>>;
+        static_assert(RoutesWithinBudget::kFootprint.table_bytes == routes.kTableBytes);
+
+        // Same results as the flat map of the same keys
+        constexpr std::string_view kKeys[] = {"a.b", "a.bc", "b", "a.b.c", "c..a", ".a", "b.a.b"};
+        static constexpr auto segmented_sw =
+            SegmentedStringMatch<kKeys[0], kKeys[1], kKeys[2], kKeys[3], kKeys[4], kKeys[5],
+                                 kKeys[6]>();
+        static constexpr auto flat_sw = StringMatch<kKeys[0], kKeys[1], kKeys[2], kKeys[3],
+                                                    kKeys[4], kKeys[5], kKeys[6]>();
+        std::mt19937 rnd(44);
+        constexpr std::string_view kChars = "abc..";
+        std::string str;
+        for (std::size_t iteration = 0; iteration < 20000; iteration++) {
+            str.resize(rnd() % 7);
+            for (char& chr : str) {
+                chr = kChars[rnd() % kChars.size()];
+            }
+            assert(segmented_sw(str) == flat_sw(str));
+            const auto [value, position] = segmented_sw.longest_prefix(str);
+            if (value != segmented_sw.kDefaultValue) {
+                assert(position == kKeys[value].size() && str.starts_with(kKeys[value]));
+                assert(position == str.size() || str[position] == '.');
+            }
+        }
+    }
 
     run_bench();
     return 0;
@@ -0,0 +1,199 @@
+/**
+ * Lookup scaling benchmark: every backend is queried from 1...N threads at the same time.
+ *
+ * Usage: threads_bench [max_threads] [lookups_per_thread]
+ *
+ * Threads are pinned to the different cpus (on Linux) and every thread owns its input,
+ *  so the only shared data are the read-only tables of the maps (and the counters if the
+ *  benchmark is built with STRING_MAP_ENABLE_STATS=1). Aggregate throughput should grow
+ *  linearly with the number of threads; anything else points to the false sharing or
+ *  contention on the maps data.
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <latch>
+#include <limits>
+#include <random>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "../StringMap.hpp"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define NOOPT(x) asm("" ::"r,i"(x))
+#else
+#error "Compiler is not supported"
+#endif
+
+namespace {
+
+// clang-format off
+inline constexpr std::string_view kKeywords[] = {
+    "GET", "HEAD", "POST", "PUT", "DELETE", "CONNECT", "OPTIONS", "TRACE", "PATCH",
+    "Host", "Accept", "Accept-Encoding", "Connection", "Content-Length", "Content-Type",
+    "User-Agent",
+};
+// clang-format on
+
+inline constexpr std::string_view kMisses[] = {
+    "get", "HEADER", "", "Content", "Content-Lengthy", "X-Forwarded-For", "Zzz", "PUTS",
+};
+
+template <StringMapBackend Backend>
+using KeywordsMatch = StringMatchWithBackend<
+    Backend, kKeywords[0], kKeywords[1], kKeywords[2], kKeywords[3], kKeywords[4],
+    kKeywords[5], kKeywords[6], kKeywords[7], kKeywords[8], kKeywords[9], kKeywords[10],
+    kKeywords[11], kKeywords[12], kKeywords[13], kKeywords[14], kKeywords[15]>;
+
+// Several hot maps which are placed next to each other in the .rodata
+inline constexpr auto kCompareMatch   = KeywordsMatch<StringMapBackend::kCompare>();
+inline constexpr auto kTrieMatch      = KeywordsMatch<StringMapBackend::kTrie>();
+inline constexpr auto kArtMatch       = KeywordsMatch<StringMapBackend::kArt>();
+inline constexpr auto kDawgMatch      = KeywordsMatch<StringMapBackend::kDawg>();
+inline constexpr auto kPositionsMatch = KeywordsMatch<StringMapBackend::kPositions>();
+inline constexpr auto kPackedMatch    = KeywordsMatch<StringMapBackend::kPacked>();
+inline constexpr auto kFixedMatch     = KeywordsMatch<StringMapBackend::kFixedWork>();
+inline constexpr auto kEytzingerMatch = KeywordsMatch<StringMapBackend::kEytzinger>();
+
+struct ThreadResult final {
+    std::uint64_t nanoseconds{};
+    std::uint64_t lookups{};
+};
+
+void PinCurrentThread([[maybe_unused]] std::size_t cpu_index) noexcept {
+#if defined(__linux__)
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu_index % CPU_SETSIZE, &cpu_set);
+    // Pinning is best effort, e.g. it may be forbidden in the container
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+#endif
+}
+
+std::vector<std::string_view> MakeInput(std::size_t thread_index, std::size_t size) {
+    std::mt19937 rnd(static_cast<std::uint32_t>(thread_index));
+    std::vector<std::string_view> input(size);
+    for (std::string_view& str : input) {
+        // 3/4 hits and 1/4 misses
+        if (rnd() % 4 != 0) {
+            str = kKeywords[rnd() % std::size(kKeywords)];
+        } else {
+            str = kMisses[rnd() % std::size(kMisses)];
+        }
+    }
+    return input;
+}
+
+template <class MapType>
+ThreadResult RunThread(const MapType& map, std::size_t thread_index, std::size_t lookups,
+                       std::latch& ready, const std::atomic<bool>& start_flag) {
+    PinCurrentThread(thread_index);
+    const std::vector<std::string_view> input = MakeInput(thread_index, lookups);
+    ready.count_down();
+
+    while (!start_flag.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    for (const std::string_view str : input) {
+        const auto ans = map(str);
+        NOOPT(ans);
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    return {
+        .nanoseconds = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()),
+        .lookups = lookups,
+    };
+}
+
+template <class MapType>
+void RunBackend(const char* backend_name, const MapType& map, std::size_t max_threads,
+                std::size_t lookups) {
+    for (std::size_t threads_count = 1; threads_count <= max_threads; threads_count++) {
+        std::vector<ThreadResult> results(threads_count);
+        std::vector<std::thread> threads;
+        threads.reserve(threads_count);
+        // Wall time starts when every thread has made its input, so the aggregate throughput
+        //  does not include the input generation and the thread startup
+        std::latch ready(static_cast<std::ptrdiff_t>(threads_count));
+        std::atomic<bool> start_flag{false};
+        for (std::size_t i = 0; i < threads_count; i++) {
+            threads.emplace_back([&map, &results, &ready, &start_flag, i, lookups]() {
+                results[i] = RunThread(map, i, lookups, ready, start_flag);
+            });
+        }
+
+        ready.wait();
+        const auto start = std::chrono::steady_clock::now();
+        start_flag.store(true, std::memory_order_release);
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        const auto end = std::chrono::steady_clock::now();
+
+        const auto wall_nanoseconds = static_cast<double>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        double min_latency = std::numeric_limits<double>::max();
+        double max_latency = 0;
+        double sum_latency = 0;
+        for (const ThreadResult& result : results) {
+            const double latency =
+                static_cast<double>(result.nanoseconds) / static_cast<double>(result.lookups);
+            min_latency = std::min(min_latency, latency);
+            max_latency = std::max(max_latency, latency);
+            sum_latency += latency;
+        }
+        const double total_lookups =
+            static_cast<double>(lookups) * static_cast<double>(threads_count);
+
+        std::printf("%-9s threads: %3zu | %10.2f Mlookups/s | ns/lookup per thread: avg %6.2f, "
+                    "min %6.2f, max %6.2f\n",
+                    backend_name, threads_count, total_lookups * 1e3 / wall_nanoseconds,
+                    sum_latency / static_cast<double>(threads_count), min_latency, max_latency);
+    }
+
+    if constexpr (MapType::kStatsEnabled) {
+        const StringMapStats stats = map.stats();
+        std::printf("%-9s stats: %" PRIu64 " lookups, %" PRIu64 " hits, %" PRIu64
+                    " misses, %.2f avg depth\n",
+                    backend_name, stats.lookups, stats.hits, stats.misses, stats.average_depth());
+    }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    std::size_t lookups     = 2'000'000;
+    if (argc > 1) {
+        max_threads = std::max(std::size_t{1}, std::size_t{std::strtoull(argv[1], nullptr, 10)});
+    }
+    if (argc > 2) {
+        lookups = std::max(std::size_t{1}, std::size_t{std::strtoull(argv[2], nullptr, 10)});
+    }
+
+    RunBackend("compare", kCompareMatch, max_threads, lookups);
+    RunBackend("trie", kTrieMatch, max_threads, lookups);
+    RunBackend("art", kArtMatch, max_threads, lookups);
+    RunBackend("dawg", kDawgMatch, max_threads, lookups);
+    RunBackend("positions", kPositionsMatch, max_threads, lookups);
+    RunBackend("packed", kPackedMatch, max_threads, lookups);
+    RunBackend("fixed", kFixedMatch, max_threads, lookups);
+    RunBackend("eytzinger", kEytzingerMatch, max_threads, lookups);
+}